@@ -0,0 +1,220 @@
+# copyright 2025 swaroop.
+
+# --------------------------------------
+# add_shader_demo(<target>
+#         SOURCES <cpp/h files>...
+#         SHADERS <glsl files>...
+#         [OPT none|size|performance])
+#
+# static library for one demo plus build-time spir-v for its shaders, two variants per shader:
+#   opt   the demo's OPT pipeline (VK_SHADER_OPT_LEVEL when not given), packed into shaders.pack
+#   none  plain glslang output, packed into shaders.none.pack for vk_shader_bench --compare-opt
+#
+# outputs keep their source-relative path (shader_repo/<demo>/shaders/<file>.spv) under
+# ${CMAKE_BINARY_DIR}/spirv/<variant>, which is the name ShaderProgramDesc and the pack use
+# every shader also lands in shader_variants.json, see write_shader_variants()
+
+set(VK_SHADER_OPT_LEVEL "performance" CACHE STRING "default spirv-opt pipeline for demo shaders")
+set_property(CACHE VK_SHADER_OPT_LEVEL PROPERTY STRINGS none size performance)
+
+# glslang's standalone compiler, renamed from glslangValidator in newer releases
+if (TARGET glslang-standalone)
+    set(VK_SHADER_GLSLANG glslang-standalone)
+else ()
+    set(VK_SHADER_GLSLANG glslangValidator)
+endif ()
+
+# spirv-opt comes with SPIRV-Tools when glslang builds it (ENABLE_OPT), otherwise from the vulkan sdk
+if (TARGET spirv-opt)
+    set(VK_SHADER_SPIRV_OPT spirv-opt)
+else ()
+    find_program(VK_SHADER_SPIRV_OPT spirv-opt HINTS $ENV{VULKAN_SDK}/bin $ENV{VULKAN_SDK}/Bin)
+endif ()
+
+if (NOT VK_SHADER_SPIRV_OPT)
+    message(STATUS "spirv-opt not found, demo shaders are built without optimization")
+endif ()
+
+set(VK_SHADER_SPIRV_DIR ${CMAKE_BINARY_DIR}/spirv)
+
+function(add_shader_demo TARGET)
+    cmake_parse_arguments(DEMO "" "OPT" "SOURCES;SHADERS" ${ARGN})
+
+    add_library(${TARGET} STATIC ${DEMO_SOURCES})
+
+    target_include_directories(${TARGET} PUBLIC
+            ${CMAKE_CURRENT_SOURCE_DIR}
+            ${CMAKE_CURRENT_SOURCE_DIR}/layers
+    )
+
+    target_link_libraries(${TARGET} PUBLIC
+            shader_engine_interface
+            select_menu
+            Vulkan::Vulkan
+            imgui
+    )
+
+    compile_shader_spirv(${TARGET} "${DEMO_OPT}" ${DEMO_SHADERS})
+    add_dependencies(${TARGET} ${TARGET}_spirv)
+endfunction()
+
+# --------------------------------------
+# add_engine_shaders(SHADERS <glsl files>... [OPT none|size|performance])
+# shaders the engine itself draws with (upscaling and the like), packed alongside the demos'
+function(add_engine_shaders)
+    cmake_parse_arguments(ENGINE "" "OPT" "SHADERS" ${ARGN})
+    compile_shader_spirv(vk_shader_engine_shaders "${ENGINE_OPT}" ${ENGINE_SHADERS})
+endfunction()
+
+# --------------------------------------
+# compile_shader_spirv(<target> <opt> <glsl files>...)
+# both spir-v variants of every shader behind a <target>_spirv custom target, see add_shader_demo()
+function(compile_shader_spirv TARGET OPT)
+    if (NOT OPT)
+        set(OPT ${VK_SHADER_OPT_LEVEL})
+    endif ()
+
+    if (OPT STREQUAL "size")
+        set(OPT_FLAGS -Os)
+    elseif (OPT STREQUAL "performance")
+        set(OPT_FLAGS -O)
+    elseif (NOT OPT STREQUAL "none")
+        message(FATAL_ERROR "${TARGET}: unknown OPT '${OPT}', expected none, size or performance")
+    endif ()
+
+    if (NOT VK_SHADER_SPIRV_OPT)
+        set(OPT none)
+    endif ()
+
+    set(OUTPUTS "")
+    foreach (SHADER ${ARGN})
+        get_filename_component(SOURCE ${SHADER} ABSOLUTE)
+        file(RELATIVE_PATH NAME ${CMAKE_SOURCE_DIR} ${SOURCE})
+        set(NONE_OUT ${VK_SHADER_SPIRV_DIR}/none/${NAME}.spv)
+        set(OPT_OUT ${VK_SHADER_SPIRV_DIR}/opt/${NAME}.spv)
+
+        get_filename_component(NONE_DIR ${NONE_OUT} DIRECTORY)
+        get_filename_component(OPT_DIR ${OPT_OUT} DIRECTORY)
+        file(MAKE_DIRECTORY ${NONE_DIR} ${OPT_DIR})
+
+        # compute shaders target vulkan 1.1 (spir-v 1.3) for subgroup operations, the rest stays loadable on 1.0
+        get_filename_component(EXT ${SOURCE} LAST_EXT)
+        if (EXT STREQUAL ".comp")
+            set(TARGET_ENV --target-env vulkan1.1)
+        else ()
+            set(TARGET_ENV "")
+        endif ()
+
+        add_custom_command(
+                OUTPUT ${NONE_OUT}
+                COMMAND ${VK_SHADER_GLSLANG} -V ${TARGET_ENV} ${SOURCE} -o ${NONE_OUT}
+                DEPENDS ${SOURCE}
+                COMMENT "Compiling shader ${NAME}"
+        )
+
+        if (NOT OPT STREQUAL "none")
+            add_custom_command(
+                    OUTPUT ${OPT_OUT}
+                    COMMAND ${VK_SHADER_SPIRV_OPT} ${OPT_FLAGS} ${NONE_OUT} -o ${OPT_OUT}
+                    DEPENDS ${NONE_OUT}
+                    COMMENT "Optimizing shader ${NAME} (${OPT})"
+            )
+        else ()
+            add_custom_command(
+                    OUTPUT ${OPT_OUT}
+                    COMMAND ${CMAKE_COMMAND} -E copy ${NONE_OUT} ${OPT_OUT}
+                    DEPENDS ${NONE_OUT}
+            )
+        endif ()
+
+        list(APPEND OUTPUTS ${NONE_OUT} ${OPT_OUT})
+        set_property(GLOBAL APPEND PROPERTY VK_SHADER_SPIRV_OPT_FILES ${OPT_OUT})
+        set_property(GLOBAL APPEND PROPERTY VK_SHADER_SPIRV_NONE_FILES ${NONE_OUT})
+        set_property(GLOBAL APPEND PROPERTY VK_SHADER_VARIANTS "${TARGET}|${OPT}|${NAME}")
+    endforeach ()
+
+    # custom command outputs only get build rules inside the directory that declares them
+    add_custom_target(${TARGET}_spirv DEPENDS ${OUTPUTS})
+    set_property(GLOBAL APPEND PROPERTY VK_SHADER_SPIRV_TARGETS ${TARGET}_spirv)
+endfunction()
+
+# --------------------------------------
+# add_shader_packs()
+# one pack per variant from every add_shader_demo() so far, copied next to each of the given executables
+function(add_shader_packs)
+    get_property(SPIRV_TARGETS GLOBAL PROPERTY VK_SHADER_SPIRV_TARGETS)
+
+    set(PACKS "")
+    foreach (VARIANT opt none)
+        string(TOUPPER ${VARIANT} UPPER)
+        get_property(FILES GLOBAL PROPERTY VK_SHADER_SPIRV_${UPPER}_FILES)
+
+        if (VARIANT STREQUAL "opt")
+            set(PACK ${CMAKE_BINARY_DIR}/shaders.pack)
+        else ()
+            set(PACK ${CMAKE_BINARY_DIR}/shaders.${VARIANT}.pack)
+        endif ()
+
+        add_custom_command(
+                OUTPUT ${PACK}
+                COMMAND vk_shader_pack ${PACK} ${VK_SHADER_SPIRV_DIR}/${VARIANT} ${FILES}
+                DEPENDS vk_shader_pack ${SPIRV_TARGETS} ${FILES}
+                COMMENT "Packing shaders (${VARIANT})"
+        )
+        list(APPEND PACKS ${PACK})
+    endforeach ()
+
+    add_custom_target(shader_pack ALL DEPENDS ${PACKS})
+    write_shader_variants(${CMAKE_BINARY_DIR}/shader_variants.json)
+
+    # the engine looks for the pack next to its executable
+    foreach (TARGET ${ARGN})
+        add_dependencies(${TARGET} shader_pack)
+        add_custom_command(TARGET ${TARGET} POST_BUILD
+                COMMAND ${CMAKE_COMMAND} -E copy_if_different ${PACKS} ${CMAKE_BINARY_DIR}/shader_variants.json
+                        $<TARGET_FILE_DIR:${TARGET}>
+        )
+    endforeach ()
+endfunction()
+
+# --------------------------------------
+# write_shader_variants(<path>)
+# which demo built which shader with which pipeline, and where each variant ended up
+function(write_shader_variants PATH)
+    get_property(VARIANTS GLOBAL PROPERTY VK_SHADER_VARIANTS)
+
+    if (VK_SHADER_SPIRV_OPT)
+        set(HAS_OPT true)
+    else ()
+        set(HAS_OPT false)
+    endif ()
+
+    set(JSON "{\n  \"spirv_opt\": ${HAS_OPT},\n  \"default_opt\": \"${VK_SHADER_OPT_LEVEL}\",\n")
+    string(APPEND JSON "  \"packs\": { \"opt\": \"shaders.pack\", \"none\": \"shaders.none.pack\" },\n")
+    string(APPEND JSON "  \"shaders\": [\n")
+
+    list(LENGTH VARIANTS COUNT)
+    set(INDEX 0)
+    foreach (ENTRY ${VARIANTS})
+        string(REPLACE "|" ";" FIELDS ${ENTRY})
+        list(GET FIELDS 0 DEMO)
+        list(GET FIELDS 1 OPT)
+        list(GET FIELDS 2 NAME)
+        get_filename_component(EXT ${NAME} LAST_EXT)
+        string(SUBSTRING ${EXT} 1 -1 STAGE)
+
+        math(EXPR INDEX "${INDEX} + 1")
+        if (INDEX LESS COUNT)
+            set(SEP ",")
+        else ()
+            set(SEP "")
+        endif ()
+
+        string(APPEND JSON "    { \"demo\": \"${DEMO}\", \"source\": \"${NAME}\", \"stage\": \"${STAGE}\", \"opt\": \"${OPT}\", "
+                           "\"spv\": \"${NAME}.spv\", "
+                           "\"variants\": { \"opt\": \"spirv/opt/${NAME}.spv\", \"none\": \"spirv/none/${NAME}.spv\" } }${SEP}\n")
+    endforeach ()
+    string(APPEND JSON "  ]\n}\n")
+
+    file(WRITE ${PATH} ${JSON})
+endfunction()
@@ -0,0 +1,53 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_BENCH_REPORT_H
+#define VK_SHADER_EXP_BENCH_REPORT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BenchStats {
+    double mean = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+
+    static BenchStats fromSamples(std::vector<double> samples);
+};
+
+// one demo at one resolution
+struct BenchResult {
+    std::string demo;
+    std::string variant; // shader pack variant (opt / none) in --compare-opt runs, empty otherwise
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t frames = 0;
+
+    BenchStats cpuMs;
+    BenchStats gpuMs;
+    bool hasGpu = false;
+
+    // pixels shaded per second, from wall clock and from gpu time respectively
+    double mpixPerSec = 0.0;
+    double gpuMpixPerSec = 0.0;
+};
+
+class BenchReport {
+public:
+    void add(const BenchResult& result) { results.push_back(result); }
+    const std::vector<BenchResult>& getResults() const { return results; }
+
+    void print() const;
+    // per demo and resolution, `candidate` against `baseline` variant, gpu time when both have it
+    void printComparison(const std::string& baseline, const std::string& candidate) const;
+    bool writeJson(const std::string& path) const;
+    bool writeCsv(const std::string& path) const;
+
+private:
+    std::vector<BenchResult> results;
+};
+
+#endif // VK_SHADER_EXP_BENCH_REPORT_H
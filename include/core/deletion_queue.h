@@ -0,0 +1,43 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_DELETION_QUEUE_H
+#define VK_SHADER_EXP_DELETION_QUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/*
+ * gpu objects are not destroyed when their owner lets go of them, they are retired against the last
+ * frame that may still reference them and destroyed once the engine has seen that frame's fence signal
+ *
+ * frame values are the engine's 1-based submit counter, which only grows, so entries are kept in order
+ */
+class DeletionQueue {
+public:
+    DeletionQueue() = default;
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+    void retire(uint64_t lastUsedFrame, std::function<void()> deleter);
+
+    // destroys everything retired against a frame <= completedFrame
+    void collect(uint64_t completedFrame);
+
+    // destroys everything, only valid once the device is idle
+    void flush();
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        uint64_t frame;
+        std::function<void()> deleter;
+    };
+
+    mutable std::mutex mutex;
+    std::deque<Entry> entries;
+};
+
+#endif // VK_SHADER_EXP_DELETION_QUEUE_H
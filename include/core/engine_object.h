@@ -11,6 +11,7 @@
 class Engine;
 class Viewport;
 class LayerComponent;
+class RenderGraph;
 
 class EngineObject {
 public:
@@ -27,10 +28,16 @@ public:
     virtual void popLayer(LayerComponent* layer);
 
     virtual void update(float deltaTime);
+    virtual void buildGraph(RenderGraph& graph);
+    // not called once a layer records in parallel or replays a cached recording, the engine walks getLayers() itself then
     virtual void render(VkCommandBuffer cmd);
 
     Engine* getEngine() const;
     Viewport& getViewport() const;
+    const std::vector<LayerComponent*>& getLayers() const { return layerStack; }
+    bool hasParallelLayers() const;
+    // any layer replaying a cached recording, see LayerComponent::getRecordingKey()
+    bool hasCachedLayers() const;
     std::string getName() const;
 
 protected:
@@ -0,0 +1,108 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_GPU_ALLOCATOR_H
+#define VK_SHADER_EXP_GPU_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct GpuMemoryBlock;
+
+// a range of device memory handed out by the GpuAllocator, plain value so it can be captured by deleters
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; // non-null for host visible memory, already offset
+    uint32_t memoryType = 0;
+
+    // allocator bookkeeping, null block means the allocation has its own VkDeviceMemory
+    GpuMemoryBlock* block = nullptr;
+    uint32_t level = 0;
+
+    explicit operator bool() const { return memory != VK_NULL_HANDLE; }
+};
+
+/*
+ * engine-owned device memory allocator
+ *
+ * memory is reserved in large blocks per memory type and split with a buddy allocator, so attaching a layer
+ * costs a free list pop instead of a vkAllocateMemory and the device allocation count stays in the tens
+ * host visible blocks are mapped once for their whole lifetime
+ *
+ * buffers and optimal images never share a block, which keeps bufferImageGranularity out of the picture
+ * anything bigger than half a block gets a dedicated allocation
+ */
+class GpuAllocator {
+public:
+    enum class Kind : uint32_t { Buffer = 0, Image = 1 };
+
+    struct Stats {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedCount = 0;
+        uint32_t allocationCount = 0;
+        uint32_t peakDeviceAllocations = 0; // what maxMemoryAllocationCount is checked against
+        VkDeviceSize reservedBytes = 0;     // sum of every VkDeviceMemory we own
+        VkDeviceSize usedBytes = 0;         // handed out, including buddy rounding
+    };
+
+    // out of line, GpuMemoryBlock is only complete in the .cpp
+    GpuAllocator();
+    ~GpuAllocator();
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    void init(VkPhysicalDevice gpu, VkDevice deviceRef);
+    void shutdown();
+
+    // throws when no memory type matching `required` has room left
+    // `preferred` flags are tried first and dropped if nothing matches them
+    GpuAllocation allocate(const VkMemoryRequirements& reqs, VkMemoryPropertyFlags required, Kind kind,
+                           VkMemoryPropertyFlags preferred = 0);
+    void free(const GpuAllocation& allocation);
+
+    // create + allocate + bind in one go, throws and cleans up on failure
+    void createBuffer(const VkBufferCreateInfo& info, VkMemoryPropertyFlags required,
+                      VkBuffer& buffer, GpuAllocation& allocation, VkMemoryPropertyFlags preferred = 0);
+    void createImage(const VkImageCreateInfo& info, VkMemoryPropertyFlags required,
+                     VkImage& image, GpuAllocation& allocation, VkMemoryPropertyFlags preferred = 0);
+    void destroyBuffer(VkBuffer buffer, const GpuAllocation& allocation);
+    void destroyImage(VkImage image, const GpuAllocation& allocation);
+
+    // only needed for host visible memory without HOST_COHERENT
+    void flush(const GpuAllocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+    uint32_t findMemoryType(uint32_t filter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0) const;
+    const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memoryProps; }
+    bool isCoherent(const GpuAllocation& allocation) const;
+
+    Stats getStats() const;
+    void printStats() const;
+
+private:
+    struct Pool {
+        std::vector<std::unique_ptr<GpuMemoryBlock>> blocks;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProps{};
+    VkDeviceSize nonCoherentAtomSize = 1;
+
+    mutable std::mutex mutex;
+    std::vector<Pool> pools; // memoryType * 2 + kind
+    std::vector<VkDeviceSize> blockSizes; // per memory type, scaled down for small heaps
+    Stats stats;
+
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;
+    static constexpr VkDeviceSize MIN_BLOCK_SIZE = 1ull << 20;
+    static constexpr VkDeviceSize MIN_ALLOCATION = 256;
+
+    bool tryAllocate(uint32_t memoryType, Kind kind, VkDeviceSize size, VkDeviceSize alignment, GpuAllocation& out);
+    bool allocateDedicated(uint32_t memoryType, VkDeviceSize size, GpuAllocation& out);
+    GpuMemoryBlock* createBlock(uint32_t memoryType, Kind kind);
+};
+
+#endif // VK_SHADER_EXP_GPU_ALLOCATOR_H
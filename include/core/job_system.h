@@ -0,0 +1,108 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_JOB_SYSTEM_H
+#define VK_SHADER_EXP_JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * work-stealing thread pool for cpu work that doesn't have to happen on the frame thread (io, simulation, builds)
+ *
+ * every worker has its own deque, it pushes and pops at the back and steals from the front of the others';
+ * jobs submitted from outside the pool go to a shared queue the workers drain first
+ * jobs can depend on other jobs and only start once all of those finished, which is enough for task graphs
+ * main-thread jobs (anything touching imgui, the window or the layer stack) are run by the engine once a frame,
+ * before layers update
+ *
+ * wait() and parallelFor() run other jobs on the calling thread instead of blocking it
+ * a job's exception is rethrown by wait()
+ */
+class JobSystem {
+public:
+    struct Job;
+    using Handle = std::shared_ptr<Job>;
+
+    JobSystem() = default;
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /*
+     * workerCount 0 leaves one core to the frame thread
+     * worker i is pinned to affinity[i % size], an empty list leaves scheduling to the os
+     * the calling thread becomes the main thread
+     */
+    void init(uint32_t workerCount = 0, const std::vector<uint32_t>& affinity = {});
+    // finishes everything submitted, main-thread jobs included, then joins the workers
+    void shutdown();
+
+    // dependencies may be null or already finished
+    Handle submit(std::function<void()> fn, const std::vector<Handle>& dependencies = {});
+    Handle submitMainThread(std::function<void()> fn, const std::vector<Handle>& dependencies = {});
+    // no work of its own, finishes once all of `jobs` have, for joining a fan-out
+    Handle when(const std::vector<Handle>& jobs) { return submit(nullptr, jobs); }
+
+    /*
+     * fn(begin, end) over [0, count) in chunks of `grain`, returns once all of them ran
+     * grain 0 splits the range into a few chunks per thread
+     */
+    void parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& fn);
+
+    // waiting on a main-thread job from a worker blocks that worker until the next frame runs it
+    void wait(const Handle& job);
+    // main thread only, a worker would be waiting on itself
+    void waitIdle();
+    static bool isDone(const Handle& job);
+
+    // main thread only, jobs submitted while these run are left for the next call
+    void runMainThreadJobs();
+
+    uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+    // index of the calling worker, getWorkerCount() on any thread outside the pool
+    uint32_t getCurrentWorker() const;
+    bool isMainThread() const { return std::this_thread::get_id() == mainThread; }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Handle> jobs;
+    };
+
+    // one per worker, the last one takes submissions from every other thread
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::thread::id mainThread;
+
+    std::mutex mainMutex;
+    std::deque<Handle> mainJobs;
+
+    std::atomic<uint32_t> queued{0};   // sitting in a worker queue
+    std::atomic<uint32_t> pending{0};  // submitted and not finished, main-thread and blocked ones included
+    std::atomic<uint32_t> waiters{0};
+    std::atomic<bool> stopping{false};
+
+    // sleeping workers and waiting threads, state changes are published under it so no wakeup is lost
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable stateChanged;
+
+    Handle create(std::function<void()> fn, bool onMainThread, const std::vector<Handle>& dependencies);
+    void schedule(const Handle& job);
+    void execute(const Handle& job);
+    void workerLoop(uint32_t index);
+    // a job for the calling thread, its own queue first, then the shared one, then the other workers'
+    Handle take();
+    // a worker job, or on the main thread a main-thread job when there is none
+    bool runOne();
+    bool hasMainJobs();
+    void notifyWaiters();
+};
+
+#endif // VK_SHADER_EXP_JOB_SYSTEM_H
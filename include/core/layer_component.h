@@ -3,12 +3,14 @@
 #ifndef VK_SHADER_EXP_LAYER_COMPONENT_H
 #define VK_SHADER_EXP_LAYER_COMPONENT_H
 
+#include <cstdint>
 #include <string>
 
 #include "vulkan/vulkan_core.h"
 
 class EngineObject;
 class Engine;
+class RenderGraph;
 
 class LayerComponent {
 public:
@@ -17,10 +19,35 @@ public:
 
     virtual void onAttach() {}
     virtual void onDetach() {}
+    // may hand work to getEngine()->getJobSystem(), the engine waits for it before the layer's object is deleted
     virtual void onUpdate(float deltaTime) {}
+    /*
+     * fixed-step mode only (EngineConfig::fixedStepSimulation), called on the simulation thread every `step` seconds,
+     * `time` is the simulated time after this step
+     * runs concurrently with onUpdate / onRender, hand state over through a SimulationState
+     */
+    virtual void onSimulate(double step, double time) {}
+    // declare offscreen passes for this frame, runs after onUpdate and before anything is recorded
+    virtual void onBuildGraph(RenderGraph& graph) {}
     virtual void onRender(VkCommandBuffer cmd) {}
 
+    /*
+     * nonzero when onRender records the same commands frame after frame, for as long as the key stays the same
+     * the engine replays what it recorded for the frame slot instead of calling onRender
+     * anything baked into the commands belongs in the key (pipeline, extent, descriptor sets, dynamic offsets),
+     * per-frame data has to reach the gpu some other way, e.g. UniformRing::writeStatic() from onBuildGraph
+     */
+    virtual uint64_t getRecordingKey() const { return 0; }
+
     void setEngine(Engine* engineRef);
+
+    /*
+     * record onRender into a secondary command buffer on one of the engine's recording threads
+     * only for layers whose onRender touches nothing but thread-safe engine state (uniform ring, graph sets,
+     * pipeline store lookups) and their own members, it may run alongside other layers' onRender
+     */
+    void setParallelRecording(bool enabled) { parallelRecording = enabled; }
+    bool isParallelRecording() const { return parallelRecording; }
     
     Engine* getEngine() const;
     EngineObject* getParent() const;
@@ -30,6 +57,7 @@ protected:
     Engine* engine = nullptr;
     EngineObject* parent = nullptr;
     std::string debugName = "RenderLayer";
+    bool parallelRecording = false;
 };
 
 #endif // VK_SHADER_EXP_LAYER_COMPONENT_H
\ No newline at end of file
@@ -0,0 +1,55 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_LAYOUT_CACHE_H
+#define VK_SHADER_EXP_LAYOUT_CACHE_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * deduplicates descriptor set layouts and pipeline layouts by their contents
+ *
+ * programs declaring the same resources end up with the same handles, so descriptor sets stay compatible
+ * between them and switching pipelines doesn't disturb sets that are already bound
+ * every handle lives until shutdown(); safe to call from pipeline build workers
+ */
+class LayoutCache {
+public:
+    LayoutCache() = default;
+    LayoutCache(const LayoutCache&) = delete;
+    LayoutCache& operator=(const LayoutCache&) = delete;
+
+    void init(VkDevice deviceRef);
+    void shutdown();
+
+    // bindings in any order, they are sorted by binding number before hashing
+    VkDescriptorSetLayout getSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings);
+    VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                       const std::vector<VkPushConstantRange>& pushRanges);
+
+    size_t setLayoutCount() const;
+    size_t pipelineLayoutCount() const;
+
+private:
+    struct SetLayoutEntry {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        VkDescriptorSetLayout layout;
+    };
+
+    struct PipelineLayoutEntry {
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        std::vector<VkPushConstantRange> pushRanges;
+        VkPipelineLayout layout;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+
+    mutable std::mutex mutex;
+    std::unordered_multimap<uint64_t, SetLayoutEntry> setLayouts;
+    std::unordered_multimap<uint64_t, PipelineLayoutEntry> pipelineLayouts;
+};
+
+#endif // VK_SHADER_EXP_LAYOUT_CACHE_H
@@ -0,0 +1,84 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_PIPELINE_CACHE_H
+#define VK_SHADER_EXP_PIPELINE_CACHE_H
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class JobSystem;
+
+/*
+ * engine-wide VkPipelineCache backed by a file on disk
+ *
+ * the file is only trusted when vendor, device, driver version and pipelineCacheUUID all match
+ * alongside the driver blob it keeps the keys (spir-v + target hashes) of every pipeline built through it
+ *
+ * hits and misses are what the driver reports through VK_EXT_pipeline_creation_feedback, a blob it rejected or
+ * evicted from shows up as misses; pipelines built without that extension only count as unreported
+ */
+class PipelineCache {
+public:
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t unreported = 0; // no valid creation feedback
+        double creationMs = 0.0; // total time spent inside vkCreate*Pipelines
+    };
+
+    // filled in by the driver once chained into a pipeline create info with chainFeedback()
+    struct Feedback {
+        VkPipelineCreationFeedback pipeline{};
+        VkPipelineCreationFeedbackCreateInfo info{};
+    };
+
+    PipelineCache() = default;
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    // empty path keeps the cache in memory only
+    // `creationFeedback` when VK_EXT_pipeline_creation_feedback is enabled on the device
+    void init(VkDevice deviceRef, VkPhysicalDevice gpu, const std::string& path, bool creationFeedback = false);
+    void shutdown();
+
+    VkPipelineCache get() const { return cache; }
+
+    // `feedback` in front of `next` where the driver reports creation feedback, `next` as is otherwise
+    const void* chainFeedback(Feedback& feedback, const void* next) const;
+
+    // call after creating a pipeline with this cache, returns true when the driver served it from the cache
+    // safe to call from pipeline build workers
+    bool recordPipeline(uint64_t key, double creationMs, const Feedback& feedback);
+
+    // writes to disk on a `jobs` worker when something changed and the save interval has passed
+    void tick(double nowSeconds, JobSystem& jobs);
+    // blocking, not while a tick()'s save may still be running
+    bool save();
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties deviceProps{};
+    std::string filePath;
+    bool feedbackSupported = false;
+
+    std::mutex mutex; // guards knownKeys and stats
+    std::unordered_set<uint64_t> knownKeys;
+    Stats stats;
+    std::atomic<bool> dirty{false};
+    std::atomic<bool> saving{false}; // a tick()'s save job is queued or running
+    double lastSaveTime = -1.0;
+
+    static constexpr double SAVE_INTERVAL_SECONDS = 30.0;
+
+    bool load(std::vector<char>& blob);
+};
+
+#endif // VK_SHADER_EXP_PIPELINE_CACHE_H
@@ -0,0 +1,201 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_PIPELINE_STORE_H
+#define VK_SHADER_EXP_PIPELINE_STORE_H
+
+#include <core/layout_cache.h>
+#include <core/pipeline_cache.h>
+#include <util/spirv_reflect.h>
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Engine;
+
+// the spir-v files a shader layer is built from, the two stages of a fullscreen triangle or a single compute shader
+struct ShaderProgramDesc {
+    std::string vertPath;
+    std::string fragPath;
+    // undefined draws into the engine's target, anything else into a render graph image of that format
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    // set instead of vert / frag for a compute pipeline
+    std::string compPath;
+
+    // specialization constants by constant_id or by name, constants the shader doesn't declare are ignored
+    struct SpecValue {
+        uint32_t id = 0;
+        uint32_t value = 0; // bit pattern, floats and bools included
+        std::string name;   // looked up in the reflected spir-v when set, id is ignored then
+
+        static SpecValue named(const std::string& name, float v) { uint32_t bits; memcpy(&bits, &v, 4); return { 0, bits, name }; }
+        static SpecValue named(const std::string& name, int32_t v) { return { 0, static_cast<uint32_t>(v), name }; }
+        static SpecValue named(const std::string& name, bool v) { return { 0, v ? 1u : 0u, name }; }
+    };
+    std::vector<SpecValue> specialization;
+
+    bool isCompute() const { return !compPath.empty(); }
+
+    std::string key() const {
+        std::string k = isCompute() ? "comp|" + compPath : vertPath + "|" + fragPath;
+        if (colorFormat != VK_FORMAT_UNDEFINED) k += "|" + std::to_string(static_cast<int>(colorFormat));
+        for (const auto& spec : specialization) {
+            k += "|" + (spec.name.empty() ? std::to_string(spec.id) : spec.name) + "=" + std::to_string(spec.value);
+        }
+        return k;
+    }
+};
+
+/*
+ * engine-owned home of every fullscreen shader and compute pipeline
+ *
+ * pipelines outlive the layers using them, so switching back to a demo costs a map lookup
+ * prewarm() builds pipelines on a few of the engine's JobSystem workers ahead of time; acquire() hands out a finished
+ * one, waits for one that is mid-build, or builds it right there as a last resort
+ *
+ * layouts come from reflecting the spir-v stages, with a few conventions on top:
+ * - every binding and the push constant range are visible to every stage (UNIFORM_STAGES),
+ *   so graphics and compute programs with the same resources share their layouts
+ * - a uniform block at set 0 binding 0 is made dynamic, it is fed by the engine's UniformRing
+ * - identical layouts are shared through the LayoutCache
+ *
+ * every distinct set of specialization values is a pipeline of its own under its own key, so switching
+ * between variants of a program that were built before is a lookup as well
+ *
+ * with VK_EXT_graphics_pipeline_library (Engine::hasPipelineLibraries()) fullscreen pipelines are linked from
+ * parts shared between programs plus a fragment shader library of their own, see linkPipeline()
+ *
+ * with VK_KHR_dynamic_rendering (Engine::hasDynamicRendering()) pipelines are built against their color format
+ * instead of a render pass, nothing about them depends on the swapchain
+ *
+ * spir-v comes from, in order: a hot reload override, the engine's ShaderPack, the loose file on disk
+ */
+class PipelineStore {
+public:
+    struct Program {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSetLayout> setLayouts; // owned by the LayoutCache, index = set number
+        ShaderReflection reflection;                   // all stages merged
+        uint32_t generation = 0;                       // bumped on every hot reload swap
+    };
+
+    PipelineStore() = default;
+    PipelineStore(const PipelineStore&) = delete;
+    PipelineStore& operator=(const PipelineStore&) = delete;
+
+    void init(Engine* engineRef);
+    void shutdown();
+
+    // throws when the program failed to build, same as building it inline would
+    const Program* acquire(const ShaderProgramDesc& desc);
+
+    // the engine's JobSystem has to be up
+    void prewarm(const std::vector<ShaderProgramDesc>& programs);
+    /*
+     * builds in progress finish, queued ones wait for resumePrewarm() (acquire() still builds them inline)
+     * for JobSystem::waitIdle() callers that only mean to wait for layers' jobs, not the whole prewarm backlog
+     */
+    void pausePrewarm();
+    void resumePrewarm();
+    uint32_t getPrewarmTotal() const { return prewarmTotal.load(); }
+    uint32_t getPrewarmDone() const { return prewarmDone.load(); }
+
+    /*
+     * hot reload, called off the render thread: from now on `spvPath` loads `code` instead of the file,
+     * and every built program using it is rebuilt right here
+     * returns false with the error when a rebuild failed, the old pipelines stay in use then
+     */
+    bool reload(const std::string& spvPath, std::vector<uint32_t> code, std::string& error);
+
+    // render thread, between frames: swaps rebuilt programs in and retires the old pipelines
+    void applyReloads();
+
+    // set 0 of a program that only declares its uniform block, what the UniformRing's descriptor set is allocated with
+    VkDescriptorSetLayout getDefaultSetLayout() const { return defaultSetLayout; }
+    LayoutCache& getLayoutCache() { return layouts; }
+
+    static constexpr VkShaderStageFlags UNIFORM_STAGES =
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+    static constexpr uint32_t PUSH_CONSTANT_SIZE = 128; // the spec minimum for maxPushConstantsSize
+
+private:
+    enum class State { Queued, Building, Ready, Failed };
+
+    // either points into the engine's ShaderPack or at `owned`, valid until it goes out of scope
+    struct SpirvCode {
+        const uint32_t* words = nullptr;
+        size_t size = 0; // bytes
+        uint64_t hash = 0;
+        std::vector<uint32_t> owned;
+    };
+
+    struct Entry {
+        ShaderProgramDesc desc;
+        Program program;
+        State state = State::Queued;
+        bool prewarmed = false;
+        std::string error;
+    };
+
+    Engine* engine = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+
+    LayoutCache layouts;
+    VkDescriptorSetLayout defaultSetLayout = VK_NULL_HANDLE;
+
+    std::mutex mutex;
+    std::condition_variable entryFinished;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> entries;
+    std::deque<Entry*> queue;
+    uint32_t builders = 0; // prewarm jobs on the JobSystem
+    bool paused = false;
+
+    // hot reload state, under the same mutex
+    std::unordered_map<std::string, std::vector<uint32_t>> spirvOverrides;
+    std::vector<std::pair<Entry*, Program>> pendingSwaps;
+
+    // graphics pipeline library parts, kept until shutdown; pipelines linked from them don't need them afterwards,
+    // but the next program with the same vertex shader and render pass does
+    bool libraries = false;
+    std::mutex libraryMutex;
+    std::unordered_map<uint64_t, VkPipeline> sharedLibraries;
+
+    std::atomic<uint32_t> prewarmTotal{0};
+    std::atomic<uint32_t> prewarmDone{0};
+
+    // submits prewarm jobs up to the limit, each builds queued entries until there are none left
+    void startBuilders();
+    void drain();
+    // runs without the lock held, only touches the entry it was handed
+    void build(Entry& entry);
+    struct Specialization;
+    struct FullscreenState;
+
+    VkPipeline createPipeline(const ShaderProgramDesc& desc, Program& program);
+    VkPipeline createComputePipeline(const ShaderProgramDesc& desc, Program& program);
+    VkShaderModule createModule(const SpirvCode& code);
+    // renderPass VK_NULL_HANDLE builds for dynamic rendering into colorFormat
+    // `feedback` reports on the part compiled for this program alone
+    VkPipeline createMonolithic(const SpirvCode& vert, const SpirvCode& frag, const Specialization& spec,
+                                VkPipelineLayout layout, VkRenderPass renderPass, VkFormat colorFormat,
+                                PipelineCache::Feedback& feedback);
+    VkPipeline linkPipeline(const SpirvCode& vert, const SpirvCode& frag, const Specialization& vertSpec,
+                            const Specialization& fragSpec, VkPipelineLayout layout, VkRenderPass renderPass,
+                            VkFormat colorFormat, PipelineCache::Feedback& feedback);
+    VkPipeline createLibrary(VkGraphicsPipelineLibraryFlagsEXT parts, VkGraphicsPipelineCreateInfo pci);
+    // the library under `key`, created by `create` the first time, thread safe
+    VkPipeline sharedLibrary(uint64_t key, const std::function<VkPipeline()>& create);
+    void createLayout(Program& program);
+    SpirvCode loadSpirv(const std::string& path);
+};
+
+#endif // VK_SHADER_EXP_PIPELINE_STORE_H
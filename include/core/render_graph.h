@@ -0,0 +1,204 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_RENDER_GRAPH_H
+#define VK_SHADER_EXP_RENDER_GRAPH_H
+
+#include <core/gpu_allocator.h>
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Engine;
+
+/*
+ * per-frame graph of passes over images and buffers
+ *
+ * every frame layers declare passes and what they read and write (LayerComponent::onBuildGraph),
+ * the engine closes the graph with the backbuffer pass, which is where onRender and imgui draw
+ * compile() then
+ * - drops passes nothing the backbuffer pass depends on reads
+ * - works out the barriers and layout transitions between passes, reads that follow reads share one state
+ * - places transient resources whose lifetimes don't overlap in the same memory
+ *
+ * passes run in declaration order, a pass may only read what an earlier pass (or an import) wrote
+ * transient contents don't survive the frame, import an image to keep it (see ImageState)
+ * the physical resources are kept as long as the declarations don't change, so a steady graph costs no allocations
+ */
+class RenderGraph {
+public:
+    using Resource = uint32_t;
+    static constexpr Resource INVALID_RESOURCE = UINT32_MAX;
+
+    enum class Access : uint32_t {
+        ColorAttachment,     // write, raster pass target
+        FragmentSampled,     // read
+        ComputeSampled,      // read
+        FragmentStorageRead, // read, storage image or buffer
+        ComputeStorageRead,  // read, storage image or buffer
+        ComputeStorageWrite, // write, storage image or buffer
+        UniformRead,         // read, buffers only, vertex + fragment
+        TransferRead,
+        TransferWrite,
+    };
+
+    struct ImageDesc {
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+        uint32_t width = 0;  // 0 follows the render extent
+        uint32_t height = 0;
+        float scale = 1.0f;  // of the render extent, when width / height are 0
+    };
+
+    struct BufferDesc {
+        VkDeviceSize size = 0;
+    };
+
+    // where an imported image was left, the graph starts from it and updates it at compile()
+    struct ImageState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags access = 0;
+    };
+
+    struct PassContext {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VkExtent2D extent{};                   // color attachments for raster passes, the render extent otherwise
+        VkRenderPass renderPass = VK_NULL_HANDLE; // already begun for raster passes, VK_NULL_HANDLE with dynamic rendering
+    };
+
+    class PassBuilder {
+    public:
+        Resource createImage(const std::string& name, const ImageDesc& desc);
+        Resource createBuffer(const std::string& name, const BufferDesc& desc);
+
+        void read(Resource resource, Access access);
+        void write(Resource resource, Access access);
+
+        // color attachments are loaded by default, discarded on their first write of the frame when transient
+        void clear(Resource resource, VkClearColorValue color = {});
+
+        // never culled, for passes whose results leave the graph
+        void setSideEffects() { sideEffects = true; }
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graphRef, uint32_t passIndex) : graph(graphRef), pass(passIndex) {}
+
+        RenderGraph& graph;
+        uint32_t pass;
+        bool sideEffects = false;
+    };
+
+    using SetupFn = std::function<void(PassBuilder&)>;
+    using ExecuteFn = std::function<void(const PassContext&)>;
+
+    struct Stats {
+        uint32_t passCount = 0;
+        uint32_t culledPasses = 0;
+        uint32_t barrierCount = 0;       // image + buffer barriers, execution-only dependencies count as one
+        uint32_t transientImages = 0;
+        uint32_t transientBuffers = 0;
+        VkDeviceSize transientBytes = 0; // what the transients would take on their own
+        VkDeviceSize allocatedBytes = 0; // what they take after aliasing
+        uint32_t rebuilds = 0;           // physical resource sets created so far
+    };
+
+    RenderGraph();
+    ~RenderGraph();
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    void init(Engine* engineRef, uint32_t framesInFlight);
+    void shutdown();
+
+    // drops last frame's declarations, call once the frame slot's fence has been waited on
+    void beginFrame(uint32_t frameIndex, VkExtent2D renderExtent);
+
+    void addPass(const std::string& name, const SetupFn& setup, ExecuteFn execute);
+
+    // bring an image the caller owns into the graph, `state` is read and written back at compile()
+    Resource importImage(const std::string& name, VkImage image, VkImageView view, VkFormat format,
+                         VkExtent2D extent, ImageState* state);
+    // call when retiring an imported view, framebuffers over it are retired along with it
+    // a new view can get the same handle value and would otherwise hit them in the cache
+    void forgetImageView(VkImageView view);
+
+    // something onRender samples, read by the backbuffer pass
+    void sampleInBackbuffer(Resource resource) { backbufferReads.push_back(resource); }
+
+    // engine only: the last pass, draws into the swapchain / offscreen target
+    void addBackbufferPass(ExecuteFn execute);
+
+    void compile();
+    void execute(VkCommandBuffer cmd);
+
+    // valid between compile() and the end of the frame
+    VkImage getImage(Resource resource) const;
+    VkImageView getImageView(Resource resource) const;
+    VkBuffer getBuffer(Resource resource) const;
+    VkExtent2D getExtent(Resource resource) const;
+    VkFormat getFormat(Resource resource) const;
+
+    // from a pool reset every time this frame slot comes around, for sets pointing at graph resources, thread safe
+    VkDescriptorSet allocateSet(VkDescriptorSetLayout layout);
+    VkSampler getLinearSampler() const { return linearSampler; }
+
+    // single color attachment render pass a pipeline drawing into a `format` image is built against, thread safe
+    // only used without dynamic rendering
+    VkRenderPass getCompatibleRenderPass(VkFormat format);
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct ResourceDecl;
+    struct PassDecl;
+    struct PhysicalSet;
+    struct CompiledPass;
+
+    Engine* engine = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t framesInFlight = 0;
+    uint32_t frameIndex = 0;
+    VkExtent2D renderExtent{};
+
+    std::vector<ResourceDecl> resources;
+    std::vector<PassDecl> passes;
+    std::vector<Resource> backbufferReads;
+    std::vector<CompiledPass> compiled;
+
+    std::shared_ptr<PhysicalSet> physical; // shared so a retired set can be captured by its deleter
+    uint64_t physicalSignature = 0;
+
+    // keyed by formats + load / store ops, never destroyed before shutdown
+    std::mutex renderPassMutex;
+    // descriptor pools aren't externally synchronized, allocateSet() may be called from recording threads
+    std::mutex descriptorPoolMutex;
+    std::unordered_map<uint64_t, VkRenderPass> renderPasses;
+
+    struct CachedFramebuffer {
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        uint64_t lastUsed = 0;
+        std::vector<VkImageView> views;
+    };
+    std::unordered_map<uint64_t, CachedFramebuffer> framebuffers;
+    uint64_t frameNumber = 0;
+
+    std::vector<VkDescriptorPool> descriptorPools; // one per frame in flight
+    VkSampler linearSampler = VK_NULL_HANDLE;
+
+    Stats stats;
+
+    Resource addResource(ResourceDecl&& decl);
+    void addUse(uint32_t pass, Resource resource, Access access);
+    std::vector<bool> cull() const;
+    void realize();
+    void buildBarriers(const std::vector<uint32_t>& order);
+    VkRenderPass getRenderPass(const std::vector<VkAttachmentDescription>& attachments);
+    VkFramebuffer getFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView>& views, VkExtent2D extent);
+};
+
+#endif // VK_SHADER_EXP_RENDER_GRAPH_H
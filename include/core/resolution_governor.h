@@ -0,0 +1,50 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_RESOLUTION_GOVERNOR_H
+#define VK_SHADER_EXP_RESOLUTION_GOVERNOR_H
+
+#include <cstdint>
+
+/*
+ * picks the render scale of an expensive fullscreen pass from measured gpu frame time
+ *
+ * frame times are smoothed and only acted on outside a dead band around the budget (the hysteresis),
+ * pixel cost goes with scale^2 so a change aims straight at the budget: scale * sqrt(budget / time)
+ * scaling down happens as soon as the smoothed time is over the band, scaling up only after it stayed under for a while
+ * timings lag behind recording, after a change the governor ignores the frames still rendered at the old scale
+ */
+class ResolutionGovernor {
+public:
+    struct Config {
+        double budgetMs = 12.0;   // gpu frame time to stay under, leaves room under a 60 hz vsync
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+        float hysteresis = 0.1f;  // half the dead band, as a fraction of the budget
+        float step = 0.05f;       // scales are snapped down to multiples of this
+        uint32_t growFrames = 30; // samples under the band before scaling back up
+    };
+
+    ResolutionGovernor() = default;
+    explicit ResolutionGovernor(const Config& config) { setConfig(config); }
+
+    void setConfig(const Config& config);
+
+    // one gpu frame time, `settleFrames` is how many samples until a scale change shows up in them
+    void update(double gpuMs, uint32_t settleFrames);
+
+    float getScale() const { return scale; }
+    double getSmoothedMs() const { return smoothedMs; }
+    const Config& getConfig() const { return config; }
+
+private:
+    Config config;
+    float scale = 1.0f;
+    double smoothedMs = 0.0; // 0 = no samples at the current scale yet
+    uint32_t settle = 0;
+    uint32_t underFrames = 0;
+
+    // moves towards the budget, false when the snapped scale didn't change
+    bool retarget();
+};
+
+#endif // VK_SHADER_EXP_RESOLUTION_GOVERNOR_H
@@ -0,0 +1,117 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_SECONDARY_RECORDER_H
+#define VK_SHADER_EXP_SECONDARY_RECORDER_H
+
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class Engine;
+
+/*
+ * records the backbuffer pass into secondary command buffers, the engine executes them in stack order
+ *
+ * used once a layer opts in (LayerComponent::setParallelRecording): those layers record on the engine's JobSystem
+ * workers, the rest on the render thread into secondaries of their own, a pass executing secondaries can't record inline
+ * every thread has a command pool per frame in flight, reset as a whole when the slot comes around,
+ * so no pool is ever shared between threads and buffers are reused rather than reallocated
+ *
+ * jobs with a cache key are recorded once into a reusable buffer of their frame slot and replayed for as long as
+ * the key stays the same, see LayerComponent::getRecordingKey()
+ */
+class SecondaryRecorder {
+public:
+    // what the secondaries continue, a render pass + framebuffer or (renderPass VK_NULL_HANDLE) dynamic rendering
+    struct Target {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    };
+
+    struct Job {
+        std::function<void(VkCommandBuffer)> record;
+        bool parallel = false; // may run on a worker
+        // nonzero replays what this job index recorded under the same key the last time the frame slot came around,
+        // a different key records again on the render thread
+        uint64_t cacheKey = 0;
+    };
+
+    SecondaryRecorder() = default;
+    SecondaryRecorder(const SecondaryRecorder&) = delete;
+    SecondaryRecorder& operator=(const SecondaryRecorder&) = delete;
+
+    // the engine's JobSystem is up already, at most maxWorkers of its workers record at once, 0 for all of them
+    void init(Engine* engineRef, uint32_t framesInFlight, uint32_t maxWorkers = 0);
+    void shutdown();
+
+    // call once the frame slot's fence has been waited on
+    void beginFrame(uint32_t frameIndex);
+
+    /*
+     * one secondary per job, returned in job order once all of them are recorded
+     * the render thread takes its own jobs first, then helps with what the workers haven't picked up
+     * rethrows the first exception a job threw
+     */
+    std::vector<VkCommandBuffer> record(const Target& target, const std::vector<Job>& jobs);
+
+    uint32_t getWorkerCount() const { return recordingWorkers; }
+    // cached jobs of the last record() that didn't need recording
+    uint32_t getReplayedCount() const { return replayed; }
+
+private:
+    struct Pool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;
+        uint32_t used = 0; // handed out since the last reset
+    };
+
+    Engine* engine = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t workerCount = 0;      // the JobSystem's
+    uint32_t recordingWorkers = 0; // jobs submitted per record() at most
+    uint32_t frameIndex = 0;
+
+    // [frame][thread], thread = JobSystem worker index, the render thread's pool is the last one
+    std::vector<std::vector<Pool>> pools;
+
+    struct Cached {
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        uint64_t key = 0; // 0 until recorded
+    };
+    // per frame, a pool that is never reset as a whole, only used from the render thread
+    struct Cache {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<Cached> entries; // by job index
+    };
+    std::vector<Cache> caches;
+    uint32_t replayed = 0;
+
+    std::mutex mutex;
+    std::condition_variable jobsFinished;
+    std::deque<uint32_t> queue;
+
+    // the record() call in progress, under the mutex
+    const Target* target = nullptr;
+    const std::vector<Job>* jobs = nullptr;
+    std::vector<VkCommandBuffer>* results = nullptr;
+    uint32_t outstanding = 0;
+    std::exception_ptr error;
+
+    // a JobSystem job, records queued jobs until there are none left
+    void drain();
+    // runs without the lock held, only touches `thread`'s pool and its own result slot
+    void recordJob(uint32_t thread, uint32_t job);
+    void recordCached(uint32_t job);
+    // reusable buffers don't inherit the framebuffer, it changes with the swapchain image
+    void recordInto(VkCommandBuffer cmd, uint32_t job, bool reusable);
+    void setError();
+    VkCommandBuffer allocate(uint32_t thread);
+};
+
+#endif // VK_SHADER_EXP_SECONDARY_RECORDER_H
@@ -0,0 +1,22 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_SHADER_COMPILER_H
+#define VK_SHADER_EXP_SHADER_COMPILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * glsl -> spir-v through the vendored glslang, in process
+ * the stage comes from the file extension (.vert, .frag, .comp), safe to call from any thread
+ */
+namespace ShaderCompiler {
+    bool isShaderSource(const std::string& path);
+
+    // on failure returns false and leaves glslang's info log in `log`
+    bool compileFile(const std::string& path, std::vector<uint32_t>& spirv, std::string& log);
+    bool compile(const std::string& source, const std::string& name, std::vector<uint32_t>& spirv, std::string& log);
+}
+
+#endif // VK_SHADER_EXP_SHADER_COMPILER_H
@@ -0,0 +1,55 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_SHADER_HOT_RELOAD_H
+#define VK_SHADER_EXP_SHADER_HOT_RELOAD_H
+
+#include <util/file_watcher.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Engine;
+
+/*
+ * watches every shader_repo/<demo>/shaders directory and the engine's own shaders/ next to it for glsl edits
+ *
+ * a changed .vert/.frag is recompiled on the watcher thread and handed to the PipelineStore, which rebuilds
+ * the programs using it there as well; the engine swaps the new pipelines in between two frames
+ * compile and build errors are kept per file until the next successful save
+ */
+class ShaderHotReload {
+public:
+    struct Error {
+        std::string path;
+        std::string log;
+    };
+
+    ShaderHotReload() = default;
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+    // returns false when no shader directories were found
+    bool start(Engine* engineRef);
+    void stop();
+
+    bool isRunning() const { return watcher.isRunning(); }
+    std::vector<Error> getErrors() const;
+    std::string getLastReloaded() const;
+    uint32_t getReloadCount() const;
+
+private:
+    Engine* engine = nullptr;
+    FileWatcher watcher;
+    std::string engineShaders; // shaders/ as watched, its programs use shaders/<file>.spv
+
+    mutable std::mutex mutex; // guards everything below, the ui reads it from the render thread
+    std::map<std::string, std::string> errors;
+    std::string lastReloaded;
+    uint32_t reloadCount = 0;
+
+    void onFilesChanged(const std::vector<std::string>& paths);
+};
+
+#endif // VK_SHADER_EXP_SHADER_HOT_RELOAD_H
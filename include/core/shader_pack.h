@@ -0,0 +1,64 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_SHADER_PACK_H
+#define VK_SHADER_EXP_SHADER_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * every demo's spir-v in one file, built by vk_shader_pack at build time
+ *
+ * layout: header, index sorted by name hash, name strings, then the blobs, each 16-byte aligned
+ * the file is mapped read-only for the engine's lifetime and modules are created straight from the mapping,
+ * so looking a shader up is a binary search with no filesystem access and no copy
+ */
+class ShaderPack {
+public:
+    struct Blob {
+        const uint32_t* code = nullptr;
+        size_t size = 0;       // bytes
+        uint64_t hash = 0;     // fnv1a of the blob, computed at pack time
+
+        explicit operator bool() const { return code != nullptr; }
+    };
+
+    ShaderPack() = default;
+    ~ShaderPack() { close(); }
+    ShaderPack(const ShaderPack&) = delete;
+    ShaderPack& operator=(const ShaderPack&) = delete;
+
+    // validates the header, the index and every content hash, false leaves the pack closed
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    uint32_t getEntryCount() const { return entryCount; }
+
+    // name as the programs refer to it, e.g. shader_repo/plasma_ball/shaders/plasma_ball.frag.spv
+    Blob find(std::string_view name) const;
+
+    static bool write(const std::string& path, const std::vector<std::pair<std::string, std::vector<char>>>& files,
+                      std::string& error);
+
+private:
+    const uint8_t* base = nullptr;
+    size_t mappedSize = 0;
+    uint32_t entryCount = 0;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    bool map(const std::string& path);
+    void unmap();
+};
+
+#endif // VK_SHADER_EXP_SHADER_PACK_H
@@ -0,0 +1,119 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_SIMULATION_THREAD_H
+#define VK_SHADER_EXP_SIMULATION_THREAD_H
+
+#include <util/triple_buffer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+class EngineObject;
+
+/*
+ * steps the current EngineObject's layers (LayerComponent::onSimulate) at a fixed rate on a thread of its own,
+ * used with EngineConfig::fixedStepSimulation
+ *
+ * steps are paced against a steady clock and never wait on rendering, a frame never waits on a step either;
+ * falling more than MAX_CATCH_UP steps behind drops the backlog instead of spiralling
+ * layers hand their state to the render side through a SimulationState, which interpolates between the
+ * last two steps at getRenderTime(), one step behind the simulation so there always is a step to blend towards
+ */
+class SimulationThread {
+public:
+    static constexpr uint32_t MAX_CATCH_UP = 8;
+
+    SimulationThread() = default;
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start(double rate);
+    void stop();
+    bool isRunning() const { return thread.joinable(); }
+
+    // the object whose layers are stepped, null pauses; waits for a step in progress to finish
+    void setApp(EngineObject* app);
+    // held for every step, layer stack changes take it too
+    std::mutex& getStepMutex() { return stepMutex; }
+
+    double getStep() const { return step; }
+    // simulated seconds up to the last finished step
+    double getTime() const { return time.load(std::memory_order_acquire); }
+    // where on the simulation's timeline the frame being built sits
+    double getRenderTime() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::thread thread;
+    std::mutex stepMutex;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    EngineObject* app = nullptr; // under stepMutex
+    double step = 1.0 / 120.0;
+    uint64_t steps = 0;
+    std::atomic<double> time{0.0};
+    // wall clock time of simulated time 0, moved forward by dropped steps
+    std::atomic<int64_t> originNs{0};
+
+    void loop();
+};
+
+/*
+ * the state a layer simulates, published by onSimulate and sampled by onUpdate / onRender
+ * T is copied into the triple buffer, keep it to plain data
+ */
+template <typename T>
+class SimulationState {
+public:
+    // simulation thread, `state` as of simulated time `time`
+    void publish(const T& state, double time) {
+        Snapshot& snapshot = buffer.back();
+        snapshot.previous = hasLast ? last : state;
+        snapshot.current = state;
+        snapshot.time = time;
+        snapshot.span = hasLast ? time - lastTime : 0.0;
+        snapshot.valid = true;
+        buffer.publish();
+
+        last = state;
+        lastTime = time;
+        hasLast = true;
+    }
+
+    // render side, lerp(a, b, t) blends two states; T{} until the first step
+    template <typename Lerp>
+    T sample(double renderTime, Lerp lerp) {
+        const Snapshot& snapshot = buffer.read();
+        if (!snapshot.valid) return T{};
+        if (snapshot.span <= 0.0) return snapshot.current;
+
+        const double t = (renderTime - (snapshot.time - snapshot.span)) / snapshot.span;
+        return lerp(snapshot.previous, snapshot.current, std::clamp(t, 0.0, 1.0));
+    }
+
+private:
+    struct Snapshot {
+        T previous{};
+        T current{};
+        double time = 0.0;
+        double span = 0.0; // simulated time between previous and current
+        bool valid = false;
+    };
+
+    TripleBuffer<Snapshot> buffer;
+
+    // simulation thread only
+    T last{};
+    double lastTime = 0.0;
+    bool hasLast = false;
+};
+
+#endif // VK_SHADER_EXP_SIMULATION_THREAD_H
@@ -0,0 +1,74 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_SWAPCHAIN_H
+#define VK_SHADER_EXP_SWAPCHAIN_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+class Engine;
+
+/*
+ * the window's swapchain, its images, a view per image and the semaphore present waits on for each
+ *
+ * create() replaces all of those through VkSwapchainCreateInfoKHR::oldSwapchain without waiting for the device,
+ * the old set is retired through the engine's deletion queue since queued presents may still use it
+ * frame contexts, command buffers and pipelines are never touched by a resize
+ *
+ * with dynamic rendering (Engine::hasDynamicRendering()) the views are drawn into directly,
+ * otherwise the engine keeps a framebuffer over each of them
+ */
+class Swapchain {
+public:
+    Swapchain() = default;
+    Swapchain(const Swapchain&) = delete;
+    Swapchain& operator=(const Swapchain&) = delete;
+
+    void init(Engine* engineRef, VkSurfaceKHR surfaceRef);
+    void shutdown();
+
+    /*
+     * (re)builds everything for the surface's current size, `windowExtent` is used where the surface leaves it
+     * to the swapchain (wayland)
+     * returns false without a swapchain while the surface is zero sized (minimized)
+     */
+    bool create(VkExtent2D windowExtent);
+
+    VkResult acquire(VkSemaphore imageAvailable, uint32_t& imageIndex);
+    // waits on getRenderFinished(imageIndex)
+    VkResult present(VkQueue queue, uint32_t imageIndex);
+
+    VkSwapchainKHR getHandle() const { return swapchain; }
+    VkFormat getFormat() const { return surfaceFormat.format; }
+    VkExtent2D getExtent() const { return extent; }
+    uint32_t getImageCount() const { return imageCount; }
+    uint32_t getMinImageCount() const { return minImageCount; }
+    VkImage getImage(uint32_t index) const { return images[index].image; }
+    VkImageView getView(uint32_t index) const { return images[index].view; }
+    VkSemaphore getRenderFinished(uint32_t index) const { return images[index].renderFinished; }
+
+private:
+    struct Image {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkSemaphore renderFinished = VK_NULL_HANDLE;
+    };
+
+    Engine* engine = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    VkSurfaceFormatKHR surfaceFormat{}; // picked once, a surface's formats don't change with its size
+    VkExtent2D extent{};
+    uint32_t minImageCount = 2;
+    uint32_t imageCount = 0;
+    std::vector<Image> images;
+
+    void chooseFormat();
+    void retire(VkSwapchainKHR old, std::vector<Image> oldImages);
+};
+
+#endif // VK_SHADER_EXP_SWAPCHAIN_H
@@ -0,0 +1,77 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_UNIFORM_RING_H
+#define VK_SHADER_EXP_UNIFORM_RING_H
+
+#include <core/gpu_allocator.h>
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class Engine;
+
+/*
+ * per-frame uniform storage shared by every layer
+ *
+ * one persistently mapped buffer split into a region per frame in flight, layers push their uniform block
+ * each frame and bind the one shared descriptor set with the returned dynamic offset
+ * a region is only rewritten after its frame's fence has signalled, so the gpu never reads a half-written block
+ *
+ * static blocks sit at the end of every region at the same offset, so their dynamic offset only depends on the
+ * frame slot; a layer replaying a recording made for that slot rewrites the block each frame without re-recording
+ */
+class UniformRing {
+public:
+    // the descriptor covers this many bytes from the dynamic offset, bigger blocks don't fit
+    static constexpr VkDeviceSize MAX_BLOCK_SIZE = 256;
+    static constexpr VkDeviceSize DEFAULT_REGION_SIZE = 64 * 1024;
+
+    UniformRing() = default;
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    void init(Engine* engineRef, uint32_t framesInFlight, VkDeviceSize regionSize = DEFAULT_REGION_SIZE);
+    void shutdown();
+
+    // call once the frame slot's fence has been waited on
+    void beginFrame(uint32_t frameIndex);
+
+    // copies the block into this frame's region and returns its dynamic offset, throws when the region is full
+    // thread safe, layers recording in parallel push from worker threads
+    uint32_t push(const void* data, VkDeviceSize size);
+
+    // a static block for the caller until freeStatic(), throws when the regions can't give up another one
+    uint32_t allocateStatic();
+    void freeStatic(uint32_t block);
+    // copies the block into this frame's copy and returns its dynamic offset, same as getStaticOffset()
+    uint32_t writeStatic(uint32_t block, const void* data, VkDeviceSize size);
+    // this frame's copy of `block`, the same value every time the frame slot comes around
+    uint32_t getStaticOffset(uint32_t block) const;
+
+    // set 0 layout of the PipelineStore, binding 0 is a UNIFORM_BUFFER_DYNAMIC
+    VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+    VkDeviceSize getFrameUsage() const { return head - regionBegin; }
+
+private:
+    Engine* engine = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    GpuAllocation memory;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+    VkDeviceSize alignment = 256;
+    VkDeviceSize regionSize = 0;
+    VkDeviceSize regionBegin = 0;
+    VkDeviceSize head = 0;
+    // guards head and the static block bookkeeping
+    std::mutex headMutex;
+
+    VkDeviceSize staticStride = 0;
+    uint32_t staticCount = 0; // blocks carved off the end of every region, freed ones included
+    std::vector<uint32_t> freeStaticBlocks;
+};
+
+#endif // VK_SHADER_EXP_UNIFORM_RING_H
@@ -0,0 +1,120 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_UPLOAD_QUEUE_H
+#define VK_SHADER_EXP_UPLOAD_QUEUE_H
+
+#include <core/gpu_allocator.h>
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class Engine;
+
+/*
+ * asynchronous buffer / image uploads, on a transfer-only queue family where the device has one
+ *
+ * copies are staged in a persistently mapped ring and batched into one submit per flush(), which the engine does
+ * once a frame; nothing here waits on the graphics queue or makes the frame wait on a copy in progress
+ * - every batch gets the next value of a timeline semaphore (a fence per batch without VK_KHR_timeline_semaphore),
+ *   upload calls return it so callers can poll isComplete() or block their own thread in wait()
+ * - with a dedicated family the batch releases what it wrote to the graphics family, the engine records the matching
+ *   acquires into the first frame recorded after the batch finished; on the graphics family a barrier does it all
+ * - a copy that doesn't fit the ring's free space gets a staging buffer of its own instead of waiting for room
+ *
+ * a resource can be used by frames recorded once isComplete() returned true for its upload
+ * destinations use VK_SHARING_MODE_EXCLUSIVE and must not be in use by frames in flight while they are written
+ */
+class UploadQueue {
+public:
+    static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 16 * 1024 * 1024;
+
+    UploadQueue() = default;
+    UploadQueue(const UploadQueue&) = delete;
+    UploadQueue& operator=(const UploadQueue&) = delete;
+
+    void init(Engine* engineRef, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+    // device idle only
+    void shutdown();
+
+    // thread safe, `dst` needs TRANSFER_DST usage
+    uint64_t uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+    // mip 0 / layer 0 of a fresh (UNDEFINED) color image with TRANSFER_DST | SAMPLED usage, tightly packed texels,
+    // ends up SHADER_READ_ONLY_OPTIMAL
+    uint64_t uploadImage(VkImage dst, VkExtent3D extent, const void* data, VkDeviceSize size);
+
+    // submits the batch collected since the last call; on the graphics family main thread only, it shares the queue
+    void flush();
+
+    /*
+     * ownership acquires of batches that finished since the last call, recorded at the start of the frame
+     * returns the timeline value the frame's submit waits on (already signalled, it only orders the acquire), 0 for none
+     */
+    uint64_t recordAcquires(VkCommandBuffer cmd);
+
+    bool isComplete(uint64_t value);
+    // blocks the calling thread only; a value not flushed yet is flushed here where that's allowed, see flush()
+    void wait(uint64_t value);
+
+    bool hasDedicatedQueue() const { return dedicated; }
+    VkSemaphore getTimeline() const { return timeline; }
+    VkDeviceSize getStagingSize() const { return stagingSize; }
+
+private:
+    struct Batch {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE; // without timeline semaphores
+        uint64_t value = 0;
+        uint64_t stagingEnd = 0;        // ring head once this batch's copies were staged
+        std::vector<std::pair<VkBuffer, GpuAllocation>> oversized;
+        // what the copies wrote, released (or made visible) in one barrier when the batch is submitted
+        std::vector<VkBufferMemoryBarrier> buffers;
+        std::vector<VkImageMemoryBarrier> images;
+    };
+    struct Acquire {
+        uint64_t value = 0;
+        std::vector<VkBufferMemoryBarrier> buffers;
+        std::vector<VkImageMemoryBarrier> images;
+    };
+
+    Engine* engine = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t family = 0;
+    uint32_t graphicsFamily = 0;
+    bool dedicated = false;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    PFN_vkGetSemaphoreCounterValueKHR getCounterValue = nullptr;
+    PFN_vkWaitSemaphoresKHR waitSemaphores = nullptr;
+
+    VkBuffer staging = VK_NULL_HANDLE;
+    GpuAllocation stagingMemory;
+    VkDeviceSize stagingSize = 0;
+    VkDeviceSize copyAlignment = 16;
+    // monotonic byte counters, the ring position is the value modulo stagingSize
+    uint64_t head = 0;
+    uint64_t tail = 0;
+
+    std::mutex mutex;
+    Batch open;                 // recording, submitted by the next flush()
+    bool openRecording = false;
+    uint64_t nextValue = 1;     // value the open batch will signal
+    uint64_t completedValue = 0;
+    std::deque<Batch> inFlight;
+    std::vector<Batch> spare;   // finished batches, command buffer and fence reused
+    std::deque<Acquire> acquires;
+
+    // all of these under the mutex
+    VkCommandBuffer beginOpen();
+    std::pair<VkBuffer, VkDeviceSize> stage(const void* data, VkDeviceSize size);
+    void submitOpen();
+    void collect();
+    uint64_t queryCompleted();
+    bool canFlushHere() const;
+};
+
+#endif // VK_SHADER_EXP_UPLOAD_QUEUE_H
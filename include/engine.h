@@ -4,6 +4,20 @@
 #define VK_SHADER_EXP_ENGINE_H
 
 #include <util/viewport.h>
+#include <core/pipeline_cache.h>
+#include <core/pipeline_store.h>
+#include <core/deletion_queue.h>
+#include <core/gpu_allocator.h>
+#include <core/uniform_ring.h>
+#include <core/shader_hot_reload.h>
+#include <core/shader_pack.h>
+#include <core/render_graph.h>
+#include <core/swapchain.h>
+#include <core/secondary_recorder.h>
+#include <core/job_system.h>
+#include <core/simulation_thread.h>
+#include <core/upload_queue.h>
+#include <functional>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -12,24 +26,167 @@ struct SDL_Window;
 
 class EngineObject;
 
+struct EngineConfig {
+    // number of frames the cpu may record ahead of the gpu
+    uint32_t framesInFlight = 2;
+
+    /*
+     * headless renders into an offscreen image instead of a window + swapchain
+     * the engine also drops into this mode on its own when no window or surface can be created
+     */
+    bool headless = false;
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    VkFormat offscreenFormat = VK_FORMAT_B8G8R8A8_UNORM;
+
+    // stop run() after this many frames, 0 runs until quit is requested
+    uint64_t frameLimit = 0;
+
+    // on-disk pipeline cache, empty keeps it in memory only
+    std::string pipelineCachePath = "pipeline_cache.bin";
+
+    // recompile and swap shaders when their glsl changes on disk, windowed mode only
+    bool hotReload = true;
+
+    // packed spir-v written by the build, looked up in the working directory then next to the executable
+    // shaders missing from it (or a missing pack) fall back to the loose .spv files the build writes under spirv/opt/
+    std::string shaderPackPath = "shaders.pack";
+
+    // build fullscreen pipelines from shared VK_EXT_graphics_pipeline_library parts where the device has it
+    bool pipelineLibraries = true;
+
+    // draw straight into the swapchain / offscreen views with VK_KHR_dynamic_rendering where the device has it,
+    // no render passes or framebuffers then
+    bool dynamicRendering = true;
+
+    // job workers recording layers that opted into parallel recording at once, 0 lets all of them
+    uint32_t recordingThreads = 0;
+
+    // JobSystem workers, 0 leaves one core to the frame thread
+    uint32_t jobWorkers = 0;
+    // cpu each job worker is pinned to (worker i gets jobAffinity[i % size]), empty doesn't pin
+    std::vector<uint32_t> jobAffinity;
+
+    // step layers' onSimulate at simulationRate hz on a thread of its own, decoupled from the frame rate
+    bool fixedStepSimulation = false;
+    double simulationRate = 120.0;
+
+    // persistently mapped ring UploadQueue stages copies in, bigger uploads get a staging buffer of their own
+    VkDeviceSize uploadStagingSize = UploadQueue::DEFAULT_STAGING_SIZE;
+    // UploadQueue copies on a transfer-only queue family where the device has one, false keeps them on the graphics queue
+    bool transferQueue = true;
+};
+
 class Engine {
 public:
-    Engine();
+    explicit Engine(const EngineConfig& config = {});
     ~Engine();
 
-    void run();
+    // starts with the select menu when no object is given
+    void run(EngineObject* initial_app = nullptr);
+    void requestQuit() { quitRequested = true; }
+
+    /*
+     * the switch happens at the start of the next frame, never in the middle of the current app's update
+     * the old app is deleted then, its gpu objects go through the deletion queue
+     */
     void switchProject(EngineObject* new_app);
 
+    // destroy gpu objects once every frame that may still reference them has finished, never stalls
+    void retire(std::function<void()> deleter) { deletionQueue.retire(frameCount + 1, std::move(deleter)); }
+
+    // records and submits one frame, public so batch/bench drivers can step the engine themselves
+    void renderFrame(float deltaTime);
+
+    /*
+     * copies the most recently submitted offscreen frame into tightly packed pixels
+     * only valid in headless mode, blocks until that frame is done on the gpu
+     */
+    bool readbackFrame(std::vector<uint8_t>& pixels);
+
     Viewport& getViewport() { return viewport; }
     SDL_Window* getWindow() const { return window; }
     VkDevice getDevice() const { return device; }
     VkPhysicalDevice getPhysicalDevice() const { return physicalDevice; }
+    VkQueue getGraphicsQueue() const { return graphicsQueue; }
+    uint32_t getGraphicsQueueFamily() const { return graphicsQueueFamily; }
+    // a transfer-only family where the device has one, the graphics queue and family otherwise
+    VkQueue getTransferQueue() const { return transferQueue; }
+    uint32_t getTransferQueueFamily() const { return transferQueueFamily; }
+    // VK_NULL_HANDLE with dynamic rendering
     VkRenderPass getRenderPass() const { return imguiRenderPass; }
+    PipelineCache& getPipelineCache() { return pipelineCache; }
+    PipelineStore& getPipelineStore() { return pipelineStore; }
+    const ShaderPack& getShaderPack() const { return shaderPack; }
+    GpuAllocator& getAllocator() { return gpuAllocator; }
+    UniformRing& getUniformRing() { return uniformRing; }
+    RenderGraph& getRenderGraph() { return renderGraph; }
+    JobSystem& getJobSystem() { return jobSystem; }
+    UploadQueue& getUploadQueue() { return uploadQueue; }
+    // running with EngineConfig::fixedStepSimulation only
+    SimulationThread& getSimulation() { return simulation; }
+    bool hasFixedStepSimulation() const { return simulation.isRunning(); }
+    const ShaderHotReload& getHotReload() const { return hotReload; }
+    uint32_t getFramesInFlight() const { return config.framesInFlight; }
+    uint32_t getCurrentFrameIndex() const { return currentFrame; }
+    bool isHeadless() const { return config.headless; }
+    VkFormat getColorFormat() const { return colorFormat; }
+    VkExtent2D getRenderExtent() const { return config.headless ? offscreenExtent : swapchain.getExtent(); }
+    uint64_t getFrameCount() const { return frameCount; }
+
+    // what instance and device both support, capped at 1.1
+    uint32_t getApiVersion() const { return apiVersion; }
+    // supportedStages is 0 without vulkan 1.1
+    const VkPhysicalDeviceSubgroupProperties& getSubgroupProperties() const { return subgroupProperties; }
+    // VK_EXT_graphics_pipeline_library enabled on the device, see PipelineStore
+    bool hasPipelineLibraries() const { return pipelineLibrariesSupported; }
+    // VK_KHR_timeline_semaphore enabled on the device, UploadQueue falls back to a fence per batch without it
+    bool hasTimelineSemaphores() const { return timelineSemaphoresSupported; }
+
+    /*
+     * VK_KHR_dynamic_rendering enabled on the device: raster passes begin with beginRendering() instead of a
+     * render pass, and pipelines are built against their color format alone (VkPipelineRenderingCreateInfo)
+     */
+    bool hasDynamicRendering() const { return dynamicRenderingSupported; }
+    void beginRendering(VkCommandBuffer cmd, const VkRenderingInfo& info) const { cmdBeginRendering(cmd, &info); }
+    void endRendering(VkCommandBuffer cmd) const { cmdEndRendering(cmd); }
+
+    /*
+     * gpu time of the whole frame command buffer, measured with timestamp queries
+     * results lag behind by framesInFlight, getGpuTimedFrame() tells which frame (1-based frame count) they belong to
+     */
+    bool hasGpuTimings() const { return timestampsSupported; }
+    double getGpuFrameTimeMs() const { return gpuFrameTimeMs; }
+    uint64_t getGpuTimedFrame() const { return gpuTimedFrame; }
 
 private:
+    /*
+     * everything one in-flight frame owns
+     * the fence is signaled once the gpu is done with the command buffer
+     */
+    struct FrameContext {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkSemaphore imageAvailable = VK_NULL_HANDLE;
+        VkFence inFlight = VK_NULL_HANDLE;
+
+        VkQueryPool timestamps = VK_NULL_HANDLE;
+        uint64_t submittedFrame = 0; // frameCount value of the last submit from this slot, 0 = never
+    };
+
+    // headless stand-in for a swapchain image, one per in-flight frame
+    struct OffscreenTarget {
+        VkImage image = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE; // render pass path only
+    };
+
+    EngineConfig config;
     SDL_Window* window = nullptr;
     Viewport viewport;
     EngineObject* current_app = nullptr;
+    EngineObject* pending_app = nullptr;
+    bool switchPending = false;
 
     VkInstance instance{};
     VkSurfaceKHR surface{};
@@ -37,13 +194,52 @@ private:
     VkDevice device{};
     VkQueue graphicsQueue{};
     uint32_t graphicsQueueFamily{};
+    VkQueue transferQueue{};
+    uint32_t transferQueueFamily{};
     VkCommandPool commandPool{};
-    std::vector<VkCommandBuffer> commandBuffers;
+    PipelineCache pipelineCache;
+    PipelineStore pipelineStore;
+    ShaderPack shaderPack;
+    DeletionQueue deletionQueue;
+    GpuAllocator gpuAllocator;
+    UniformRing uniformRing;
+    RenderGraph renderGraph;
+    SecondaryRecorder secondaryRecorder;
+    JobSystem jobSystem;
+    SimulationThread simulation;
+    UploadQueue uploadQueue;
+    ShaderHotReload hotReload;
+
+    std::vector<FrameContext> frames;
+    uint32_t currentFrame = 0;
+    uint32_t lastSubmittedFrame = 0;
+    uint64_t frameCount = 0;
+    uint64_t completedFrameCount = 0;
+    bool quitRequested = false;
+
+    bool timestampsSupported = false;
+    double timestampPeriodNs = 1.0;
+    uint64_t timestampMask = ~0ull;
+    double gpuFrameTimeMs = 0.0;
+    uint64_t gpuTimedFrame = 0;
 
-    VkSwapchainKHR swapchain{};
-    VkExtent2D swapchainExtent{};
+    VkFormat colorFormat = VK_FORMAT_B8G8R8A8_UNORM;
+    uint32_t apiVersion = VK_API_VERSION_1_0;
+    VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+    bool pipelineLibrariesSupported = false;
+    bool dynamicRenderingSupported = false;
+    bool timelineSemaphoresSupported = false;
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+
+    Swapchain swapchain;
+    // set by resize events and out of date / suboptimal results, recreated once at the start of the next frame
+    bool swapchainDirty = false;
+    // render pass path only, indexed by swapchain image
     std::vector<VkFramebuffer> framebuffers;
-    size_t currentFrame = 0;
+
+    VkExtent2D offscreenExtent{};
+    std::vector<OffscreenTarget> offscreenTargets;
 
     VkDescriptorPool imguiPool{};
     VkRenderPass imguiRenderPass{};
@@ -54,12 +250,34 @@ private:
     void initImGui();
     void createImGuiPool();
     void createImGuiRenderPass();
-
+    void fallbackToHeadless(const char* reason);
+    void openShaderPack();
+    void pickPhysicalDevice();
+    void querySubgroupProperties(uint32_t instanceVersion);
+    bool queryPipelineLibrarySupport();
+    bool queryDynamicRenderingSupport();
+    bool queryTimelineSemaphoreSupport();
+    bool queryCreationFeedbackSupport();
+    void pickTransferFamily();
+    void runWindowed();
+    void runHeadless();
+    void applyPendingSwitch();
 
     // swapchain & buffer helpers
-    void createSwapchain();
+    bool createSwapchain();
     void createFramebuffers();
-    void createCommandBuffers();
+    void destroyFramebuffers();
+    void createFrameContexts();
+    void collectGpuTimings(FrameContext& frame);
+    void recreateSwapchain();
+    // the backbuffer pass around onRender and imgui, a render pass or dynamic rendering plus its layout transitions
+    // `secondaries` begins it for vkCmdExecuteCommands instead of inline recording
+    void beginBackbuffer(VkCommandBuffer cmd, VkImage image, VkImageView view, VkFramebuffer framebuffer, VkExtent2D extent,
+                         bool secondaries = false);
+    void recordBackbufferSecondaries(VkCommandBuffer cmd, VkFramebuffer framebuffer, VkExtent2D extent);
+    void endBackbuffer(VkCommandBuffer cmd, VkImage image);
+    void createOffscreenTargets();
+    void destroyOffscreenTargets();
     VkCommandBuffer beginSingleTimeCommands();
     void endSingleTimeCommands(VkCommandBuffer cmd);
 
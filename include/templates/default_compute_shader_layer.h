@@ -0,0 +1,95 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_ENGINE_DEFAULT_COMPUTE_SHADER_LAYER_H
+#define VK_SHADER_ENGINE_DEFAULT_COMPUTE_SHADER_LAYER_H
+
+#include <core/layer_component.h>
+#include <core/pipeline_store.h>
+#include <core/render_graph.h>
+#include <core/simulation_thread.h>
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * compute shader writing a storage image, stretched over the target afterwards
+ *
+ * the compute counterpart of DefaultShaderLayer, for shaders that share work between neighbouring pixels
+ * - the image is a render graph transient in STORAGE_FORMAT, the shader sees it at set 1 binding 0
+ *   (layout(set = 1, binding = 0, rgba16f) uniform writeonly image2D)
+ * - the workgroup size comes in through specialization constants 0 and 1, declare
+ *   layout(local_size_x_id = 0, local_size_y_id = 1) in; and size shared arrays off gl_WorkGroupSize
+ * - one invocation per pixel, the last row / column of groups hangs over the edge, bounds check against iResolution
+ * - compute shaders are built for vulkan 1.1, so GL_KHR_shader_subgroup_* works where the device has it
+ *   (Engine::getSubgroupProperties())
+ *
+ * uniforms work like DefaultShaderLayer's: a block at set 0 binding 0 or push constants, written by name,
+ * iResolution (the image size), iTime and iFrame filled in every frame
+ * with fixed-step simulation iTime advances in onSimulate and is interpolated for the frame being drawn,
+ * subclasses overriding onSimulate call this one as well
+ * onRender is safe to record in parallel (setParallelRecording), the dispatch itself is its own graph pass
+ */
+class DefaultComputeShaderLayer : public LayerComponent {
+public:
+    DefaultComputeShaderLayer(EngineObject* parent, const std::string& name, std::string compPath,
+                              uint32_t workgroupX = 8, uint32_t workgroupY = 8);
+    ~DefaultComputeShaderLayer() override = default;
+
+    void onAttach() override;
+    void onDetach() override;
+    void onUpdate(float deltaTime) override;
+    void onSimulate(double step, double time) override;
+    void onBuildGraph(RenderGraph& graph) override;
+    void onRender(VkCommandBuffer cmd) override;
+
+    // call from the subclass constructor, size of the storage image relative to the render extent
+    void setImageScale(float scale) { imageScale = scale; }
+
+    static constexpr VkFormat STORAGE_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static constexpr uint32_t WORKGROUP_X_ID = 0;
+    static constexpr uint32_t WORKGROUP_Y_ID = 1;
+
+    // what a layer running `compPath` builds, for prewarming
+    static std::vector<ShaderProgramDesc> computePrograms(const std::string& compPath, uint32_t workgroupX = 8,
+                                                          uint32_t workgroupY = 8);
+
+protected:
+    VkDevice device = VK_NULL_HANDLE;
+    float totalTime = 0.0f;
+    int32_t frameIndex = 0;
+
+    // fixed-step mode, the shader clock as of the last step, handed to onUpdate
+    double simulatedTime = 0.0;
+    SimulationState<double> shaderClock;
+
+    // copies into the named member of the uniform block, returns false when the shader doesn't declare it
+    bool setUniform(const std::string& member, const void* data, size_t size);
+    const PipelineStore::Program* getProgram() const { return program; }
+
+private:
+    enum class UniformSource { None, Ring, PushConstants, Unsupported };
+
+    void setupUniforms();
+    // hot reload swaps the program underneath us, its uniform block may have changed shape
+    void syncProgram() { if (program && program->generation != generation) setupUniforms(); }
+    void recordDispatch(VkCommandBuffer cmd, VkExtent2D extent, VkDescriptorSet set);
+
+    ShaderProgramDesc desc;
+    const PipelineStore::Program* program = nullptr; // owned by the engine's PipelineStore
+    uint32_t generation = 0;
+    uint32_t workgroupX = 8;
+    uint32_t workgroupY = 8;
+
+    UniformSource uniformSource = UniformSource::None;
+    const std::vector<ShaderReflection::Member>* uniformMembers = nullptr;
+    std::vector<uint8_t> uniformBlock;
+
+    ShaderProgramDesc compositeDesc;
+    const PipelineStore::Program* compositeProgram = nullptr;
+
+    float imageScale = 1.0f;
+    RenderGraph::Resource target = RenderGraph::INVALID_RESOURCE;
+};
+
+#endif // VK_SHADER_ENGINE_DEFAULT_COMPUTE_SHADER_LAYER_H
@@ -4,49 +4,192 @@
 #define VK_SHADER_ENGINE_DEFAULT_SHADER_LAYER_H
 
 #include <core/layer_component.h>
+#include <core/pipeline_store.h>
+#include <core/gpu_allocator.h>
+#include <core/render_graph.h>
+#include <core/resolution_governor.h>
+#include <core/simulation_thread.h>
 #include <vulkan/vulkan.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+/*
+ * fullscreen triangle running one shader program
+ *
+ * the uniform block is whatever the shader declares, a uniform buffer at set 0 binding 0 or a push_constant block;
+ * members are written by name, iResolution, iTime and iFrame are filled in every frame
+ * anything in sets 1+ is left for subclasses to bind (set 1 only without feedback buffers), see getProgram()
+ *
+ * feedback buffers are shadertoy's Buffer A-D: offscreen passes drawn before the layer's own shader,
+ * each keeping what it drew last frame
+ * - every pass (buffers and the layer's shader) sees them as combined image samplers at set 1, binding 0-3 = A-D
+ * - a buffer sampling itself or a later buffer gets last frame's contents, an earlier one this frame's
+ * - the layer's shader gets this frame's contents of all of them
+ * - sized off the render extent, on a resize they are recreated the next frame and the old contents are scaled over
+ *
+ * with dynamic resolution the layer's own shader draws into a corner of an offscreen image instead,
+ * sized by a ResolutionGovernor from the gpu frame time, and that corner is stretched over the target
+ * iResolution is the scaled size then; headless runs hold the max scale so captures and bench numbers stay comparable
+ *
+ * spec variants are named sets of specialization constants (quality knobs like loop counts) applied to every pass,
+ * each one a pipeline of its own in the PipelineStore; all of them are prewarmed at attach, so switching is a lookup
+ *
+ * with fixed-step simulation iTime advances in onSimulate and is interpolated for the frame being drawn,
+ * subclasses overriding onSimulate call this one as well
+ *
+ * onRender only touches the layer's own passes and thread-safe engine state, subclasses can setParallelRecording(true)
+ * without feedback buffers, dynamic resolution or push constant uniforms the recording never changes between frames,
+ * subclasses can setCachedRecording(true) then: the uniform block goes to a static UniformRing block and the engine
+ * replays the recording (getRecordingKey()); ones overriding onRender don't, or override getRecordingKey() as well,
+ * ones overriding onBuildGraph call this one, it writes the static block once every layer's onUpdate ran
+ */
 class DefaultShaderLayer : public LayerComponent {
 public:
     DefaultShaderLayer(EngineObject* parent, const std::string& name, std::string vertPath, std::string fragPath);
+    DefaultShaderLayer(EngineObject* parent, const std::string& name, const ShaderProgramDesc& desc);
     ~DefaultShaderLayer() override = default;
 
     void onAttach() override;
     void onDetach() override;
     void onUpdate(float deltaTime) override;
+    void onSimulate(double step, double time) override;
+    void onBuildGraph(RenderGraph& graph) override;
     void onRender(VkCommandBuffer cmd) override;
+    uint64_t getRecordingKey() const override;
+
+    struct FeedbackBuffer {
+        std::string fragPath;
+        std::string vertPath;  // empty uses the layer's vertex shader
+        VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
+        float scale = 1.0f;    // of the render extent
+        uint32_t width = 0;    // fixed size instead of scale, both or neither
+        uint32_t height = 0;
+    };
+    static constexpr uint32_t MAX_FEEDBACK_BUFFERS = 4;
+
+    // call from the subclass constructor, buffers are A-D in the order they are added
+    void addFeedbackBuffer(const FeedbackBuffer& buffer);
+
+    // call from the subclass constructor, does nothing with feedback buffers, dynamic resolution or push constants
+    void setCachedRecording(bool enabled) { cachedRecording = enabled; }
+    bool isCachedRecording() const { return cachedRecording; }
+
+    // call from the subclass constructor
+    void enableDynamicResolution(const ResolutionGovernor::Config& config = {});
+    bool hasDynamicResolution() const { return dynamicResolution; }
+    const ResolutionGovernor& getResolutionGovernor() const { return governor; }
+
+    // what a layer drawing `program` with dynamic resolution builds, for prewarming
+    static constexpr VkFormat SCALED_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static std::vector<ShaderProgramDesc> dynamicResolutionPrograms(const ShaderProgramDesc& program);
+
+    struct SpecVariant {
+        std::string name;
+        std::vector<ShaderProgramDesc::SpecValue> values; // usually SpecValue::named()
+    };
+
+    // call from the subclass constructor, the first variant added is the one used until setSpecVariant()
+    void addSpecVariant(const SpecVariant& variant);
+    // false for an unknown name or a variant that failed to build, the current one stays then
+    bool setSpecVariant(const std::string& name);
+    const std::vector<SpecVariant>& getSpecVariants() const { return specVariants; }
+    const std::string& getSpecVariant() const;
+
+    // `program` once per variant, for prewarming
+    static std::vector<ShaderProgramDesc> specVariantPrograms(const ShaderProgramDesc& program,
+                                                              const std::vector<SpecVariant>& variants);
 
 protected:
     VkDevice device = VK_NULL_HANDLE;
     float totalTime = 0.0f;
+    int32_t frameIndex = 0;
+
+    // the main pass's uniforms when its recording is replayed, see canReplay()
+    static constexpr uint32_t NO_STATIC_BLOCK = UINT32_MAX;
+    uint32_t staticUniforms = NO_STATIC_BLOCK;
+
+    // fixed-step mode, the shader clock as of the last step, handed to onUpdate
+    double simulatedTime = 0.0;
+    SimulationState<double> shaderClock;
+
+    // copies into the named member of every pass's uniform block, returns false when no shader declares it
+    bool setUniform(const std::string& member, const void* data, size_t size);
+    const PipelineStore::Program* getProgram() const { return mainPass.program; }
 
 private:
-    void createResources();
+    enum class UniformSource { None, Ring, PushConstants, Unsupported };
+
+    // one shader program and the cpu copy of its uniform block
+    struct Pass {
+        ShaderProgramDesc desc;
+        const PipelineStore::Program* program = nullptr; // owned by the engine's PipelineStore
+        uint32_t generation = 0;
+
+        // pushed into the engine's uniform ring or sent as push constants when recording
+        UniformSource uniformSource = UniformSource::None;
+        const std::vector<ShaderReflection::Member>* uniformMembers = nullptr;
+        std::vector<uint8_t> uniformBlock;
+    };
+
+    struct FeedbackImage {
+        VkImage image = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkImageView view = VK_NULL_HANDLE;
+        RenderGraph::ImageState state;
+    };
+
+    struct FeedbackTarget {
+        FeedbackBuffer config;
+        Pass pass;
+        VkExtent2D extent{};
+        bool blitSupported = false;
+        FeedbackImage images[2];
+        uint32_t current = 0;     // written this frame, the other one holds last frame
+        bool seedHistory = false; // fresh images, history gets cleared or scaled over from `retiring`
+        FeedbackImage retiring;   // pre-resize history, kept for the frame of the resize only
+        VkExtent2D retiringExtent{};
+    };
+
     void createPipeline();
+    void setupUniforms(Pass& pass);
+    // hot reload swaps the program underneath us, its uniform block may have changed shape
+    void syncProgram(Pass& pass) { if (pass.program && pass.program->generation != pass.generation) setupUniforms(pass); }
+    static bool writeUniform(Pass& pass, const std::string& member, const void* data, size_t size);
     void updateUniforms();
+    void recordPass(Pass& pass, VkCommandBuffer cmd, VkExtent2D extent, VkDescriptorSet set, uint32_t setIndex = 1);
 
-    std::string vertexShaderPath;
-    std::string fragmentShaderPath;
+    void recordUpscale(VkCommandBuffer cmd, VkExtent2D extent);
+    // feedback channels and the scaled target come in per-frame sets, push constants are baked into the commands
+    bool canReplay() const;
 
-    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
-    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
-    
-    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
-    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
-    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    // the passes spec variants apply to, the layer's own and the feedback buffers'
+    std::vector<Pass*> specializedPasses();
+    void checkSpecVariants();
 
-    VkBuffer uniformBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory uniformBufferMemory = VK_NULL_HANDLE;
-    void* mappedData = nullptr;
+    void buildFeedbackPasses(RenderGraph& graph);
+    VkExtent2D feedbackExtent(const FeedbackBuffer& config) const;
+    void resizeFeedbackTarget(FeedbackTarget& target, VkExtent2D extent, uint32_t last);
+    void seedHistory(RenderGraph& graph, FeedbackTarget& target, RenderGraph::Resource history);
+    void destroyFeedbackImage(FeedbackImage& image);
+    // set 1 of `pass`, or null when the program doesn't sample any buffer
+    VkDescriptorSet writeChannelSet(RenderGraph& graph, const Pass& pass, const std::vector<RenderGraph::Resource>& channels);
 
+    Pass mainPass;
+    std::vector<FeedbackTarget> feedback;
+    std::vector<RenderGraph::Resource> mainChannels; // this frame's buffer contents, resolved in onRender
 
-    struct UniformBufferObject {
-        float resolution[2];
-        float time;
-        float padding;
-    };
+    bool dynamicResolution = false;
+    ResolutionGovernor governor;
+    uint64_t governedFrame = 0; // last gpu timed frame fed to the governor
+    VkExtent2D scaledExtent{};  // what the layer's shader draws this frame
+    Pass upscalePass;
+    RenderGraph::Resource scaledTarget = RenderGraph::INVALID_RESOURCE;
+
+    std::vector<SpecVariant> specVariants;
+    size_t currentVariant = 0;
+
+    bool cachedRecording = false;
 };
 
-#endif // VK_SHADER_ENGINE_DEFAULT_SHADER_LAYER_H
\ No newline at end of file
+#endif // VK_SHADER_ENGINE_DEFAULT_SHADER_LAYER_H
@@ -0,0 +1,52 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_FILE_WATCHER_H
+#define VK_SHADER_EXP_FILE_WATCHER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * watches a set of directories (not recursive) on its own thread
+ *
+ * linux uses inotify, everything else falls back to polling modification times
+ * editors tend to write a file in several steps (truncate, write, rename), so events are collected until
+ * the directories have been quiet for a moment and the callback gets each changed path once
+ * the callback runs on the watcher thread
+ */
+class FileWatcher {
+public:
+    using Callback = std::function<void(const std::vector<std::string>& changedPaths)>;
+
+    FileWatcher() = default;
+    ~FileWatcher() { stop(); }
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool start(std::vector<std::string> directories, Callback callback);
+    void stop();
+
+    bool isRunning() const { return running.load(); }
+
+private:
+    std::vector<std::string> dirs;
+    Callback onChange;
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    int inotifyFd = -1;
+    std::unordered_map<int, std::string> watchDirs; // inotify watch descriptor -> directory
+
+    static constexpr int QUIET_MS = 150;
+    static constexpr int POLL_MS = 500;
+
+    bool initInotify();
+    void runInotify();
+    void runPolling();
+};
+
+#endif // VK_SHADER_EXP_FILE_WATCHER_H
@@ -0,0 +1,34 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_HASH_H
+#define VK_SHADER_EXP_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Hash {
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    // 64-bit fnv-1a, good enough for content keys, not for anything adversarial
+    inline uint64_t fnv1a(const void* data, size_t size, uint64_t seed = FNV_OFFSET) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        uint64_t h = seed;
+        for (size_t i = 0; i < size; i++) {
+            h ^= bytes[i];
+            h *= FNV_PRIME;
+        }
+        return h;
+    }
+
+    inline uint64_t fnv1a(std::string_view str, uint64_t seed = FNV_OFFSET) {
+        return fnv1a(str.data(), str.size(), seed);
+    }
+
+    inline uint64_t combine(uint64_t h, uint64_t value) {
+        return fnv1a(&value, sizeof(value), h);
+    }
+}
+
+#endif // VK_SHADER_EXP_HASH_H
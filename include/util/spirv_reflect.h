@@ -0,0 +1,64 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_SPIRV_REFLECT_H
+#define VK_SHADER_EXP_SPIRV_REFLECT_H
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * the parts of a spir-v module the engine needs to build layouts for it
+ *
+ * only walks the declarations (names, decorations, types, variables), never function bodies,
+ * so every resource a module declares is reported even when the entry point ends up not using it
+ */
+struct ShaderReflection {
+    struct Member {
+        std::string name;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct Binding {
+        uint32_t set = 0;
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uint32_t count = 1;
+        VkShaderStageFlags stages = 0;
+        std::string name;
+        uint32_t blockSize = 0;      // uniform and storage blocks only, runtime arrays count as 0
+        std::vector<Member> members; // uniform and storage blocks only
+    };
+
+    struct PushConstantBlock {
+        uint32_t size = 0;
+        VkShaderStageFlags stages = 0;
+        std::vector<Member> members;
+    };
+
+    struct SpecConstant {
+        uint32_t id = 0;
+        std::string name;
+        uint32_t size = 4;
+        uint32_t defaultValue = 0; // raw bits, booleans are 0 / 1
+    };
+
+    VkShaderStageFlags stages = 0;
+    std::vector<Binding> bindings; // sorted by set, then binding
+    PushConstantBlock pushConstants;
+    std::vector<SpecConstant> specConstants; // sorted by id
+
+    // throws std::runtime_error on anything that isn't a well formed module
+    static ShaderReflection fromSpirv(const uint32_t* code, size_t wordCount);
+
+    // folds another stage of the same program in, throws when the stages disagree on a binding
+    void merge(const ShaderReflection& other);
+
+    const Binding* findBinding(uint32_t set, uint32_t binding) const;
+    uint32_t setCount() const { return bindings.empty() ? 0 : bindings.back().set + 1; }
+};
+
+#endif // VK_SHADER_EXP_SPIRV_REFLECT_H
@@ -0,0 +1,46 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_EXP_TRIPLE_BUFFER_H
+#define VK_SHADER_EXP_TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * lock-free hand-off of the latest value from one writer thread to one reader thread
+ *
+ * three slots: the writer fills its back slot and swaps it with the middle one, the reader swaps the middle
+ * into its front slot when something new was published; neither side ever waits for the other,
+ * values published faster than they are read are simply skipped
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    // writer side, fill then publish()
+    T& back() { return slots[backIndex]; }
+
+    void publish() {
+        const uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // reader side, the newest published value, the same one again when nothing was published since
+    const T& read() {
+        if (middle.load(std::memory_order_relaxed) & FRESH) {
+            const uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
+        }
+        return slots[frontIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    T slots[3]{};
+    uint8_t backIndex = 0;          // writer only
+    std::atomic<uint8_t> middle{1}; // index + FRESH once published and not read yet
+    uint8_t frontIndex = 2;         // reader only
+};
+
+#endif // VK_SHADER_EXP_TRIPLE_BUFFER_H
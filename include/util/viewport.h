@@ -20,6 +20,8 @@ public:
     Viewport() = default;
 
     void init(SDL_Window* windowHandle);
+    // fixed size backbuffer with no window behind it
+    void initHeadless(float width, float height);
     
     void onResize();
 
@@ -0,0 +1,8 @@
+// copyright 2025 swaroop.
+
+#include "plasma_ball_compute_layer.h"
+
+PlasmaBallComputeLayer::PlasmaBallComputeLayer(EngineObject* parent)
+    : DefaultComputeShaderLayer(parent, "PlasmaBallComputeLayer", SHADER, WORKGROUP_SIZE, WORKGROUP_SIZE)
+{
+}
@@ -0,0 +1,18 @@
+// copyright 2025 swaroop.
+
+#ifndef VK_SHADER_ENGINE_PLASMA_BALL_COMPUTE_LAYER_H
+#define VK_SHADER_ENGINE_PLASMA_BALL_COMPUTE_LAYER_H
+
+#include <templates/default_compute_shader_layer.h>
+
+// the plasma ball through the compute path, for comparing against PlasmaBallShaderLayer
+class PlasmaBallComputeLayer final : public DefaultComputeShaderLayer {
+public:
+    explicit PlasmaBallComputeLayer(EngineObject* parent);
+    ~PlasmaBallComputeLayer() override = default;
+
+    static constexpr const char* SHADER = "shader_repo/plasma_ball/shaders/plasma_ball.comp.spv";
+    static constexpr uint32_t WORKGROUP_SIZE = 16;
+};
+
+#endif // VK_SHADER_ENGINE_PLASMA_BALL_COMPUTE_LAYER_H
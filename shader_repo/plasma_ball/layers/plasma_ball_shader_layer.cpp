@@ -3,11 +3,28 @@
 #include "plasma_ball_shader_layer.h"
 
 PlasmaBallShaderLayer::PlasmaBallShaderLayer(EngineObject* parent)
-    : DefaultShaderLayer(
-        parent,
-        "PlasmaBallShaderLayer",
-        "shader_repo/plasma_ball/shaders/plasma_ball.vert.spv",
-        "shader_repo/plasma_ball/shaders/plasma_ball.frag.spv")
+    : DefaultShaderLayer(parent, "PlasmaBallShaderLayer", program())
 {
+    // 8 iterations of trig per pixel, too much for 4k at full resolution
+    enableDynamicResolution();
+
+    for (const auto& variant : variants()) addSpecVariant(variant);
+
+    setParallelRecording(true);
+}
+
+ShaderProgramDesc PlasmaBallShaderLayer::program() {
+    return {
+        "shader_repo/plasma_ball/shaders/plasma_ball.vert.spv",
+        "shader_repo/plasma_ball/shaders/plasma_ball.frag.spv"
+    };
+}
 
-}
\ No newline at end of file
+std::vector<DefaultShaderLayer::SpecVariant> PlasmaBallShaderLayer::variants() {
+    using Spec = ShaderProgramDesc::SpecValue;
+    return {
+        { "high", { Spec::named("scaleFactor", 0.7f), Spec::named("iterations", 8) } },
+        { "medium", { Spec::named("scaleFactor", 0.7f), Spec::named("iterations", 6) } },
+        { "low", { Spec::named("scaleFactor", 0.7f), Spec::named("iterations", 4) } },
+    };
+}
@@ -9,6 +9,10 @@ class PlasmaBallShaderLayer final : public DefaultShaderLayer {
 public:
     explicit PlasmaBallShaderLayer(EngineObject* parent);
     ~PlasmaBallShaderLayer() override = default;
+
+    static ShaderProgramDesc program();
+    // quality presets, scaleFactor and the iteration count are spec constants in plasma_ball.frag
+    static std::vector<SpecVariant> variants();
 };
 
 #endif // VK_SHADER_ENGINE_PLASMA_BALL_SHADER_LAYER_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "plasma_ball.h"
 
 #include "layers/plasma_ball_shader_layer.h"
+#include "layers/plasma_ball_compute_layer.h"
 #include "layers/screen_coordinates_ui_layer.h"
 
 PlasmaBallObject::PlasmaBallObject(Engine* e) : EngineObject(e) {
@@ -16,6 +17,14 @@ void PlasmaBallObject::onSetup() {
     pushLayer(new PlasmaBallUILayer(this));
 }
 
+std::vector<ShaderProgramDesc> PlasmaBallObject::shaderPrograms() {
+    std::vector<ShaderProgramDesc> programs = DefaultShaderLayer::dynamicResolutionPrograms(PlasmaBallShaderLayer::program());
+    // every quality preset of the scaled program, the upscale pass has none
+    std::vector<ShaderProgramDesc> variants = DefaultShaderLayer::specVariantPrograms(programs[0], PlasmaBallShaderLayer::variants());
+    variants.push_back(programs[1]);
+    return variants;
+}
+
 void PlasmaBallObject::update(float deltaTime) {
     EngineObject::update(deltaTime);
 }
@@ -23,3 +32,19 @@ void PlasmaBallObject::update(float deltaTime) {
 void PlasmaBallObject::render(VkCommandBuffer cmd) {
     EngineObject::render(cmd);
 }
+
+PlasmaBallComputeObject::PlasmaBallComputeObject(Engine* e) : EngineObject(e) {
+    objName = "[EngineObject] Plasma Ball Compute Shader";
+}
+
+void PlasmaBallComputeObject::onSetup() {
+    EngineObject::onSetup();
+
+    pushLayer(new PlasmaBallComputeLayer(this));
+    pushLayer(new PlasmaBallUILayer(this));
+}
+
+std::vector<ShaderProgramDesc> PlasmaBallComputeObject::shaderPrograms() {
+    return DefaultComputeShaderLayer::computePrograms(PlasmaBallComputeLayer::SHADER, PlasmaBallComputeLayer::WORKGROUP_SIZE,
+                                                      PlasmaBallComputeLayer::WORKGROUP_SIZE);
+}
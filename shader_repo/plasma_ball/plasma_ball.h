@@ -3,6 +3,7 @@
 #ifndef VK_SHADER_ENGINE_PLASMA_BALL_H
 #define VK_SHADER_ENGINE_PLASMA_BALL_H
 #include <core/engine_object.h>
+#include <core/pipeline_store.h>
 
 
 
@@ -13,6 +14,21 @@ public:
     void onSetup() override;
     void update(float deltaTime) override;
     void render(VkCommandBuffer cmd) override;
+
+    // picked up by SelectMenuObject::registerClass for pipeline prewarming
+    static std::vector<ShaderProgramDesc> shaderPrograms();
+};
+
+// same shader through DefaultComputeShaderLayer
+class PlasmaBallComputeObject final : public EngineObject {
+public:
+    explicit PlasmaBallComputeObject(Engine* e);
+
+    void onSetup() override;
+
+    static std::vector<ShaderProgramDesc> shaderPrograms();
+    // the compute shader is spir-v 1.3 for its subgroup reduction
+    static uint32_t requiredApiVersion() { return VK_API_VERSION_1_1; }
 };
 
 
@@ -8,14 +8,16 @@ layout(binding = 0) uniform UBO {
     float iTime;
 } ubo;
 
+// baked in per spec variant, see PlasmaBallShaderLayer
+layout(constant_id = 0) const float scaleFactor = 0.7;
+layout(constant_id = 1) const int iterations = 8;
+
 void main()
 {
     vec2 r = ubo.iResolution;
     float t = ubo.iTime;
     vec4 FC = gl_FragCoord;
 
-    float scaleFactor = 0.7;
-
     vec4 o = vec4(1e-5);
     vec2 l = vec2(0.0);
     vec2 i = vec2(0.0);
@@ -26,7 +28,7 @@ void main()
     l += 4.0 - 4.0 * abs(0.7 - dotP);
     vec2 v = p * l;
 
-    for (int k = 0; k < 8; k++) {
+    for (int k = 0; k < iterations; k++) {
         i.y += 1.0;
         v += cos(v.yx * i.y + i + t) / i.y + 0.7;
         o += (sin(v.xyyx) + 1.0) * abs(v.x - v.y);
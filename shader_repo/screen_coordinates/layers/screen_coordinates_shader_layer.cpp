@@ -3,11 +3,15 @@
 #include "screen_coordinates_shader_layer.h"
 
 ScreenCoordinatesShaderLayer::ScreenCoordinatesShaderLayer(EngineObject* parent)
-    : DefaultShaderLayer(
-        parent,
-        "ScreenCoordinatesShaderLayer",
-        "shader_repo/screen_coordinates/shaders/screen_coordinates.vert.spv",
-        "shader_repo/screen_coordinates/shaders/screen_coordinates.frag.spv")
+    : DefaultShaderLayer(parent, "ScreenCoordinatesShaderLayer", program())
 {
+    // one plain pass, nothing in the recording changes between frames
+    setCachedRecording(true);
+}
 
+ShaderProgramDesc ScreenCoordinatesShaderLayer::program() {
+    return {
+        "shader_repo/screen_coordinates/shaders/screen_coordinates.vert.spv",
+        "shader_repo/screen_coordinates/shaders/screen_coordinates.frag.spv"
+    };
 }
\ No newline at end of file
@@ -9,6 +9,8 @@ class ScreenCoordinatesShaderLayer final : public DefaultShaderLayer {
 public:
     explicit ScreenCoordinatesShaderLayer(EngineObject* parent);
     ~ScreenCoordinatesShaderLayer() override = default;
+
+    static ShaderProgramDesc program();
 };
 
 #endif // VK_SHADER_ENGINE_SCREEN_COORDINATES_SHADER_LAYER_H
\ No newline at end of file
@@ -16,6 +16,10 @@ void ScreenCoordinatesObject::onSetup() {
     pushLayer(new ScreenCoordinatesUILayer(this));
 }
 
+std::vector<ShaderProgramDesc> ScreenCoordinatesObject::shaderPrograms() {
+    return { ScreenCoordinatesShaderLayer::program() };
+}
+
 void ScreenCoordinatesObject::update(float deltaTime) {
     EngineObject::update(deltaTime);
 }
@@ -3,6 +3,7 @@
 #ifndef VK_SHADER_ENGINE_SCREEN_COORDINATES_H
 #define VK_SHADER_ENGINE_SCREEN_COORDINATES_H
 #include <core/engine_object.h>
+#include <core/pipeline_store.h>
 
 
 class ScreenCoordinatesObject final : public EngineObject {
@@ -12,6 +13,9 @@ public:
     void onSetup() override;
     void update(float deltaTime) override;
     void render(VkCommandBuffer cmd) override;
+
+    // picked up by SelectMenuObject::registerClass for pipeline prewarming
+    static std::vector<ShaderProgramDesc> shaderPrograms();
 };
 
 
@@ -15,12 +15,25 @@ SelectMenuObject::SelectMenuObject(Engine* e): EngineObject(e) {
 void SelectMenuObject::onSetup() {
     EngineObject::onSetup();
     
-    registerClass<PlasmaBallObject>("Plasma Ball");
-    registerClass<ScreenCoordinatesObject>("Screen Coordinates");
+    registerDemos();
+
+    // compile every demo's pipeline in the background while the menu is up, already built ones are skipped
+    engine->getPipelineStore().prewarm(getShaderPrograms(engine));
     
     pushLayer(new SelectMenuLayer(this));
 }
 
+SelectMenuObject::DemoRegistry& SelectMenuObject::registry() {
+    static DemoRegistry reg;
+    return reg;
+}
+
+void SelectMenuObject::registerDemos() {
+    registerClass<PlasmaBallObject>("Plasma Ball");
+    registerClass<PlasmaBallComputeObject>("Plasma Ball (Compute)");
+    registerClass<ScreenCoordinatesObject>("Screen Coordinates");
+}
+
 void SelectMenuObject::update(float deltaTime) {
     EngineObject::update(deltaTime);
 }
@@ -29,14 +42,41 @@ void SelectMenuObject::render(VkCommandBuffer cmd) {
     EngineObject::render(cmd);
 }
 
-const std::vector<std::string>& SelectMenuObject::getDemoNames() const {
-    return demo_names;
+const std::vector<std::string>& SelectMenuObject::getDemoNames() {
+    return registry().demo_names;
 }
 
-void SelectMenuObject::launchDemo(const std::string& name) {
+bool SelectMenuObject::isSupported(const std::string& name, const Engine* e) {
+    const auto& versions = registry().api_versions;
+    auto it = versions.find(name);
+    return it == versions.end() || e->getApiVersion() >= it->second;
+}
+
+std::vector<ShaderProgramDesc> SelectMenuObject::getShaderPrograms(const Engine* e) {
+    std::vector<ShaderProgramDesc> programs;
+    for (const auto& [name, program] : registry().shader_programs) {
+        if (isSupported(name, e)) programs.push_back(program);
+    }
+    return programs;
+}
+
+std::vector<std::string> SelectMenuObject::getAvailableDemos() const {
+    std::vector<std::string> demos;
+    for (const auto& name : getDemoNames()) {
+        if (isSupported(name, engine)) demos.push_back(name);
+    }
+    return demos;
+}
+
+EngineObject* SelectMenuObject::createDemo(const std::string& name, Engine* e) {
+    auto& repo_map = registry().repo_map;
     auto it = repo_map.find(name);
-    if (it != repo_map.end()) {
-        EngineObject* newApp = it->second(engine);
+    if (it == repo_map.end() || !isSupported(name, e)) return nullptr;
+    return it->second(e);
+}
+
+void SelectMenuObject::launchDemo(const std::string& name) {
+    if (EngineObject* newApp = createDemo(name, engine)) {
         engine->switchProject(newApp);
     }
 }
\ No newline at end of file
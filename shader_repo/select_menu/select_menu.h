@@ -4,11 +4,13 @@
 #define VK_SHADER_ENGINE_SELECT_MENU_H
 
 #include <core/engine_object.h>
+#include <core/pipeline_store.h>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <functional>
 #include <memory>
+#include <utility>
 
 class SelectMenuObject final : public EngineObject {
 public:
@@ -18,23 +20,55 @@ public:
     void update(float deltaTime) override;
     void render(VkCommandBuffer cmd) override;
 
-    const std::vector<std::string>& getDemoNames() const;
+    /*
+     * the demo registry is static so drivers without the menu (vk_shader_bench) can walk it too
+     * registerDemos() is idempotent
+     */
+    static void registerDemos();
+    static const std::vector<std::string>& getDemoNames();
+    // false for demos needing a newer vulkan than `e` runs (a static requiredApiVersion()), createDemo() skips them
+    static bool isSupported(const std::string& name, const Engine* e);
+    static EngineObject* createDemo(const std::string& name, Engine* e);
+    // every shader program the demos `e` supports declared, for pipeline prewarming
+    static std::vector<ShaderProgramDesc> getShaderPrograms(const Engine* e);
+
+    // getDemoNames() without the ones this engine can't run
+    std::vector<std::string> getAvailableDemos() const;
     void launchDemo(const std::string& name);
 
 private:
-    std::unordered_map<std::string, std::function<EngineObject*(Engine*)>> repo_map;
-    std::vector<std::string> demo_names;
-    
+    struct DemoRegistry {
+        std::unordered_map<std::string, std::function<EngineObject*(Engine*)>> repo_map;
+        std::vector<std::string> demo_names;
+        std::unordered_map<std::string, uint32_t> api_versions;
+        std::vector<std::pair<std::string, ShaderProgramDesc>> shader_programs; // demo name, program
+    };
+
+    static DemoRegistry& registry();
+
     template<typename T>
-    void registerClass(const std::string& name);
+    static void registerClass(const std::string& name);
 };
 
 template <typename T>
 void SelectMenuObject::registerClass(const std::string& name) {
-    repo_map[name] = [](Engine* e) {
+    DemoRegistry& reg = registry();
+    if (reg.repo_map.count(name)) return;
+
+    reg.repo_map[name] = [](Engine* e) {
         return new T(e);
     };
-    demo_names.push_back(name);
+    reg.demo_names.push_back(name);
+
+    if constexpr (requires { T::requiredApiVersion(); }) {
+        reg.api_versions[name] = T::requiredApiVersion();
+    }
+
+    // demos opt into prewarming by exposing a static shaderPrograms()
+    if constexpr (requires { T::shaderPrograms(); }) {
+        for (const auto& program : T::shaderPrograms())
+            reg.shader_programs.emplace_back(name, program);
+    }
 }
 
-#endif //VK_SHADER_ENGINE_SELECT_MENU_H
\ No newline at end of file
+#endif //VK_SHADER_ENGINE_SELECT_MENU_H
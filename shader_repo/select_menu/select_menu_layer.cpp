@@ -5,7 +5,8 @@
 #include <imgui/imgui.h>
 #include <engine.h>
 #include <util/viewport.h>
-#include <SDL3/SDL.h>
+#include <core/pipeline_store.h>
+#include <cstdio>
 
 // #include "sdl/include/SDL3/SDL_events.h"
 
@@ -55,12 +56,24 @@ void SelectMenuLayer::onUpdate(float deltaTime) {
         ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 1.0f, 1.0f, 1.0f)); // Cyan
         centerText("VK SHADER ENGINE", 2.0f);
         ImGui::PopStyleColor();
+
+        // background pipeline prewarm progress, hidden once everything is built
+        const auto& pipelines = engine->getPipelineStore();
+        const uint32_t prewarmTotal = pipelines.getPrewarmTotal();
+        const uint32_t prewarmDone = pipelines.getPrewarmDone();
+        if (prewarmDone < prewarmTotal) {
+            char progress[64];
+            snprintf(progress, sizeof(progress), "compiling pipelines %u/%u", prewarmDone, prewarmTotal);
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
+            centerText(progress);
+            ImGui::PopStyleColor();
+        }
         
         ImGui::Spacing();
         ImGui::Spacing();
         ImGui::Spacing();
 
-        const auto& demos = menuObject->getDemoNames();
+        const auto demos = menuObject->getAvailableDemos();
         int totalItems = static_cast<int>(demos.size()) + 1; // Demos + Quit button
         static int selectedIndex = 0;
 
@@ -114,9 +127,8 @@ void SelectMenuLayer::onUpdate(float deltaTime) {
         ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.9f, 0.2f, 0.2f, 1.0f));
         
         if (ImGui::Button("Quit", ImVec2(buttonWidth, buttonHeight)) || (isQuitSelected && triggerEnter)) {
-            SDL_Event quit_event{}; 
-            quit_event.type = SDL_EVENT_QUIT;
-            SDL_PushEvent(&quit_event);
+            // goes through the engine so the headless loop can be stopped the same way
+            engine->requestQuit();
         }
         
         if (ImGui::IsItemHovered()) selectedIndex = currentIndex;
@@ -0,0 +1,19 @@
+#version 450
+
+// stretches the rendered corner of a dynamic resolution target over the whole output
+
+layout(location = 0) in vec2 inUV;
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D scaledImage;
+
+layout(push_constant) uniform Upscale {
+    vec2 uvScale; // rendered size / image size
+    vec2 uvMax;   // last rendered texel center, keeps the filter off what wasn't drawn this frame
+} pc;
+
+void main()
+{
+    vec2 uv = min(inUV * pc.uvScale, pc.uvMax);
+    outColor = vec4(texture(scaledImage, uv).rgb, 1.0);
+}
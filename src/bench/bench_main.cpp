@@ -0,0 +1,353 @@
+// copyright 2025 swaroop.
+
+#include <SDL3/SDL_main.h>
+
+#include <engine.h>
+#include <bench/bench_report.h>
+#include <select_menu/select_menu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * vk_shader_bench
+ * runs every demo from the select menu registry headless, at a fixed set of resolutions
+ *
+ * --warmup <n>             frames rendered before measuring (default 120)
+ * --frames <n>             measured frames per demo and resolution (default 600)
+ * --res <w>x<h>[,...]      resolutions to sweep (default 1280x720,1920x1080,3840x2160)
+ * --demo <name>            only run the named demo, can be repeated
+ * --frames-in-flight <n>   engine frames in flight (default 2)
+ * --json <path>            json report (default bench_results.json)
+ * --csv <path>             csv report (default bench_results.csv)
+ * --compare-opt            run everything twice, from shaders.pack (spirv-opt) and shaders.none.pack (unoptimized),
+ *                          and report the difference, see add_shader_demo() in cmake/shader_demo.cmake
+ * --no-pipeline-library    build monolithic pipelines even where VK_EXT_graphics_pipeline_library is available
+ * --no-dynamic-rendering   draw through render passes and framebuffers even where VK_KHR_dynamic_rendering is available
+ * --recording-threads <n>  job workers recording layers that opted into parallel recording (default 0, all of them)
+ * --upload                 after the sweep, stream a texture and 64 MB of buffer copies through the UploadQueue while
+ *                          the first demo renders, on the transfer-only queue family and again on the graphics queue
+ */
+
+struct BenchOptions {
+    uint32_t warmupFrames = 120;
+    uint32_t measuredFrames = 600;
+    uint32_t framesInFlight = 2;
+    std::vector<std::pair<uint32_t, uint32_t>> resolutions;
+    std::vector<std::string> demos;
+    std::string jsonPath = "bench_results.json";
+    std::string csvPath = "bench_results.csv";
+    bool compareOpt = false;
+    bool pipelineLibraries = true;
+    bool dynamicRendering = true;
+    uint32_t recordingThreads = 0;
+    bool upload = false;
+};
+
+// label + pack, the labels match the variant names in shader_variants.json
+struct BenchVariant {
+    std::string name;
+    std::string packPath;
+};
+
+// fixed step so every run animates the shaders through the same time values
+static constexpr float kBenchDeltaTime = 1.0f / 60.0f;
+
+static bool parseArgs(int argc, char* argv[], BenchOptions& opts) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        const char* arg = argv[i];
+
+        if (strcmp(arg, "--warmup") == 0 && hasValue) {
+            opts.warmupFrames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--frames") == 0 && hasValue) {
+            opts.measuredFrames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--frames-in-flight") == 0 && hasValue) {
+            opts.framesInFlight = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--res") == 0 && hasValue) {
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                unsigned w = 0, h = 0;
+                if (sscanf(item.c_str(), "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+                    std::cerr << "bad resolution: " << item << "\n";
+                    return false;
+                }
+                opts.resolutions.emplace_back(w, h);
+            }
+        } else if (strcmp(arg, "--demo") == 0 && hasValue) {
+            opts.demos.emplace_back(argv[++i]);
+        } else if (strcmp(arg, "--json") == 0 && hasValue) {
+            opts.jsonPath = argv[++i];
+        } else if (strcmp(arg, "--csv") == 0 && hasValue) {
+            opts.csvPath = argv[++i];
+        } else if (strcmp(arg, "--compare-opt") == 0) {
+            opts.compareOpt = true;
+        } else if (strcmp(arg, "--no-pipeline-library") == 0) {
+            opts.pipelineLibraries = false;
+        } else if (strcmp(arg, "--no-dynamic-rendering") == 0) {
+            opts.dynamicRendering = false;
+        } else if (strcmp(arg, "--recording-threads") == 0 && hasValue) {
+            opts.recordingThreads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--upload") == 0) {
+            opts.upload = true;
+        } else {
+            std::cerr << "unknown argument: " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (opts.resolutions.empty()) {
+        opts.resolutions = { {1280, 720}, {1920, 1080}, {3840, 2160} };
+    }
+    opts.measuredFrames = std::max(1u, opts.measuredFrames);
+    return true;
+}
+
+static BenchResult runDemo(Engine& engine, const std::string& name, const std::string& variant, const BenchOptions& opts) {
+    using Clock = std::chrono::steady_clock;
+
+    engine.switchProject(SelectMenuObject::createDemo(name, &engine));
+
+    for (uint32_t i = 0; i < opts.warmupFrames; i++) {
+        engine.renderFrame(kBenchDeltaTime);
+    }
+
+    const uint64_t firstFrame = engine.getFrameCount() + 1;
+    const uint64_t lastFrame = firstFrame + opts.measuredFrames - 1;
+
+    std::vector<double> cpuSamples;
+    std::vector<double> gpuSamples;
+    cpuSamples.reserve(opts.measuredFrames);
+    gpuSamples.reserve(opts.measuredFrames);
+
+    uint64_t lastGpuFrame = engine.getGpuTimedFrame();
+    auto sampleGpu = [&]() {
+        const uint64_t timed = engine.getGpuTimedFrame();
+        if (timed != lastGpuFrame && timed >= firstFrame && timed <= lastFrame) {
+            gpuSamples.push_back(engine.getGpuFrameTimeMs());
+        }
+        lastGpuFrame = timed;
+    };
+
+    const auto runStart = Clock::now();
+    for (uint32_t i = 0; i < opts.measuredFrames; i++) {
+        const auto start = Clock::now();
+        engine.renderFrame(kBenchDeltaTime);
+        const auto end = Clock::now();
+
+        cpuSamples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        sampleGpu();
+    }
+    const double runSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+
+    // gpu results trail by framesInFlight, keep stepping until the measured frames have all reported
+    for (uint32_t i = 0; i < opts.framesInFlight && engine.hasGpuTimings(); i++) {
+        engine.renderFrame(kBenchDeltaTime);
+        sampleGpu();
+    }
+
+    BenchResult result;
+    result.demo = name;
+    result.variant = variant;
+    result.width = engine.getRenderExtent().width;
+    result.height = engine.getRenderExtent().height;
+    result.frames = opts.measuredFrames;
+    result.cpuMs = BenchStats::fromSamples(cpuSamples);
+    result.hasGpu = !gpuSamples.empty();
+    result.gpuMs = BenchStats::fromSamples(gpuSamples);
+
+    const double pixels = static_cast<double>(result.width) * static_cast<double>(result.height);
+    if (runSeconds > 0.0) {
+        result.mpixPerSec = pixels * opts.measuredFrames / runSeconds * 1e-6;
+    }
+    if (result.hasGpu && result.gpuMs.mean > 0.0) {
+        result.gpuMpixPerSec = pixels / (result.gpuMs.mean * 1e-3) * 1e-6;
+    }
+    return result;
+}
+
+// what --upload streams, a few chunks a frame the way a level streaming in would
+static constexpr VkDeviceSize kUploadBufferSize = 64ull * 1024 * 1024;
+static constexpr VkDeviceSize kUploadChunkSize = 1024 * 1024;
+static constexpr uint32_t kUploadChunksPerFrame = 4;
+static constexpr uint32_t kUploadImageSize = 1024;
+
+static void runUpload(Engine& engine, const std::string& demo, const BenchOptions& opts) {
+    using Clock = std::chrono::steady_clock;
+    UploadQueue& uploads = engine.getUploadQueue();
+    GpuAllocator& allocator = engine.getAllocator();
+
+    engine.switchProject(demo.empty() ? nullptr : SelectMenuObject::createDemo(demo, &engine));
+    for (uint32_t i = 0; i < opts.warmupFrames; i++) {
+        engine.renderFrame(kBenchDeltaTime);
+    }
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = kUploadBufferSize;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    GpuAllocation bufferMemory;
+    allocator.createBuffer(bufInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = { kUploadImageSize, kUploadImageSize, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage image = VK_NULL_HANDLE;
+    GpuAllocation imageMemory;
+    allocator.createImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+
+    // generated up front, the timed part is staging and copying only
+    std::vector<uint32_t> chunk(kUploadChunkSize / sizeof(uint32_t));
+    for (size_t i = 0; i < chunk.size(); i++) chunk[i] = static_cast<uint32_t>(i * 2654435761u);
+    std::vector<uint32_t> texels(static_cast<size_t>(kUploadImageSize) * kUploadImageSize);
+    for (size_t i = 0; i < texels.size(); i++) texels[i] = 0xff000000u | static_cast<uint32_t>(i);
+
+    std::vector<double> cpuSamples;
+    auto timedFrame = [&]() {
+        const auto start = Clock::now();
+        engine.renderFrame(kBenchDeltaTime);
+        cpuSamples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    };
+
+    const auto start = Clock::now();
+    uint64_t last = uploads.uploadImage(image, imageInfo.extent, texels.data(), texels.size() * sizeof(uint32_t));
+    for (VkDeviceSize offset = 0; offset < kUploadBufferSize;) {
+        for (uint32_t i = 0; i < kUploadChunksPerFrame && offset < kUploadBufferSize; i++, offset += kUploadChunkSize) {
+            last = uploads.uploadBuffer(buffer, offset, chunk.data(), kUploadChunkSize);
+        }
+        timedFrame();
+    }
+    // frames keep going while the last copies land, nothing on the render thread waits for them
+    while (!uploads.isComplete(last)) timedFrame();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // the next frame records the acquires of the last batch, after that the gpu can let go of both
+    engine.renderFrame(kBenchDeltaTime);
+    vkDeviceWaitIdle(engine.getDevice());
+    allocator.destroyBuffer(buffer, bufferMemory);
+    allocator.destroyImage(image, imageMemory);
+    engine.switchProject(nullptr);
+
+    const double mb = static_cast<double>(kUploadBufferSize + texels.size() * sizeof(uint32_t)) / (1024.0 * 1024.0);
+    const BenchStats cpu = BenchStats::fromSamples(cpuSamples);
+    printf("[bench] upload, %s queue: %.0f MB in %.1f ms (%.0f MB/s), %zu frames at %.2f ms cpu mean / %.2f ms p99\n",
+           uploads.hasDedicatedQueue() ? "transfer" : "graphics", mb, seconds * 1e3, seconds > 0.0 ? mb / seconds : 0.0,
+           cpuSamples.size(), cpu.mean, cpu.p99);
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts)) return 2;
+
+    SelectMenuObject::registerDemos();
+
+    std::vector<std::string> demos = opts.demos.empty() ? SelectMenuObject::getDemoNames() : opts.demos;
+    BenchReport report;
+
+    // an empty name keeps the engine's default pack and leaves the variant out of the report
+    std::vector<BenchVariant> variants = { { "", EngineConfig{}.shaderPackPath } };
+    if (opts.compareOpt) {
+        variants = { { "none", "shaders.none.pack" }, { "opt", "shaders.pack" } };
+    }
+
+    try {
+        for (const auto& [width, height] : opts.resolutions) {
+            for (const auto& variant : variants) {
+                EngineConfig config{};
+                config.headless = true;
+                config.width = width;
+                config.height = height;
+                config.framesInFlight = opts.framesInFlight;
+                config.shaderPackPath = variant.packPath;
+                config.pipelineLibraries = opts.pipelineLibraries;
+                config.dynamicRendering = opts.dynamicRendering;
+                config.recordingThreads = opts.recordingThreads;
+
+                Engine engine(config);
+
+                // falling back to loose spir-v would compare a variant against itself
+                if (!variant.name.empty() && !engine.getShaderPack().isOpen()) {
+                    std::cerr << variant.packPath << " not found, build the shader_pack target first\n";
+                    return 1;
+                }
+
+                for (const auto& name : demos) {
+                    const auto& known = SelectMenuObject::getDemoNames();
+                    if (std::find(known.begin(), known.end(), name) == known.end()) {
+                        std::cerr << "unknown demo: " << name << "\n";
+                        continue;
+                    }
+                    if (!SelectMenuObject::isSupported(name, &engine)) {
+                        printf("[bench] %s needs a newer vulkan version than the device has, skipped\n", name.c_str());
+                        continue;
+                    }
+
+                    if (variant.name.empty()) {
+                        printf("[bench] %s @ %ux%u\n", name.c_str(), width, height);
+                    } else {
+                        printf("[bench] %s (%s) @ %ux%u\n", name.c_str(), variant.name.c_str(), width, height);
+                    }
+                    report.add(runDemo(engine, name, variant.name, opts));
+                }
+                engine.switchProject(nullptr);
+            }
+        }
+
+        if (opts.upload) {
+            const auto& known = SelectMenuObject::getDemoNames();
+            const bool hasDemo = !demos.empty() && std::find(known.begin(), known.end(), demos.front()) != known.end();
+
+            // the same copies once per path, the queue family is picked when the device is created
+            for (const bool transferQueue : { true, false }) {
+                EngineConfig config{};
+                config.headless = true;
+                config.width = opts.resolutions.front().first;
+                config.height = opts.resolutions.front().second;
+                config.framesInFlight = opts.framesInFlight;
+                config.pipelineLibraries = opts.pipelineLibraries;
+                config.dynamicRendering = opts.dynamicRendering;
+                config.recordingThreads = opts.recordingThreads;
+                config.transferQueue = transferQueue;
+
+                Engine engine(config);
+                if (transferQueue && !engine.getUploadQueue().hasDedicatedQueue()) {
+                    printf("[bench] no queue family besides the graphics one, upload runs on the graphics queue only\n");
+                    continue;
+                }
+                runUpload(engine, hasDemo ? demos.front() : std::string(), opts);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "fatal error: " << e.what() << "\n";
+        return 1;
+    }
+
+    report.print();
+    if (opts.compareOpt) report.printComparison("none", "opt");
+
+    if (!opts.jsonPath.empty() && !report.writeJson(opts.jsonPath))
+        std::cerr << "could not write " << opts.jsonPath << "\n";
+    if (!opts.csvPath.empty() && !report.writeCsv(opts.csvPath))
+        std::cerr << "could not write " << opts.csvPath << "\n";
+
+    return 0;
+}
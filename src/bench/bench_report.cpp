@@ -0,0 +1,145 @@
+// copyright 2025 swaroop.
+
+#include <bench/bench_report.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+BenchStats BenchStats::fromSamples(std::vector<double> samples) {
+    BenchStats stats{};
+    if (samples.empty()) return stats;
+
+    std::sort(samples.begin(), samples.end());
+
+    // nearest-rank percentile
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(samples.size())));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+
+    stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    return stats;
+}
+
+void BenchReport::print() const {
+    printf("%-24s %-8s %11s %9s %9s %9s %9s %9s %9s %10s\n",
+           "demo", "variant", "resolution", "cpu p50", "cpu p95", "cpu p99", "gpu p50", "gpu p95", "gpu p99", "Mpix/s");
+
+    for (const auto& r : results) {
+        char res[32];
+        snprintf(res, sizeof(res), "%ux%u", r.width, r.height);
+
+        if (r.hasGpu) {
+            printf("%-24s %-8s %11s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %10.1f\n",
+                   r.demo.c_str(), r.variant.empty() ? "-" : r.variant.c_str(), res, r.cpuMs.p50, r.cpuMs.p95, r.cpuMs.p99,
+                   r.gpuMs.p50, r.gpuMs.p95, r.gpuMs.p99, r.mpixPerSec);
+        } else {
+            printf("%-24s %-8s %11s %9.3f %9.3f %9.3f %9s %9s %9s %10.1f\n",
+                   r.demo.c_str(), r.variant.empty() ? "-" : r.variant.c_str(), res, r.cpuMs.p50, r.cpuMs.p95, r.cpuMs.p99,
+                   "-", "-", "-", r.mpixPerSec);
+        }
+    }
+}
+
+void BenchReport::printComparison(const std::string& baseline, const std::string& candidate) const {
+    printf("\n%s vs %s\n", candidate.c_str(), baseline.c_str());
+    printf("%-24s %11s %5s %11s %11s %9s %11s %11s\n",
+           "demo", "resolution", "time", (baseline + " ms").c_str(), (candidate + " ms").c_str(), "delta",
+           (baseline + " ns/px").c_str(), (candidate + " ns/px").c_str());
+
+    for (const auto& c : results) {
+        if (c.variant != candidate) continue;
+
+        auto base = std::find_if(results.begin(), results.end(), [&](const BenchResult& r) {
+            return r.variant == baseline && r.demo == c.demo && r.width == c.width && r.height == c.height;
+        });
+        if (base == results.end()) continue;
+
+        // the frame is one fullscreen triangle, so gpu time is the fragment cost; cpu time only when there's no gpu timing
+        const bool gpu = c.hasGpu && base->hasGpu;
+        const double baseMs = gpu ? base->gpuMs.mean : base->cpuMs.mean;
+        const double candMs = gpu ? c.gpuMs.mean : c.cpuMs.mean;
+        const double pixels = static_cast<double>(c.width) * static_cast<double>(c.height);
+        const double delta = baseMs > 0.0 ? (candMs - baseMs) / baseMs * 100.0 : 0.0;
+
+        char res[32];
+        snprintf(res, sizeof(res), "%ux%u", c.width, c.height);
+        printf("%-24s %11s %5s %11.3f %11.3f %8.1f%% %11.3f %11.3f\n",
+               c.demo.c_str(), res, gpu ? "gpu" : "cpu", baseMs, candMs, delta,
+               baseMs * 1e6 / pixels, candMs * 1e6 / pixels);
+    }
+}
+
+static std::string jsonEscape(const std::string& in) {
+    std::string out;
+    for (char c : in) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static void writeStatsJson(std::ofstream& out, const char* name, const BenchStats& s) {
+    out << "      \"" << name << "\": { "
+        << "\"mean\": " << s.mean << ", \"min\": " << s.min << ", \"max\": " << s.max
+        << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95 << ", \"p99\": " << s.p99 << " }";
+}
+
+bool BenchReport::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << "    {\n"
+            << "      \"demo\": \"" << jsonEscape(r.demo) << "\",\n";
+        if (!r.variant.empty()) out << "      \"variant\": \"" << jsonEscape(r.variant) << "\",\n";
+        out << "      \"width\": " << r.width << ",\n"
+            << "      \"height\": " << r.height << ",\n"
+            << "      \"frames\": " << r.frames << ",\n";
+        writeStatsJson(out, "cpu_ms", r.cpuMs);
+        out << ",\n";
+        if (r.hasGpu) {
+            writeStatsJson(out, "gpu_ms", r.gpuMs);
+            out << ",\n";
+            out << "      \"gpu_mpix_per_s\": " << r.gpuMpixPerSec << ",\n";
+        }
+        out << "      \"mpix_per_s\": " << r.mpixPerSec << "\n"
+            << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.good();
+}
+
+bool BenchReport::writeCsv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "demo,variant,width,height,frames,"
+           "cpu_mean_ms,cpu_p50_ms,cpu_p95_ms,cpu_p99_ms,"
+           "gpu_mean_ms,gpu_p50_ms,gpu_p95_ms,gpu_p99_ms,"
+           "mpix_per_s,gpu_mpix_per_s\n";
+
+    for (const auto& r : results) {
+        out << '"' << r.demo << "\"," << r.variant << ',' << r.width << ',' << r.height << ',' << r.frames << ','
+            << r.cpuMs.mean << ',' << r.cpuMs.p50 << ',' << r.cpuMs.p95 << ',' << r.cpuMs.p99 << ',';
+        if (r.hasGpu) {
+            out << r.gpuMs.mean << ',' << r.gpuMs.p50 << ',' << r.gpuMs.p95 << ',' << r.gpuMs.p99 << ',';
+        } else {
+            out << ",,,,";
+        }
+        out << r.mpixPerSec << ',';
+        if (r.hasGpu) out << r.gpuMpixPerSec;
+        out << '\n';
+    }
+    return out.good();
+}
@@ -0,0 +1,46 @@
+// copyright 2025 swaroop.
+
+#include <core/deletion_queue.h>
+
+#include <iterator>
+#include <vector>
+
+void DeletionQueue::retire(uint64_t lastUsedFrame, std::function<void()> deleter) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // retire calls may come in slightly out of order, keep the deque sorted so collect can stop early
+    auto it = entries.end();
+    while (it != entries.begin() && std::prev(it)->frame > lastUsedFrame) --it;
+    entries.insert(it, { lastUsedFrame, std::move(deleter) });
+}
+
+void DeletionQueue::collect(uint64_t completedFrame) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!entries.empty() && entries.front().frame <= completedFrame) {
+            ready.push_back(std::move(entries.front().deleter));
+            entries.pop_front();
+        }
+    }
+
+    // run outside the lock, a deleter is allowed to retire something else
+    for (auto& deleter : ready) deleter();
+}
+
+void DeletionQueue::flush() {
+    while (true) {
+        std::deque<Entry> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (entries.empty()) return;
+            pending.swap(entries);
+        }
+        for (auto& entry : pending) entry.deleter();
+    }
+}
+
+size_t DeletionQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
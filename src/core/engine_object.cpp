@@ -5,6 +5,7 @@
 #include <engine.h>
 #include <algorithm>
 #include <cstdio>
+#include <mutex>
 
 
 EngineObject::EngineObject(Engine* engineRef) : engine(engineRef) {
@@ -20,18 +21,26 @@ EngineObject::~EngineObject() {
 
 void EngineObject::pushLayer(LayerComponent* layer) {
     layer->setEngine(engine);
-    
-    layerStack.push_back(layer);
+    // attached before the simulation thread can see it, onStep never runs on a layer that isn't set up yet
     layer->onAttach();
     
+    {
+        // the simulation thread walks the stack while stepping
+        std::lock_guard<std::mutex> lock(engine->simulation.getStepMutex());
+        layerStack.push_back(layer);
+    }
+    
     printf("[%s] pushed render layer: %s\n", objName.c_str(), layer->getName().c_str());
 }
 
 void EngineObject::popLayer(LayerComponent* layer) {
     auto it = std::find(layerStack.begin(), layerStack.end(), layer);
     if (it != layerStack.end()) {
+        {
+            std::lock_guard<std::mutex> lock(engine->simulation.getStepMutex());
+            layerStack.erase(it);
+        }
         layer->onDetach();
-        layerStack.erase(it);
         printf("[%s] render popped layer: %s\n", objName.c_str(), layer->getName().c_str());
     }
 }
@@ -42,12 +51,30 @@ void EngineObject::update(float deltaTime) {
     }
 }
 
+void EngineObject::buildGraph(RenderGraph& graph) {
+    for (LayerComponent* layer : layerStack) {
+        layer->onBuildGraph(graph);
+    }
+}
+
 void EngineObject::render(VkCommandBuffer cmd) {
     for (LayerComponent* layer : layerStack) {
         layer->onRender(cmd);
     }
 }
 
+bool EngineObject::hasParallelLayers() const {
+    return std::any_of(layerStack.begin(), layerStack.end(), [](const LayerComponent* layer) {
+        return layer->isParallelRecording();
+    });
+}
+
+bool EngineObject::hasCachedLayers() const {
+    return std::any_of(layerStack.begin(), layerStack.end(), [](const LayerComponent* layer) {
+        return layer->getRecordingKey() != 0;
+    });
+}
+
 Engine* EngineObject::getEngine() const {
     return engine;
 }
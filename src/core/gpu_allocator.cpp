@@ -0,0 +1,380 @@
+// copyright 2025 swaroop.
+
+#include <core/gpu_allocator.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+
+struct GpuMemoryBlock {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    uint8_t* mapped = nullptr;
+    uint32_t memoryType = 0;
+    GpuAllocator::Kind kind = GpuAllocator::Kind::Buffer;
+
+    // level 0 is the whole block, every level below halves the size
+    std::vector<std::set<VkDeviceSize>> freeLists;
+    VkDeviceSize used = 0;
+    uint32_t allocations = 0;
+
+    VkDeviceSize levelSize(uint32_t level) const { return size >> level; }
+};
+
+namespace {
+    VkDeviceSize nextPow2(VkDeviceSize v) {
+        VkDeviceSize p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    VkDeviceSize prevPow2(VkDeviceSize v) {
+        VkDeviceSize p = 1;
+        while ((p << 1) <= v) p <<= 1;
+        return p;
+    }
+
+    VkDeviceSize alignDown(VkDeviceSize v, VkDeviceSize a) { return v / a * a; }
+    VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize a) { return (v + a - 1) / a * a; }
+}
+
+GpuAllocator::GpuAllocator() = default;
+GpuAllocator::~GpuAllocator() = default;
+
+void GpuAllocator::init(VkPhysicalDevice gpu, VkDevice deviceRef) {
+    device = deviceRef;
+
+    // queried once, layers used to ask the driver again for every buffer they created
+    vkGetPhysicalDeviceMemoryProperties(gpu, &memoryProps);
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(gpu, &props);
+    nonCoherentAtomSize = std::max<VkDeviceSize>(1, props.limits.nonCoherentAtomSize);
+
+    pools.resize(memoryProps.memoryTypeCount * 2);
+    blockSizes.resize(memoryProps.memoryTypeCount);
+
+    // small heaps (host visible vram windows, integrated carve-outs) get smaller blocks so one block can't eat them
+    for (uint32_t i = 0; i < memoryProps.memoryTypeCount; i++) {
+        const VkDeviceSize heapSize = memoryProps.memoryHeaps[memoryProps.memoryTypes[i].heapIndex].size;
+        blockSizes[i] = std::clamp(prevPow2(heapSize / 8), MIN_BLOCK_SIZE, DEFAULT_BLOCK_SIZE);
+    }
+}
+
+void GpuAllocator::shutdown() {
+    if (!device) return;
+
+    printStats();
+    if (stats.allocationCount > 0)
+        printf("[gpu allocator] %u allocations still alive at shutdown\n", stats.allocationCount);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& pool : pools) {
+        for (auto& block : pool.blocks) {
+            if (block->mapped) vkUnmapMemory(device, block->memory);
+            vkFreeMemory(device, block->memory, nullptr);
+        }
+        pool.blocks.clear();
+    }
+    pools.clear();
+    stats = {};
+    device = VK_NULL_HANDLE;
+}
+
+uint32_t GpuAllocator::findMemoryType(uint32_t filter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const {
+    const VkMemoryPropertyFlags wanted = required | preferred;
+    for (uint32_t i = 0; i < memoryProps.memoryTypeCount; i++)
+        if ((filter & (1u << i)) && (memoryProps.memoryTypes[i].propertyFlags & wanted) == wanted) return i;
+    for (uint32_t i = 0; i < memoryProps.memoryTypeCount; i++)
+        if ((filter & (1u << i)) && (memoryProps.memoryTypes[i].propertyFlags & required) == required) return i;
+    throw std::runtime_error("no suitable memory type");
+}
+
+bool GpuAllocator::isCoherent(const GpuAllocation& allocation) const {
+    return (memoryProps.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& reqs, VkMemoryPropertyFlags required, Kind kind,
+                                     VkMemoryPropertyFlags preferred) {
+    // candidate types in order: everything with the preferred flags, then whatever only meets the requirement
+    std::vector<uint32_t> candidates;
+    for (int pass = 0; pass < 2; pass++) {
+        const VkMemoryPropertyFlags wanted = pass == 0 ? (required | preferred) : required;
+        if (pass == 1 && preferred == 0) break;
+        for (uint32_t i = 0; i < memoryProps.memoryTypeCount; i++) {
+            if (!(reqs.memoryTypeBits & (1u << i))) continue;
+            if ((memoryProps.memoryTypes[i].propertyFlags & wanted) != wanted) continue;
+            if (std::find(candidates.begin(), candidates.end(), i) == candidates.end()) candidates.push_back(i);
+        }
+    }
+    if (candidates.empty()) throw std::runtime_error("no suitable memory type");
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    GpuAllocation allocation;
+    for (uint32_t type : candidates) {
+        const bool dedicated = reqs.size > blockSizes[type] / 2;
+        const bool ok = dedicated
+            ? allocateDedicated(type, reqs.size, allocation)
+            : tryAllocate(type, kind, reqs.size, reqs.alignment, allocation);
+        if (!ok) continue;
+
+        stats.allocationCount++;
+        stats.peakDeviceAllocations = std::max(stats.peakDeviceAllocations, stats.blockCount + stats.dedicatedCount);
+        return allocation;
+    }
+    throw std::runtime_error("gpu allocator out of memory");
+}
+
+bool GpuAllocator::tryAllocate(uint32_t memoryType, Kind kind, VkDeviceSize size, VkDeviceSize alignment, GpuAllocation& out) {
+    // buddy ranges are aligned to their own size, so rounding up to the alignment is all it takes
+    const VkDeviceSize need = nextPow2(std::max({ size, alignment, MIN_ALLOCATION }));
+
+    Pool& pool = pools[memoryType * 2 + static_cast<uint32_t>(kind)];
+
+    auto fromBlock = [&](GpuMemoryBlock& block) {
+        uint32_t target = 0;
+        while (block.levelSize(target + 1) >= need && target + 1 < block.freeLists.size()) target++;
+
+        // smallest free range that fits, then split it down to the target size
+        int level = static_cast<int>(target);
+        while (level >= 0 && block.freeLists[level].empty()) level--;
+        if (level < 0) return false;
+
+        const VkDeviceSize offset = *block.freeLists[level].begin();
+        block.freeLists[level].erase(block.freeLists[level].begin());
+        for (uint32_t l = static_cast<uint32_t>(level) + 1; l <= target; l++) {
+            block.freeLists[l].insert(offset + block.levelSize(l));
+        }
+
+        block.used += block.levelSize(target);
+        block.allocations++;
+        stats.usedBytes += block.levelSize(target);
+
+        out.memory = block.memory;
+        out.offset = offset;
+        out.size = size;
+        out.mapped = block.mapped ? block.mapped + offset : nullptr;
+        out.memoryType = memoryType;
+        out.block = &block;
+        out.level = target;
+        return true;
+    };
+
+    for (auto& block : pool.blocks) {
+        if (block->size - block->used >= need && fromBlock(*block)) return true;
+    }
+
+    GpuMemoryBlock* block = createBlock(memoryType, kind);
+    return block && fromBlock(*block);
+}
+
+bool GpuAllocator::allocateDedicated(uint32_t memoryType, VkDeviceSize size, GpuAllocation& out) {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) return false;
+
+    void* mapped = nullptr;
+    if (memoryProps.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, memory, nullptr);
+            return false;
+        }
+    }
+
+    stats.dedicatedCount++;
+    stats.reservedBytes += size;
+    stats.usedBytes += size;
+
+    out.memory = memory;
+    out.offset = 0;
+    out.size = size;
+    out.mapped = mapped;
+    out.memoryType = memoryType;
+    out.block = nullptr;
+    out.level = 0;
+    return true;
+}
+
+GpuMemoryBlock* GpuAllocator::createBlock(uint32_t memoryType, Kind kind) {
+    const VkDeviceSize size = blockSizes[memoryType];
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    auto block = std::make_unique<GpuMemoryBlock>();
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) return nullptr;
+
+    if (memoryProps.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        void* mapped = nullptr;
+        if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, block->memory, nullptr);
+            return nullptr;
+        }
+        block->mapped = static_cast<uint8_t*>(mapped);
+    }
+
+    block->size = size;
+    block->memoryType = memoryType;
+    block->kind = kind;
+
+    uint32_t levels = 1;
+    while ((size >> levels) >= MIN_ALLOCATION) levels++;
+    block->freeLists.resize(levels);
+    block->freeLists[0].insert(0);
+
+    stats.blockCount++;
+    stats.reservedBytes += size;
+
+    Pool& pool = pools[memoryType * 2 + static_cast<uint32_t>(kind)];
+    pool.blocks.push_back(std::move(block));
+    return pool.blocks.back().get();
+}
+
+void GpuAllocator::free(const GpuAllocation& allocation) {
+    if (!allocation.memory) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.allocationCount--;
+
+    if (!allocation.block) {
+        if (allocation.mapped) vkUnmapMemory(device, allocation.memory);
+        vkFreeMemory(device, allocation.memory, nullptr);
+        stats.dedicatedCount--;
+        stats.reservedBytes -= allocation.size;
+        stats.usedBytes -= allocation.size;
+        return;
+    }
+
+    GpuMemoryBlock& block = *allocation.block;
+    VkDeviceSize offset = allocation.offset;
+    uint32_t level = allocation.level;
+
+    block.used -= block.levelSize(level);
+    block.allocations--;
+    stats.usedBytes -= block.levelSize(level);
+
+    // merge with the buddy for as long as it is free too
+    while (level > 0) {
+        const VkDeviceSize buddy = offset ^ block.levelSize(level);
+        auto it = block.freeLists[level].find(buddy);
+        if (it == block.freeLists[level].end()) break;
+
+        block.freeLists[level].erase(it);
+        offset = std::min(offset, buddy);
+        level--;
+    }
+    block.freeLists[level].insert(offset);
+
+    // keep one block per pool around so a layer switch doesn't free and reallocate it
+    Pool& pool = pools[block.memoryType * 2 + static_cast<uint32_t>(block.kind)];
+    if (block.allocations == 0 && pool.blocks.size() > 1) {
+        if (block.mapped) vkUnmapMemory(device, block.memory);
+        vkFreeMemory(device, block.memory, nullptr);
+        stats.blockCount--;
+        stats.reservedBytes -= block.size;
+
+        pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(),
+            [&](const auto& b) { return b.get() == &block; }));
+    }
+}
+
+void GpuAllocator::createBuffer(const VkBufferCreateInfo& info, VkMemoryPropertyFlags required,
+                                VkBuffer& buffer, GpuAllocation& allocation, VkMemoryPropertyFlags preferred) {
+    if (vkCreateBuffer(device, &info, nullptr, &buffer) != VK_SUCCESS)
+        throw std::runtime_error("buffer creation failed");
+
+    VkMemoryRequirements reqs;
+    vkGetBufferMemoryRequirements(device, buffer, &reqs);
+
+    try {
+        allocation = allocate(reqs, required, Kind::Buffer, preferred);
+    } catch (...) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        throw;
+    }
+
+    if (vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        destroyBuffer(buffer, allocation);
+        buffer = VK_NULL_HANDLE;
+        allocation = {};
+        throw std::runtime_error("buffer memory bind failed");
+    }
+}
+
+void GpuAllocator::createImage(const VkImageCreateInfo& info, VkMemoryPropertyFlags required,
+                               VkImage& image, GpuAllocation& allocation, VkMemoryPropertyFlags preferred) {
+    if (vkCreateImage(device, &info, nullptr, &image) != VK_SUCCESS)
+        throw std::runtime_error("image creation failed");
+
+    VkMemoryRequirements reqs;
+    vkGetImageMemoryRequirements(device, image, &reqs);
+
+    // linear images follow the same granularity rules as buffers
+    const Kind kind = info.tiling == VK_IMAGE_TILING_LINEAR ? Kind::Buffer : Kind::Image;
+
+    try {
+        allocation = allocate(reqs, required, kind, preferred);
+    } catch (...) {
+        vkDestroyImage(device, image, nullptr);
+        image = VK_NULL_HANDLE;
+        throw;
+    }
+
+    if (vkBindImageMemory(device, image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        destroyImage(image, allocation);
+        image = VK_NULL_HANDLE;
+        allocation = {};
+        throw std::runtime_error("image memory bind failed");
+    }
+}
+
+void GpuAllocator::destroyBuffer(VkBuffer buffer, const GpuAllocation& allocation) {
+    if (buffer) vkDestroyBuffer(device, buffer, nullptr);
+    free(allocation);
+}
+
+void GpuAllocator::destroyImage(VkImage image, const GpuAllocation& allocation) {
+    if (image) vkDestroyImage(device, image, nullptr);
+    free(allocation);
+}
+
+void GpuAllocator::flush(const GpuAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (!allocation.mapped || isCoherent(allocation)) return;
+
+    if (size == VK_WHOLE_SIZE) size = allocation.size - offset;
+
+    // flush ranges have to be nonCoherentAtomSize aligned, clamped to the end of the VkDeviceMemory
+    const VkDeviceSize memorySize = allocation.block ? allocation.block->size : allocation.size;
+    const VkDeviceSize begin = alignDown(allocation.offset + offset, nonCoherentAtomSize);
+    const VkDeviceSize end = std::min(alignUp(allocation.offset + offset + size, nonCoherentAtomSize), memorySize);
+
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = allocation.memory;
+    range.offset = begin;
+    range.size = end == memorySize ? VK_WHOLE_SIZE : end - begin;
+    vkFlushMappedMemoryRanges(device, 1, &range);
+}
+
+GpuAllocator::Stats GpuAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void GpuAllocator::printStats() const {
+    const Stats s = getStats();
+    printf("[gpu allocator] %u allocations in %u blocks + %u dedicated, %.2f / %.2f MiB used, peak %u device allocations\n",
+           s.allocationCount, s.blockCount, s.dedicatedCount,
+           static_cast<double>(s.usedBytes) / (1024.0 * 1024.0),
+           static_cast<double>(s.reservedBytes) / (1024.0 * 1024.0),
+           s.peakDeviceAllocations);
+}
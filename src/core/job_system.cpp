@@ -0,0 +1,332 @@
+// copyright 2025 swaroop.
+
+#include <core/job_system.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct JobSystem::Job {
+    std::function<void()> fn;
+    bool mainThread = false;
+    std::atomic<uint32_t> waitingOn{0}; // unfinished dependencies
+    std::atomic<bool> done{false};
+    std::exception_ptr error;
+
+    // jobs to release when this one finishes, guarded together with the switch to done
+    std::mutex mutex;
+    std::vector<Handle> continuations;
+};
+
+namespace {
+    // which pool and queue the current thread works for, so a worker's submissions land in its own deque
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local uint32_t currentWorker = 0;
+
+    void pinThread(std::thread& thread, uint32_t cpu) {
+#ifdef _WIN32
+        if (!SetThreadAffinityMask(static_cast<HANDLE>(thread.native_handle()), DWORD_PTR(1) << cpu))
+            printf("[jobs] could not pin a worker to cpu %u\n", cpu);
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) != 0)
+            printf("[jobs] could not pin a worker to cpu %u\n", cpu);
+#else
+        // no hard affinity on macos
+        (void)thread;
+        (void)cpu;
+#endif
+    }
+}
+
+void JobSystem::init(uint32_t workerCount, const std::vector<uint32_t>& affinity) {
+    mainThread = std::this_thread::get_id();
+    stopping = false;
+
+    const uint32_t hw = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t count = workerCount ? workerCount : (hw > 1 ? hw - 1 : 1u);
+
+    queues.clear();
+    for (uint32_t i = 0; i < count + 1; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+        if (!affinity.empty()) pinThread(workers.back(), affinity[i % affinity.size()]);
+    }
+}
+
+void JobSystem::shutdown() {
+    if (workers.empty()) return;
+
+    // layers hand jobs pointers to themselves, none may still be queued once they are gone
+    waitIdle();
+
+    stopping = true;
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    workAvailable.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+    queues.clear();
+}
+
+JobSystem::Handle JobSystem::submit(std::function<void()> fn, const std::vector<Handle>& dependencies) {
+    return create(std::move(fn), false, dependencies);
+}
+
+JobSystem::Handle JobSystem::submitMainThread(std::function<void()> fn, const std::vector<Handle>& dependencies) {
+    return create(std::move(fn), true, dependencies);
+}
+
+JobSystem::Handle JobSystem::create(std::function<void()> fn, bool onMainThread, const std::vector<Handle>& dependencies) {
+    auto job = std::make_shared<Job>();
+    job->fn = std::move(fn);
+    job->mainThread = onMainThread;
+    pending++;
+
+    // one extra count held while dependencies are registered, so a dependency finishing meanwhile can't schedule it
+    job->waitingOn = static_cast<uint32_t>(dependencies.size()) + 1;
+    for (const auto& dep : dependencies) {
+        bool finished = true;
+        if (dep) {
+            std::lock_guard<std::mutex> lock(dep->mutex);
+            if (!dep->done) {
+                dep->continuations.push_back(job);
+                finished = false;
+            }
+        }
+        if (finished) job->waitingOn--;
+    }
+    if (job->waitingOn.fetch_sub(1) == 1) schedule(job);
+    return job;
+}
+
+void JobSystem::schedule(const Handle& job) {
+    if (job->mainThread) {
+        {
+            std::lock_guard<std::mutex> lock(mainMutex);
+            mainJobs.push_back(job);
+        }
+        notifyWaiters();
+        return;
+    }
+
+    // a join has nothing to run, no point queueing it
+    if (!job->fn) {
+        execute(job);
+        return;
+    }
+
+    Queue& queue = currentSystem == this ? *queues[currentWorker] : *queues.back();
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    queued++;
+
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    workAvailable.notify_one();
+    notifyWaiters();
+}
+
+void JobSystem::execute(const Handle& job) {
+    if (job->fn) {
+        try {
+            job->fn();
+        } catch (const std::exception& e) {
+            job->error = std::current_exception();
+            printf("[jobs] job failed: %s\n", e.what());
+        } catch (...) {
+            job->error = std::current_exception();
+            printf("[jobs] job failed\n");
+        }
+        job->fn = nullptr; // drop whatever it captured now rather than with the last handle
+    }
+
+    std::vector<Handle> released;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->done = true;
+        released.swap(job->continuations);
+    }
+    for (const auto& next : released) {
+        if (next->waitingOn.fetch_sub(1) == 1) schedule(next);
+    }
+
+    pending--;
+    notifyWaiters();
+}
+
+void JobSystem::notifyWaiters() {
+    if (waiters == 0) return;
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    stateChanged.notify_all();
+}
+
+JobSystem::Handle JobSystem::take() {
+    const uint32_t shared = static_cast<uint32_t>(queues.size()) - 1;
+    const uint32_t self = currentSystem == this ? currentWorker : shared;
+    Handle job;
+
+    // own work newest first, it is the most likely to still be in cache
+    if (self != shared) {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+
+    if (!job) {
+        Queue& outside = *queues[shared];
+        std::lock_guard<std::mutex> lock(outside.mutex);
+        if (!outside.jobs.empty()) {
+            job = std::move(outside.jobs.front());
+            outside.jobs.pop_front();
+        }
+    }
+
+    // steal the oldest, starting after ourselves so thieves spread over the victims
+    for (uint32_t i = 0; !job && i < shared; i++) {
+        const uint32_t victim = (self + 1 + i) % shared;
+        if (victim == self) continue;
+
+        Queue& other = *queues[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.jobs.empty()) {
+            job = std::move(other.jobs.front());
+            other.jobs.pop_front();
+        }
+    }
+
+    if (job) queued--;
+    return job;
+}
+
+bool JobSystem::runOne() {
+    Handle job = take();
+    if (!job && isMainThread()) {
+        std::lock_guard<std::mutex> lock(mainMutex);
+        if (!mainJobs.empty()) {
+            job = std::move(mainJobs.front());
+            mainJobs.pop_front();
+        }
+    }
+    if (!job) return false;
+
+    execute(job);
+    return true;
+}
+
+bool JobSystem::hasMainJobs() {
+    std::lock_guard<std::mutex> lock(mainMutex);
+    return !mainJobs.empty();
+}
+
+void JobSystem::workerLoop(uint32_t index) {
+    currentSystem = this;
+    currentWorker = index;
+
+    while (true) {
+        if (runOne()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        workAvailable.wait(lock, [&] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t, uint32_t)>& fn) {
+    if (count == 0) return;
+
+    if (grain == 0) grain = std::max(1u, count / ((getWorkerCount() + 1) * 4));
+    if (grain >= count || workers.empty()) {
+        fn(0, count);
+        return;
+    }
+
+    // the first chunk runs here, fn outlives the rest since this only returns once they are done
+    std::vector<Handle> chunks;
+    for (uint64_t begin = grain; begin < count; begin += grain) {
+        const auto end = static_cast<uint32_t>(std::min<uint64_t>(count, begin + grain));
+        chunks.push_back(submit([&fn, first = static_cast<uint32_t>(begin), end] { fn(first, end); }));
+    }
+
+    std::exception_ptr error;
+    try {
+        fn(0, grain);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (const auto& chunk : chunks) {
+        try {
+            wait(chunk);
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void JobSystem::wait(const Handle& job) {
+    if (!job) return;
+
+    while (!job->done) {
+        if (runOne()) continue;
+
+        const bool main = isMainThread();
+        waiters++;
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            stateChanged.wait(lock, [&] { return job->done || queued > 0 || (main && hasMainJobs()); });
+        }
+        waiters--;
+    }
+
+    if (job->error) std::rethrow_exception(job->error);
+}
+
+void JobSystem::waitIdle() {
+    while (pending > 0) {
+        if (runOne()) continue;
+
+        waiters++;
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            stateChanged.wait(lock, [&] { return pending == 0 || queued > 0 || hasMainJobs(); });
+        }
+        waiters--;
+    }
+}
+
+uint32_t JobSystem::getCurrentWorker() const {
+    return currentSystem == this ? currentWorker : getWorkerCount();
+}
+
+bool JobSystem::isDone(const Handle& job) {
+    return !job || job->done;
+}
+
+void JobSystem::runMainThreadJobs() {
+    std::deque<Handle> ready;
+    {
+        std::lock_guard<std::mutex> lock(mainMutex);
+        ready.swap(mainJobs);
+    }
+    for (const auto& job : ready) {
+        execute(job);
+    }
+}
@@ -0,0 +1,107 @@
+// copyright 2025 swaroop.
+
+#include <core/layout_cache.h>
+#include <util/hash.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in LayoutCache"); } while (0)
+
+namespace {
+    // immutable samplers are never used here, so comparing the plain fields is enough
+    bool sameBinding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+        return a.binding == b.binding && a.descriptorType == b.descriptorType &&
+               a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+    }
+
+    bool sameRange(const VkPushConstantRange& a, const VkPushConstantRange& b) {
+        return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+    }
+}
+
+void LayoutCache::init(VkDevice deviceRef) {
+    device = deviceRef;
+}
+
+void LayoutCache::shutdown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& [hash, entry] : pipelineLayouts) vkDestroyPipelineLayout(device, entry.layout, nullptr);
+    for (auto& [hash, entry] : setLayouts) vkDestroyDescriptorSetLayout(device, entry.layout, nullptr);
+    pipelineLayouts.clear();
+    setLayouts.clear();
+}
+
+VkDescriptorSetLayout LayoutCache::getSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings) {
+    std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+
+    uint64_t hash = Hash::FNV_OFFSET;
+    for (const auto& b : bindings) {
+        hash = Hash::combine(hash, b.binding);
+        hash = Hash::combine(hash, static_cast<uint64_t>(b.descriptorType));
+        hash = Hash::combine(hash, b.descriptorCount);
+        hash = Hash::combine(hash, b.stageFlags);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto [first, last] = setLayouts.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        const auto& known = it->second.bindings;
+        if (std::equal(known.begin(), known.end(), bindings.begin(), bindings.end(), sameBinding))
+            return it->second.layout;
+    }
+
+    VkDescriptorSetLayoutCreateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+                                          static_cast<uint32_t>(bindings.size()), bindings.data() };
+    VkDescriptorSetLayout layout;
+    VK_CHECK(vkCreateDescriptorSetLayout(device, &info, nullptr, &layout));
+
+    setLayouts.emplace(hash, SetLayoutEntry{ std::move(bindings), layout });
+    return layout;
+}
+
+VkPipelineLayout LayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& sets,
+                                                const std::vector<VkPushConstantRange>& pushRanges) {
+    uint64_t hash = Hash::FNV_OFFSET;
+    for (VkDescriptorSetLayout set : sets) hash = Hash::combine(hash, reinterpret_cast<uint64_t>(set));
+    for (const auto& range : pushRanges) {
+        hash = Hash::combine(hash, range.stageFlags);
+        hash = Hash::combine(hash, (static_cast<uint64_t>(range.offset) << 32) | range.size);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto [first, last] = pipelineLayouts.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        const auto& entry = it->second;
+        if (entry.setLayouts == sets &&
+            std::equal(entry.pushRanges.begin(), entry.pushRanges.end(), pushRanges.begin(), pushRanges.end(), sameRange))
+            return entry.layout;
+    }
+
+    VkPipelineLayoutCreateInfo info{
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        nullptr,
+        0,
+        static_cast<uint32_t>(sets.size()),
+        sets.data(),
+        static_cast<uint32_t>(pushRanges.size()),
+        pushRanges.data()
+    };
+    VkPipelineLayout layout;
+    VK_CHECK(vkCreatePipelineLayout(device, &info, nullptr, &layout));
+
+    pipelineLayouts.emplace(hash, PipelineLayoutEntry{ sets, pushRanges, layout });
+    return layout;
+}
+
+size_t LayoutCache::setLayoutCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return setLayouts.size();
+}
+
+size_t LayoutCache::pipelineLayoutCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pipelineLayouts.size();
+}
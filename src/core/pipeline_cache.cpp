@@ -0,0 +1,210 @@
+// copyright 2025 swaroop.
+
+#include <core/pipeline_cache.h>
+#include <core/job_system.h>
+#include <util/hash.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    constexpr uint32_t CACHE_MAGIC = 0x43504B56; // "VKPC"
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    struct CacheFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint32_t keyCount;
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+}
+
+void PipelineCache::init(VkDevice deviceRef, VkPhysicalDevice gpu, const std::string& path, bool creationFeedback) {
+    device = deviceRef;
+    filePath = path;
+    feedbackSupported = creationFeedback;
+    vkGetPhysicalDeviceProperties(gpu, &deviceProps);
+
+    std::vector<char> blob;
+    const bool loaded = !filePath.empty() && load(blob);
+
+    VkPipelineCacheCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    ci.initialDataSize = loaded ? blob.size() : 0;
+    ci.pInitialData = loaded ? blob.data() : nullptr;
+
+    if (vkCreatePipelineCache(device, &ci, nullptr, &cache) != VK_SUCCESS) {
+        // a blob the driver refuses is not fatal, start over empty
+        knownKeys.clear();
+        ci.initialDataSize = 0;
+        ci.pInitialData = nullptr;
+        if (vkCreatePipelineCache(device, &ci, nullptr, &cache) != VK_SUCCESS)
+            cache = VK_NULL_HANDLE;
+    }
+
+    printf("[pipeline cache] %s (%zu known pipelines)\n",
+           loaded ? "loaded from disk" : "starting empty", knownKeys.size());
+}
+
+void PipelineCache::shutdown() {
+    if (!cache) return;
+
+    save();
+    printf("[pipeline cache] %u hits, %u misses, %u unreported, %.2f ms spent creating pipelines\n",
+           stats.hits, stats.misses, stats.unreported, stats.creationMs);
+
+    vkDestroyPipelineCache(device, cache, nullptr);
+    cache = VK_NULL_HANDLE;
+}
+
+const void* PipelineCache::chainFeedback(Feedback& feedback, const void* next) const {
+    if (!feedbackSupported) return next;
+
+    feedback.pipeline = {};
+    feedback.info = {};
+    feedback.info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+    feedback.info.pNext = next;
+    feedback.info.pPipelineCreationFeedback = &feedback.pipeline;
+    return &feedback.info;
+}
+
+bool PipelineCache::recordPipeline(uint64_t key, double creationMs, const Feedback& feedback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.creationMs += creationMs;
+
+    // a key we haven't written yet means the driver blob has grown
+    if (knownKeys.insert(key).second) dirty = true;
+
+    if (!(feedback.pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)) {
+        stats.unreported++;
+        return false;
+    }
+    const bool hit = (feedback.pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0;
+    if (hit) {
+        stats.hits++;
+    } else {
+        stats.misses++;
+        dirty = true;
+    }
+    return hit;
+}
+
+void PipelineCache::tick(double nowSeconds, JobSystem& jobs) {
+    if (lastSaveTime < 0.0) lastSaveTime = nowSeconds;
+    if (!dirty || saving || nowSeconds - lastSaveTime < SAVE_INTERVAL_SECONDS) return;
+
+    // pulling the blob out of the driver and writing it takes long enough to show up as a hitch on the render thread
+    // the JobSystem shuts down before the engine's shutdown() does the final save
+    saving = true;
+    lastSaveTime = nowSeconds;
+    jobs.submit([this] {
+        save();
+        saving = false;
+    });
+}
+
+bool PipelineCache::load(std::vector<char>& blob) {
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    CacheFileHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+
+    // sizes are checked against what the file holds before allocating anything, a truncated or corrupt file
+    // starts an empty cache instead of throwing out of init
+    const std::streamoff begin = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streamoff end = in.tellg();
+    in.seekg(begin);
+    if (begin < 0 || end < begin) return false;
+    const uint64_t remaining = static_cast<uint64_t>(end - begin);
+    const uint64_t keyBytes = static_cast<uint64_t>(header.keyCount) * sizeof(uint64_t);
+    if (keyBytes > remaining || header.dataSize != remaining - keyBytes) {
+        printf("[pipeline cache] %s is truncated or corrupt, discarding\n", filePath.c_str());
+        return false;
+    }
+
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) return false;
+
+    // anything about the device or driver changing invalidates the whole file
+    if (header.vendorID != deviceProps.vendorID ||
+        header.deviceID != deviceProps.deviceID ||
+        header.driverVersion != deviceProps.driverVersion ||
+        memcmp(header.pipelineCacheUUID, deviceProps.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        printf("[pipeline cache] device or driver changed, discarding %s\n", filePath.c_str());
+        return false;
+    }
+
+    std::vector<uint64_t> keys(header.keyCount);
+    if (!in.read(reinterpret_cast<char*>(keys.data()), static_cast<std::streamsize>(keys.size() * sizeof(uint64_t))))
+        return false;
+
+    blob.resize(static_cast<size_t>(header.dataSize));
+    if (!in.read(blob.data(), static_cast<std::streamsize>(blob.size()))) return false;
+
+    if (Hash::fnv1a(blob.data(), blob.size()) != header.dataHash) {
+        printf("[pipeline cache] %s is corrupt, discarding\n", filePath.c_str());
+        blob.clear();
+        return false;
+    }
+
+    knownKeys.insert(keys.begin(), keys.end());
+    return true;
+}
+
+bool PipelineCache::save() {
+    if (!cache || filePath.empty()) return false;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS) return false;
+
+    std::vector<char> blob(size);
+    if (vkGetPipelineCacheData(device, cache, &size, blob.data()) != VK_SUCCESS) return false;
+    blob.resize(size);
+
+    std::vector<uint64_t> keys;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        keys.assign(knownKeys.begin(), knownKeys.end());
+        dirty = false;
+    }
+
+    CacheFileHeader header{};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.vendorID = deviceProps.vendorID;
+    header.deviceID = deviceProps.deviceID;
+    header.driverVersion = deviceProps.driverVersion;
+    memcpy(header.pipelineCacheUUID, deviceProps.pipelineCacheUUID, VK_UUID_SIZE);
+    header.keyCount = static_cast<uint32_t>(keys.size());
+    header.dataSize = blob.size();
+    header.dataHash = Hash::fnv1a(blob.data(), blob.size());
+
+    // write next to the real file and swap it in, a crash mid-write never leaves a torn cache behind
+    const std::string tmpPath = filePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(keys.data()), static_cast<std::streamsize>(keys.size() * sizeof(uint64_t)));
+        out.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+        out.flush();
+        if (!out.good()) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, filePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
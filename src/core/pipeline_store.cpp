@@ -0,0 +1,706 @@
+// copyright 2025 swaroop.
+
+#include <core/pipeline_store.h>
+#include <core/pipeline_cache.h>
+#include <engine.h>
+#include <util/hash.h>
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in PipelineStore"); } while (0)
+
+// what the driver said about the pipeline cache, for the build log
+static const char* cacheResult(const PipelineCache::Feedback& feedback) {
+    if (!(feedback.pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)) return "unreported";
+    return (feedback.pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) ? "hit" : "miss";
+}
+
+/*
+ * loose spir-v as the build writes it, <build dir>/spirv/opt/<source path>.spv (see cmake/shader_demo.cmake),
+ * for shaders the pack doesn't have; looked up under the working directory, then next to the executable
+ * and one level up from it, where multi-config generators put the binaries
+ */
+static std::vector<uint32_t> readFile(const std::string& filename) {
+    auto tryPath = [&](const std::string& p) {
+        std::ifstream f(p, std::ios::ate | std::ios::binary);
+        if (!f.is_open()) return std::vector<uint32_t>{};
+        size_t size = (size_t)f.tellg();
+        std::vector<uint32_t> buf((size + 3) / 4); // uint32_t storage, vkCreateShaderModule wants aligned words
+        f.seekg(0); f.read(reinterpret_cast<char*>(buf.data()), size);
+        return buf;
+    };
+
+    std::vector<std::string> candidates = { filename, "spirv/opt/" + filename };
+    if (const char* base = SDL_GetBasePath()) {
+        candidates.push_back(std::string(base) + "spirv/opt/" + filename);
+        candidates.push_back(std::string(base) + "../spirv/opt/" + filename);
+    }
+    for (const auto& path : candidates) {
+        auto data = tryPath(path);
+        if (!data.empty()) return data;
+    }
+
+    std::cerr << "[Shader Error] Could not find file: " << filename << "\nCWD: " << std::filesystem::current_path() << "\n";
+    throw std::runtime_error("Shader missing: " + filename + " (not in the shader pack or under spirv/opt/)");
+}
+
+// program paths are relative to wherever the engine runs from, hot reload keys always start at shader_repo/
+static bool samePath(const std::string& a, const std::string& b) {
+    auto endsWith = [](const std::string& s, const std::string& suffix) {
+        return s.size() > suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+               s[s.size() - suffix.size() - 1] == '/';
+    };
+    return a == b || endsWith(a, b) || endsWith(b, a);
+}
+
+static bool usesPath(const ShaderProgramDesc& desc, const std::string& path) {
+    if (desc.isCompute()) return samePath(desc.compPath, path);
+    return samePath(desc.vertPath, path) || samePath(desc.fragPath, path);
+}
+
+// map entries + data for desc.specialization, every value is 4 bytes
+// names resolve against the reflected constants, ones no stage declares are dropped like unknown ids are
+struct PipelineStore::Specialization {
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<uint32_t> values;
+    VkSpecializationInfo info{};
+
+    Specialization(const ShaderProgramDesc& desc, const ShaderReflection& reflection) {
+        for (const auto& spec : desc.specialization) {
+            uint32_t id = spec.id;
+            if (!spec.name.empty()) {
+                auto it = std::find_if(reflection.specConstants.begin(), reflection.specConstants.end(),
+                                       [&](const ShaderReflection::SpecConstant& c) { return c.name == spec.name; });
+                if (it == reflection.specConstants.end()) continue;
+                id = it->id;
+            }
+            entries.push_back({ id, static_cast<uint32_t>(values.size() * sizeof(uint32_t)), sizeof(uint32_t) });
+            values.push_back(spec.value);
+        }
+        info = { static_cast<uint32_t>(entries.size()), entries.data(), values.size() * sizeof(uint32_t), values.data() };
+    }
+
+    const VkSpecializationInfo* get() const { return entries.empty() ? nullptr : &info; }
+
+    uint64_t hash(uint64_t seed) const {
+        for (const auto& e : entries) seed = Hash::combine(seed, e.constantID);
+        for (uint32_t v : values) seed = Hash::combine(seed, v);
+        return seed;
+    }
+};
+
+void PipelineStore::init(Engine* engineRef) {
+    engine = engineRef;
+    device = engine->getDevice();
+
+    layouts.init(device);
+
+    // the same binding createLayout() produces for a lone uniform block, so those programs share this handle
+    VkDescriptorSetLayoutBinding binding{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, UNIFORM_STAGES, nullptr };
+    defaultSetLayout = layouts.getSetLayout({ binding });
+
+    libraries = engine->hasPipelineLibraries();
+}
+
+void PipelineStore::shutdown() {
+    // the JobSystem shut down first, nothing is building anymore
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        paused = true;
+        queue.clear();
+    }
+
+    for (auto& [key, entry] : entries) {
+        if (entry->program.pipeline) vkDestroyPipeline(device, entry->program.pipeline, nullptr);
+    }
+    entries.clear();
+
+    // the engine flushed its deletion queue before this, nothing in flight references these anymore
+    for (auto& [entry, program] : pendingSwaps) {
+        if (program.pipeline) vkDestroyPipeline(device, program.pipeline, nullptr);
+    }
+    pendingSwaps.clear();
+    spirvOverrides.clear();
+
+    for (auto& [key, library] : sharedLibraries) vkDestroyPipeline(device, library, nullptr);
+    sharedLibraries.clear();
+
+    layouts.shutdown();
+    defaultSetLayout = VK_NULL_HANDLE;
+}
+
+const PipelineStore::Program* PipelineStore::acquire(const ShaderProgramDesc& desc) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto& slot = entries[desc.key()];
+    if (!slot) {
+        slot = std::make_unique<Entry>();
+        slot->desc = desc;
+        slot->state = State::Queued;
+    }
+    Entry* entry = slot.get();
+
+    if (entry->state == State::Queued) {
+        // not picked up by a worker yet, cheaper to build it here than to wait in line
+        queue.erase(std::remove(queue.begin(), queue.end(), entry), queue.end());
+        entry->state = State::Building;
+
+        lock.unlock();
+        build(*entry);
+        lock.lock();
+
+        if (entry->prewarmed) prewarmDone++;
+        entryFinished.notify_all();
+    }
+
+    entryFinished.wait(lock, [&] { return entry->state == State::Ready || entry->state == State::Failed; });
+
+    if (entry->state == State::Failed)
+        throw std::runtime_error(entry->error);
+    return &entry->program;
+}
+
+void PipelineStore::prewarm(const std::vector<ShaderProgramDesc>& programs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& desc : programs) {
+            auto& slot = entries[desc.key()];
+            if (slot) continue;
+
+            slot = std::make_unique<Entry>();
+            slot->desc = desc;
+            slot->state = State::Queued;
+            slot->prewarmed = true;
+            queue.push_back(slot.get());
+            prewarmTotal++;
+        }
+    }
+    startBuilders();
+}
+
+void PipelineStore::pausePrewarm() {
+    std::lock_guard<std::mutex> lock(mutex);
+    paused = true;
+}
+
+void PipelineStore::resumePrewarm() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        paused = false;
+    }
+    startBuilders();
+}
+
+void PipelineStore::startBuilders() {
+    // builds take long enough to hold a worker for a while, leave one for recording and the layers' jobs
+    JobSystem& jobs = engine->getJobSystem();
+    const uint32_t workers = jobs.getWorkerCount();
+    const uint32_t limit = std::clamp(workers > 1 ? workers - 1 : 1u, 1u, 4u);
+
+    uint32_t start = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (paused) return;
+        start = std::min<uint32_t>(static_cast<uint32_t>(queue.size()), limit - std::min(builders, limit));
+        builders += start;
+    }
+    for (uint32_t i = 0; i < start; i++) {
+        jobs.submit([this] { drain(); });
+    }
+}
+
+void PipelineStore::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!paused && !queue.empty()) {
+        Entry* entry = queue.front();
+        queue.pop_front();
+        entry->state = State::Building;
+
+        lock.unlock();
+        build(*entry);
+        lock.lock();
+
+        prewarmDone++;
+        entryFinished.notify_all();
+    }
+    builders--;
+}
+
+void PipelineStore::build(Entry& entry) {
+    Program program;
+    std::string error;
+
+    try {
+        program.pipeline = createPipeline(entry.desc, program);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entry.program = std::move(program);
+    entry.error = error;
+    entry.state = error.empty() ? State::Ready : State::Failed;
+}
+
+PipelineStore::SpirvCode PipelineStore::loadSpirv(const std::string& path) {
+    SpirvCode code;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& [key, words] : spirvOverrides) {
+            if (samePath(path, key)) {
+                code.owned = words;
+                break;
+            }
+        }
+    }
+
+    if (code.owned.empty()) {
+        // zero copy, the pack stays mapped for as long as the engine lives
+        if (auto blob = engine->getShaderPack().find(path)) {
+            code.words = blob.code;
+            code.size = blob.size;
+            code.hash = blob.hash;
+            return code;
+        }
+
+        // not packed (new shader, no pack next to the binary), fall back to the loose file
+        code.owned = readFile(path);
+    }
+
+    code.words = code.owned.data();
+    code.size = code.owned.size() * sizeof(uint32_t);
+    code.hash = Hash::fnv1a(code.words, code.size);
+    return code;
+}
+
+bool PipelineStore::reload(const std::string& spvPath, std::vector<uint32_t> code, std::string& error) {
+    std::vector<Entry*> affected;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        spirvOverrides[spvPath] = std::move(code);
+
+        // queued and building entries pick the override up on their own
+        for (auto& [key, entry] : entries) {
+            if (entry->state != State::Ready && entry->state != State::Failed) continue;
+            if (usesPath(entry->desc, spvPath)) affected.push_back(entry.get());
+        }
+    }
+
+    bool ok = true;
+    for (Entry* entry : affected) {
+        Program program;
+        try {
+            program.pipeline = createPipeline(entry->desc, program);
+        } catch (const std::exception& e) {
+            error = e.what();
+            ok = false;
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingSwaps.emplace_back(entry, std::move(program));
+    }
+    return ok;
+}
+
+void PipelineStore::applyReloads() {
+    std::vector<std::pair<Entry*, Program>> swaps;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pendingSwaps.empty()) return;
+        swaps.swap(pendingSwaps);
+
+        for (auto& [entry, program] : swaps) {
+            // frames still in flight keep drawing with the old pipeline, it goes once they are done
+            VkPipeline old = entry->program.pipeline;
+            if (old) {
+                VkDevice dev = device;
+                engine->retire([dev, old]() { vkDestroyPipeline(dev, old, nullptr); });
+            }
+
+            program.generation = entry->program.generation + 1;
+            entry->program = std::move(program);
+            entry->state = State::Ready;
+            entry->error.clear();
+        }
+    }
+    entryFinished.notify_all();
+}
+
+void PipelineStore::createLayout(Program& program) {
+    const ShaderReflection& refl = program.reflection;
+
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets(refl.setCount());
+    for (const auto& b : refl.bindings) {
+        if (b.count == 0)
+            throw std::runtime_error("unsized descriptor array '" + b.name + "' is not supported");
+
+        VkDescriptorType type = b.type;
+        if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && b.set == 0 && b.binding == 0)
+            type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
+        sets[b.set].push_back({ b.binding, type, b.count, UNIFORM_STAGES, nullptr });
+    }
+
+    // sets the shader skips still need a (empty) layout so the indices line up
+    program.setLayouts.clear();
+    for (auto& bindings : sets) {
+        program.setLayouts.push_back(layouts.getSetLayout(std::move(bindings)));
+    }
+
+    std::vector<VkPushConstantRange> ranges;
+    if (refl.pushConstants.size > 0) {
+        if (refl.pushConstants.size > PUSH_CONSTANT_SIZE)
+            throw std::runtime_error("push constant block larger than " + std::to_string(PUSH_CONSTANT_SIZE) + " bytes");
+        ranges.push_back({ UNIFORM_STAGES, 0, (refl.pushConstants.size + 3u) & ~3u });
+    }
+
+    program.layout = layouts.getPipelineLayout(program.setLayouts, ranges);
+}
+
+// the fixed function state of every fullscreen triangle pipeline, monolithic or split into libraries
+struct PipelineStore::FullscreenState {
+    /*
+     * code to generate the standard screen triangle
+     */
+    VkPipelineVertexInputStateCreateInfo vi{
+        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    VkPipelineInputAssemblyStateCreateInfo ia{
+        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        VK_FALSE
+    };
+    VkPipelineViewportStateCreateInfo vp{
+        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        1,
+        nullptr,
+        1,
+        nullptr
+    };
+    VkPipelineRasterizationStateCreateInfo rs{
+        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_FALSE,
+        VK_FALSE,
+        VK_POLYGON_MODE_FILL,
+        VK_CULL_MODE_NONE,
+        VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        VK_FALSE,
+        0,
+        0,
+        0,
+        1.0f
+    };
+    VkPipelineMultisampleStateCreateInfo ms{
+        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_SAMPLE_COUNT_1_BIT,
+        VK_FALSE,
+        1.0f,
+        nullptr,
+        VK_FALSE,
+        VK_FALSE
+    };
+
+    // some more bullshit
+    VkPipelineColorBlendAttachmentState att{
+        VK_FALSE,
+        VK_BLEND_FACTOR_ONE,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_OP_ADD,
+        VK_BLEND_FACTOR_ONE,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_OP_ADD,
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+    };
+    VkPipelineColorBlendStateCreateInfo cb{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_FALSE,
+        VK_LOGIC_OP_COPY,
+        1,
+        &att,
+        {0,0,0,0}
+    };
+
+    VkDynamicState dynStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dyn{
+        VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        2,
+        dynStates
+    };
+
+    FullscreenState() = default;
+    FullscreenState(const FullscreenState&) = delete; // points into itself
+    FullscreenState& operator=(const FullscreenState&) = delete;
+};
+
+VkPipeline PipelineStore::createPipeline(const ShaderProgramDesc& desc, Program& program) {
+    if (desc.isCompute()) return createComputePipeline(desc, program);
+
+    program.reflection = {};
+    const SpirvCode vert = loadSpirv(desc.vertPath);
+    const SpirvCode frag = loadSpirv(desc.fragPath);
+    const ShaderReflection vertReflection = ShaderReflection::fromSpirv(vert.words, vert.size / 4);
+    program.reflection.merge(vertReflection);
+    program.reflection.merge(ShaderReflection::fromSpirv(frag.words, frag.size / 4));
+    createLayout(program);
+
+    const bool graphTarget = desc.colorFormat != VK_FORMAT_UNDEFINED;
+    const VkFormat colorFormat = graphTarget ? desc.colorFormat : engine->getColorFormat();
+    // with dynamic rendering the pipeline only knows its format and fits any pass drawing into one
+    const VkRenderPass renderPass = engine->hasDynamicRendering() ? VK_NULL_HANDLE
+        : graphTarget ? engine->getRenderGraph().getCompatibleRenderPass(colorFormat) : engine->getRenderPass();
+
+    // the cache key covers everything that changes the compiled result: both spir-v blobs, the target format
+    // and the specialization constants
+    const Specialization spec(desc, program.reflection);
+    uint64_t pipelineKey = Hash::combine(Hash::combine(Hash::FNV_OFFSET, vert.hash), frag.hash);
+    pipelineKey = spec.hash(Hash::combine(pipelineKey, static_cast<uint64_t>(colorFormat)));
+
+    PipelineCache& cache = engine->getPipelineCache();
+    PipelineCache::Feedback feedback;
+    const auto start = std::chrono::steady_clock::now();
+
+    VkPipeline pipeline = libraries
+        ? linkPipeline(vert, frag, Specialization(desc, vertReflection), spec, program.layout, renderPass, colorFormat, feedback)
+        : createMonolithic(vert, frag, spec, program.layout, renderPass, colorFormat, feedback);
+
+    const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    cache.recordPipeline(pipelineKey, buildMs, feedback);
+    printf("[pipeline store] %s %s in %.2f ms (cache %s)\n", desc.fragPath.c_str(), libraries ? "linked" : "built", buildMs,
+           cacheResult(feedback));
+
+    return pipeline;
+}
+
+VkShaderModule PipelineStore::createModule(const SpirvCode& code) {
+    VkShaderModuleCreateInfo info{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, nullptr, 0, code.size, code.words };
+    VkShaderModule mod;
+    VK_CHECK(vkCreateShaderModule(device, &info, nullptr, &mod));
+    return mod;
+}
+
+VkPipeline PipelineStore::createMonolithic(const SpirvCode& vert, const SpirvCode& frag, const Specialization& spec,
+                                           VkPipelineLayout layout, VkRenderPass renderPass, VkFormat colorFormat,
+                                           PipelineCache::Feedback& feedback) {
+    VkShaderModule vs = createModule(vert);
+    VkShaderModule fs = VK_NULL_HANDLE;
+    try {
+        fs = createModule(frag);
+    } catch (...) {
+        vkDestroyShaderModule(device, vs, nullptr);
+        throw;
+    }
+
+    VkPipelineShaderStageCreateInfo stages[] = {
+        { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_SHADER_STAGE_VERTEX_BIT,
+            vs,
+            "main",
+            spec.get() },
+        { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            fs,
+            "main",
+            spec.get() }
+    };
+
+    const FullscreenState state;
+    const VkPipelineRenderingCreateInfo rendering{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO, nullptr, 0, 1, &colorFormat };
+    VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    pci.pNext = engine->getPipelineCache().chainFeedback(feedback, renderPass ? nullptr : &rendering);
+    pci.stageCount = 2; pci.pStages = stages;
+    pci.pVertexInputState = &state.vi; pci.pInputAssemblyState = &state.ia;
+    pci.pViewportState = &state.vp; pci.pRasterizationState = &state.rs;
+    pci.pMultisampleState = &state.ms; pci.pColorBlendState = &state.cb;
+    pci.pDynamicState = &state.dyn; pci.layout = layout;
+    pci.renderPass = renderPass;
+    pci.subpass = 0;
+    pci.pDepthStencilState = nullptr; // disable depth
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(
+        device,
+        engine->getPipelineCache().get(),
+        1,
+        &pci,
+        nullptr,
+        &pipeline
+    );
+
+    vkDestroyShaderModule(device, vs, nullptr);
+    vkDestroyShaderModule(device, fs, nullptr);
+    VK_CHECK(result);
+    return pipeline;
+}
+
+/*
+ * VK_EXT_graphics_pipeline_library: vertex input, pre-rasterization (the vertex shader) and fragment output
+ * are compiled once and shared, per program only the fragment shader is compiled, then everything is fast linked
+ * the pre-rasterization part is shared between programs with the same vertex shader, layout and render pass,
+ * which with LayoutCache sharing handles is most fullscreen demos
+ * with dynamic rendering only the fragment output part depends on the target, by its format
+ */
+VkPipeline PipelineStore::linkPipeline(const SpirvCode& vert, const SpirvCode& frag, const Specialization& vertSpec,
+                                       const Specialization& fragSpec, VkPipelineLayout layout, VkRenderPass renderPass,
+                                       VkFormat colorFormat, PipelineCache::Feedback& feedback) {
+    const FullscreenState state;
+    const VkPipelineRenderingCreateInfo rendering{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO, nullptr, 0, 1, &colorFormat };
+    const uint64_t passKey = Hash::fnv1a(&renderPass, sizeof(renderPass));
+    const uint64_t outputKey = renderPass ? passKey : Hash::combine(passKey, static_cast<uint64_t>(colorFormat));
+
+    const VkPipeline vertexInput = sharedLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, [&] {
+        VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+        pci.pVertexInputState = &state.vi; pci.pInputAssemblyState = &state.ia;
+        pci.pDynamicState = &state.dyn;
+        return createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, pci);
+    });
+
+    uint64_t preRasterKey = Hash::combine(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, vert.hash);
+    preRasterKey = vertSpec.hash(Hash::combine(Hash::fnv1a(&layout, sizeof(layout), preRasterKey), passKey));
+    const VkPipeline preRaster = sharedLibrary(preRasterKey, [&] {
+        VkShaderModule vs = createModule(vert);
+        VkPipelineShaderStageCreateInfo stage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0,
+                                               VK_SHADER_STAGE_VERTEX_BIT, vs, "main", vertSpec.get() };
+        VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+        pci.stageCount = 1; pci.pStages = &stage;
+        pci.pViewportState = &state.vp; pci.pRasterizationState = &state.rs;
+        pci.pDynamicState = &state.dyn; pci.layout = layout;
+        pci.renderPass = renderPass;
+        try {
+            VkPipeline library = createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, pci);
+            vkDestroyShaderModule(device, vs, nullptr);
+            return library;
+        } catch (...) {
+            vkDestroyShaderModule(device, vs, nullptr);
+            throw;
+        }
+    });
+
+    const VkPipeline output = sharedLibrary(Hash::combine(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, outputKey), [&] {
+        VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+        pci.pNext = renderPass ? nullptr : &rendering;
+        pci.pMultisampleState = &state.ms; pci.pColorBlendState = &state.cb;
+        pci.pDynamicState = &state.dyn;
+        pci.renderPass = renderPass;
+        return createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, pci);
+    });
+
+    // the one part that is this program's own, not needed once linked
+    VkPipeline fragment = VK_NULL_HANDLE;
+    {
+        VkShaderModule fs = createModule(frag);
+        VkPipelineShaderStageCreateInfo stage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0,
+                                               VK_SHADER_STAGE_FRAGMENT_BIT, fs, "main", fragSpec.get() };
+        VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+        pci.pNext = engine->getPipelineCache().chainFeedback(feedback, nullptr); // the compile the link can't skip
+        pci.stageCount = 1; pci.pStages = &stage;
+        pci.pMultisampleState = &state.ms;
+        pci.pDepthStencilState = nullptr; // disable depth
+        pci.layout = layout;
+        pci.renderPass = renderPass;
+        try {
+            fragment = createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, pci);
+        } catch (...) {
+            vkDestroyShaderModule(device, fs, nullptr);
+            throw;
+        }
+        vkDestroyShaderModule(device, fs, nullptr);
+    }
+
+    // no link time optimization, the point is a link that costs next to nothing
+    const VkPipeline parts[] = { vertexInput, preRaster, fragment, output };
+    VkPipelineLibraryCreateInfoKHR linkInfo{ VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR, nullptr, 4, parts };
+    VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    pci.pNext = &linkInfo;
+    pci.layout = layout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(device, engine->getPipelineCache().get(), 1, &pci, nullptr, &pipeline);
+    vkDestroyPipeline(device, fragment, nullptr);
+    VK_CHECK(result);
+    return pipeline;
+}
+
+VkPipeline PipelineStore::createLibrary(VkGraphicsPipelineLibraryFlagsEXT parts, VkGraphicsPipelineCreateInfo pci) {
+    // in front of whatever the caller chained (VkPipelineRenderingCreateInfo)
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT, pci.pNext, parts };
+    pci.pNext = &libraryInfo;
+    pci.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+
+    VkPipeline library = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateGraphicsPipelines(device, engine->getPipelineCache().get(), 1, &pci, nullptr, &library));
+    return library;
+}
+
+VkPipeline PipelineStore::sharedLibrary(uint64_t key, const std::function<VkPipeline()>& create) {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        auto it = sharedLibraries.find(key);
+        if (it != sharedLibraries.end()) return it->second;
+    }
+
+    // built outside the lock, workers building different parts shouldn't wait on each other
+    VkPipeline library = create();
+
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    auto [it, inserted] = sharedLibraries.emplace(key, library);
+    if (!inserted) vkDestroyPipeline(device, library, nullptr); // another worker got there first
+    return it->second;
+}
+
+VkPipeline PipelineStore::createComputePipeline(const ShaderProgramDesc& desc, Program& program) {
+    program.reflection = {};
+
+    auto code = loadSpirv(desc.compPath);
+    program.reflection.merge(ShaderReflection::fromSpirv(code.words, code.size / 4));
+    createLayout(program);
+
+    const Specialization spec(desc, program.reflection);
+    const uint64_t pipelineKey = spec.hash(code.hash);
+
+    VkShaderModule cs = createModule(code);
+
+    PipelineCache& cache = engine->getPipelineCache();
+    PipelineCache::Feedback feedback;
+
+    VkComputePipelineCreateInfo pci{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    pci.pNext = cache.chainFeedback(feedback, nullptr);
+    pci.stage = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_COMPUTE_BIT, cs, "main", spec.get() };
+    pci.layout = program.layout;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateComputePipelines(device, cache.get(), 1, &pci, nullptr, &pipeline);
+
+    vkDestroyShaderModule(device, cs, nullptr);
+    VK_CHECK(result);
+
+    const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    cache.recordPipeline(pipelineKey, buildMs, feedback);
+    printf("[pipeline store] %s built in %.2f ms (cache %s)\n", desc.compPath.c_str(), buildMs, cacheResult(feedback));
+
+    return pipeline;
+}
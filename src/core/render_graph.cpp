@@ -0,0 +1,918 @@
+// copyright 2025 swaroop.
+
+#include <core/render_graph.h>
+#include <engine.h>
+#include <util/hash.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in RenderGraph"); } while (0)
+
+namespace {
+    struct AccessInfo {
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        bool write;
+        VkImageUsageFlags imageUsage;   // 0 = not valid on images
+        VkBufferUsageFlags bufferUsage; // 0 = not valid on buffers
+    };
+
+    AccessInfo accessInfo(RenderGraph::Access access) {
+        using A = RenderGraph::Access;
+        switch (access) {
+            case A::ColorAttachment:
+                return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0 };
+            case A::FragmentSampled:
+                return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT, 0 };
+            case A::ComputeSampled:
+                return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT, 0 };
+            case A::FragmentStorageRead:
+                return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                         VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+            case A::ComputeStorageRead:
+                return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                         VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+            case A::ComputeStorageWrite:
+                return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_GENERAL, true, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+            case A::UniformRead:
+                return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT,
+                         VK_IMAGE_LAYOUT_UNDEFINED, false, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT };
+            case A::TransferRead:
+                return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT };
+            case A::TransferWrite:
+                return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT };
+        }
+        throw std::runtime_error("render graph: unknown access");
+    }
+
+    constexpr VkAccessFlags WRITE_ACCESS = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                                           VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    constexpr uint32_t FRAME_DESCRIPTOR_SETS = 256;
+
+    // where a resource stands while compile() walks the passes
+    struct UseState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags writeStages = 0;  // last write (or layout transition)
+        VkAccessFlags writeAccess = 0;         // not yet made visible to anything
+        VkPipelineStageFlags readStages = 0;   // reads since the last write
+        VkPipelineStageFlags visibleStages = 0; // stages the last write is visible to
+    };
+}
+
+struct RenderGraph::ResourceDecl {
+    std::string name;
+    bool isImage = true;
+    bool imported = false;
+
+    ImageDesc imageDesc;
+    BufferDesc bufferDesc;
+    VkExtent2D extent{};
+
+    // imported images
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    ImageState* state = nullptr;
+
+    // filled in by compile()
+    bool written = false; // during declaration, catches reads of nothing
+    VkImageUsageFlags imageUsage = 0;
+    VkBufferUsageFlags bufferUsage = 0;
+    uint32_t firstUse = UINT32_MAX; // positions in execution order
+    uint32_t lastUse = 0;
+    uint32_t physical = UINT32_MAX;
+};
+
+struct RenderGraph::PassDecl {
+    struct Use {
+        Resource resource;
+        Access access;
+    };
+
+    std::string name;
+    ExecuteFn execute;
+    std::vector<Use> uses;
+    std::vector<std::pair<Resource, VkClearColorValue>> clears;
+    bool sideEffects = false;
+};
+
+struct RenderGraph::CompiledPass {
+    uint32_t pass = 0;
+
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+    // raster passes only, a render pass + framebuffer or the attachments for dynamic rendering
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    std::vector<VkRenderingAttachmentInfo> colorAttachments;
+    VkExtent2D extent{};
+    std::vector<VkClearValue> clearValues;
+};
+
+/*
+ * the memory behind every transient resource, rebuilt only when the declarations change
+ * a slot is one allocation shared by resources whose lifetimes don't overlap
+ */
+struct RenderGraph::PhysicalSet {
+    struct Slot {
+        GpuAllocation memory;
+        VkMemoryRequirements reqs{};
+        bool isImage = true;
+        std::vector<std::pair<uint32_t, uint32_t>> lifetimes;
+
+        // last use of whatever lived here, the next resident's first barrier waits on it
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags writeAccess = 0;
+    };
+
+    struct Entry {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkMemoryRequirements reqs{};
+        uint32_t slot = 0;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<Entry> entries;
+
+    void destroy(VkDevice device, GpuAllocator& allocator) {
+        for (auto& e : entries) {
+            if (e.view) vkDestroyImageView(device, e.view, nullptr);
+            if (e.image) vkDestroyImage(device, e.image, nullptr);
+            if (e.buffer) vkDestroyBuffer(device, e.buffer, nullptr);
+        }
+        for (auto& slot : slots) allocator.free(slot.memory);
+        entries.clear();
+        slots.clear();
+    }
+};
+
+RenderGraph::RenderGraph() = default;
+RenderGraph::~RenderGraph() = default;
+
+void RenderGraph::init(Engine* engineRef, uint32_t frames) {
+    engine = engineRef;
+    device = engine->getDevice();
+    framesInFlight = frames;
+
+    // sets only point at this frame's resources, so the whole pool is thrown away when the slot comes around
+    VkDescriptorPoolSize sizes[] = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, FRAME_DESCRIPTOR_SETS * 2 },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, FRAME_DESCRIPTOR_SETS },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, FRAME_DESCRIPTOR_SETS },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, FRAME_DESCRIPTOR_SETS },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, FRAME_DESCRIPTOR_SETS },
+    };
+    VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0,
+                                         FRAME_DESCRIPTOR_SETS, static_cast<uint32_t>(std::size(sizes)), sizes };
+    descriptorPools.resize(framesInFlight);
+    for (auto& pool : descriptorPools) {
+        VK_CHECK(vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool));
+    }
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    VK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &linearSampler));
+}
+
+void RenderGraph::shutdown() {
+    if (!device) return;
+
+    if (physical) physical->destroy(device, engine->getAllocator());
+    physical.reset();
+    physicalSignature = 0;
+
+    for (auto& [key, fb] : framebuffers) vkDestroyFramebuffer(device, fb.framebuffer, nullptr);
+    framebuffers.clear();
+    for (auto& [key, rp] : renderPasses) vkDestroyRenderPass(device, rp, nullptr);
+    renderPasses.clear();
+    for (auto pool : descriptorPools) vkDestroyDescriptorPool(device, pool, nullptr);
+    descriptorPools.clear();
+    if (linearSampler) vkDestroySampler(device, linearSampler, nullptr);
+    linearSampler = VK_NULL_HANDLE;
+
+    resources.clear();
+    passes.clear();
+    compiled.clear();
+    device = VK_NULL_HANDLE;
+}
+
+void RenderGraph::beginFrame(uint32_t index, VkExtent2D extent) {
+    frameIndex = index;
+    renderExtent = extent;
+    frameNumber++;
+
+    resources.clear();
+    passes.clear();
+    backbufferReads.clear();
+    compiled.clear();
+
+    vkResetDescriptorPool(device, descriptorPools[frameIndex], 0);
+
+    // unused ones age out, ones over a retired imported view already left through forgetImageView()
+    for (auto it = framebuffers.begin(); it != framebuffers.end();) {
+        if (it->second.lastUsed + framesInFlight + 1 < frameNumber) {
+            VkFramebuffer fb = it->second.framebuffer;
+            engine->retire([device = device, fb]() { vkDestroyFramebuffer(device, fb, nullptr); });
+            it = framebuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+RenderGraph::Resource RenderGraph::addResource(ResourceDecl&& decl) {
+    resources.push_back(std::move(decl));
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::PassBuilder::createImage(const std::string& name, const ImageDesc& desc) {
+    ResourceDecl decl;
+    decl.name = name;
+    decl.isImage = true;
+    decl.imageDesc = desc;
+    if (desc.width && desc.height) {
+        decl.extent = { desc.width, desc.height };
+    } else {
+        decl.extent = { std::max(1u, static_cast<uint32_t>(std::lround(graph.renderExtent.width * desc.scale))),
+                        std::max(1u, static_cast<uint32_t>(std::lround(graph.renderExtent.height * desc.scale))) };
+    }
+    return graph.addResource(std::move(decl));
+}
+
+RenderGraph::Resource RenderGraph::PassBuilder::createBuffer(const std::string& name, const BufferDesc& desc) {
+    if (desc.size == 0) throw std::runtime_error("render graph: buffer " + name + " has no size");
+
+    ResourceDecl decl;
+    decl.name = name;
+    decl.isImage = false;
+    decl.bufferDesc = desc;
+    return graph.addResource(std::move(decl));
+}
+
+void RenderGraph::PassBuilder::read(Resource resource, Access access) {
+    if (accessInfo(access).write) throw std::runtime_error("render graph: read() with a write access");
+    graph.addUse(pass, resource, access);
+}
+
+void RenderGraph::PassBuilder::write(Resource resource, Access access) {
+    if (!accessInfo(access).write) throw std::runtime_error("render graph: write() with a read access");
+    graph.addUse(pass, resource, access);
+}
+
+void RenderGraph::PassBuilder::clear(Resource resource, VkClearColorValue color) {
+    graph.passes[pass].clears.emplace_back(resource, color);
+}
+
+void RenderGraph::addUse(uint32_t pass, Resource resource, Access access) {
+    if (resource >= resources.size()) throw std::runtime_error("render graph: unknown resource");
+
+    ResourceDecl& res = resources[resource];
+    const AccessInfo info = accessInfo(access);
+    if (res.isImage ? info.imageUsage == 0 : info.bufferUsage == 0)
+        throw std::runtime_error("render graph: " + res.name + " can't be used that way");
+
+    if (!info.write && !res.written && !res.imported)
+        throw std::runtime_error("render graph: " + passes[pass].name + " reads " + res.name + " before anything writes it");
+    if (info.write) res.written = true;
+
+    passes[pass].uses.push_back({ resource, access });
+}
+
+void RenderGraph::addPass(const std::string& name, const SetupFn& setup, ExecuteFn execute) {
+    passes.push_back({});
+    passes.back().name = name;
+    passes.back().execute = std::move(execute);
+
+    PassBuilder builder(*this, static_cast<uint32_t>(passes.size() - 1));
+    setup(builder);
+    passes[builder.pass].sideEffects = builder.sideEffects;
+}
+
+RenderGraph::Resource RenderGraph::importImage(const std::string& name, VkImage image, VkImageView view, VkFormat format,
+                                               VkExtent2D extent, ImageState* state) {
+    if (!state) throw std::runtime_error("render graph: imported image " + name + " needs a state");
+
+    ResourceDecl decl;
+    decl.name = name;
+    decl.isImage = true;
+    decl.imported = true;
+    decl.imageDesc.format = format;
+    decl.extent = extent;
+    decl.image = image;
+    decl.view = view;
+    decl.state = state;
+    return addResource(std::move(decl));
+}
+
+void RenderGraph::forgetImageView(VkImageView view) {
+    if (!view) return;
+    for (auto it = framebuffers.begin(); it != framebuffers.end();) {
+        if (std::find(it->second.views.begin(), it->second.views.end(), view) != it->second.views.end()) {
+            VkFramebuffer fb = it->second.framebuffer;
+            engine->retire([device = device, fb]() { vkDestroyFramebuffer(device, fb, nullptr); });
+            it = framebuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RenderGraph::addBackbufferPass(ExecuteFn execute) {
+    addPass("backbuffer", [this](PassBuilder& builder) {
+        builder.setSideEffects();
+        for (Resource r : backbufferReads) builder.read(r, Access::FragmentSampled);
+    }, std::move(execute));
+}
+
+std::vector<bool> RenderGraph::cull() const {
+    // walk backwards keeping track of which resources still have a reader downstream
+    std::vector<bool> needed(resources.size(), false);
+    std::vector<bool> live(passes.size(), false);
+
+    for (size_t i = passes.size(); i-- > 0;) {
+        const PassDecl& pass = passes[i];
+
+        bool isLive = pass.sideEffects;
+        for (const auto& use : pass.uses) {
+            if (accessInfo(use.access).write && (needed[use.resource] || resources[use.resource].imported)) isLive = true;
+        }
+        if (!isLive) continue;
+        live[i] = true;
+
+        auto cleared = [&](Resource r) {
+            return std::any_of(pass.clears.begin(), pass.clears.end(), [&](const auto& c) { return c.first == r; });
+        };
+
+        // a cleared attachment doesn't care what was there before, anything else might read it (load, partial writes)
+        for (const auto& use : pass.uses) {
+            if (accessInfo(use.access).write && cleared(use.resource)) needed[use.resource] = false;
+        }
+        for (const auto& use : pass.uses) {
+            if (!accessInfo(use.access).write || !cleared(use.resource)) needed[use.resource] = true;
+        }
+    }
+    return live;
+}
+
+void RenderGraph::compile() {
+    const std::vector<bool> live = cull();
+
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (live[i]) order.push_back(i);
+    }
+
+    stats.passCount = static_cast<uint32_t>(order.size());
+    stats.culledPasses = static_cast<uint32_t>(passes.size() - order.size());
+
+    // lifetimes and usage come from live passes only, a culled pass doesn't keep memory alive
+    for (uint32_t pos = 0; pos < order.size(); pos++) {
+        for (const auto& use : passes[order[pos]].uses) {
+            ResourceDecl& res = resources[use.resource];
+            const AccessInfo info = accessInfo(use.access);
+            res.imageUsage |= info.imageUsage;
+            res.bufferUsage |= info.bufferUsage;
+            res.firstUse = std::min(res.firstUse, pos);
+            res.lastUse = std::max(res.lastUse, pos);
+        }
+    }
+
+    realize();
+    buildBarriers(order);
+}
+
+void RenderGraph::realize() {
+    uint64_t signature = Hash::FNV_OFFSET;
+    std::vector<Resource> transients;
+    for (Resource r = 0; r < resources.size(); r++) {
+        const ResourceDecl& res = resources[r];
+        if (res.imported || res.firstUse == UINT32_MAX) continue;
+        transients.push_back(r);
+
+        signature = Hash::combine(signature, res.isImage);
+        signature = Hash::combine(signature, res.isImage ? static_cast<uint64_t>(res.imageDesc.format) : res.bufferDesc.size);
+        signature = Hash::combine(signature, (static_cast<uint64_t>(res.extent.width) << 32) | res.extent.height);
+        signature = Hash::combine(signature, res.isImage ? res.imageUsage : res.bufferUsage);
+        signature = Hash::combine(signature, (static_cast<uint64_t>(res.firstUse) << 32) | res.lastUse);
+    }
+
+    if (!physical || signature != physicalSignature) {
+        if (physical) {
+            // the frames in flight may still be using the old set and the framebuffers over it
+            std::shared_ptr<PhysicalSet> old = std::move(physical);
+            std::vector<VkFramebuffer> oldFramebuffers;
+            for (auto& [key, fb] : framebuffers) oldFramebuffers.push_back(fb.framebuffer);
+            framebuffers.clear();
+
+            GpuAllocator* allocator = &engine->getAllocator();
+            engine->retire([device = device, allocator, old, oldFramebuffers]() {
+                for (VkFramebuffer fb : oldFramebuffers) vkDestroyFramebuffer(device, fb, nullptr);
+                old->destroy(device, *allocator);
+            });
+        }
+
+        auto next = std::make_shared<PhysicalSet>();
+        GpuAllocator& allocator = engine->getAllocator();
+
+        try {
+            for (Resource r : transients) {
+                const ResourceDecl& res = resources[r];
+                PhysicalSet::Entry entry;
+
+                if (res.isImage) {
+                    VkImageCreateInfo info{};
+                    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                    info.imageType = VK_IMAGE_TYPE_2D;
+                    info.format = res.imageDesc.format;
+                    info.extent = { res.extent.width, res.extent.height, 1 };
+                    info.mipLevels = 1;
+                    info.arrayLayers = 1;
+                    info.samples = VK_SAMPLE_COUNT_1_BIT;
+                    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+                    info.usage = res.imageUsage;
+                    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                    VK_CHECK(vkCreateImage(device, &info, nullptr, &entry.image));
+                    vkGetImageMemoryRequirements(device, entry.image, &entry.reqs);
+                } else {
+                    VkBufferCreateInfo info{};
+                    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+                    info.size = res.bufferDesc.size;
+                    info.usage = res.bufferUsage;
+                    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                    VK_CHECK(vkCreateBuffer(device, &info, nullptr, &entry.buffer));
+                    vkGetBufferMemoryRequirements(device, entry.buffer, &entry.reqs);
+                }
+                next->entries.push_back(entry);
+            }
+
+            // biggest first, each one joins the first slot of its kind it doesn't overlap anyone in
+            std::vector<uint32_t> bySize(transients.size());
+            for (uint32_t i = 0; i < bySize.size(); i++) bySize[i] = i;
+            std::stable_sort(bySize.begin(), bySize.end(), [&](uint32_t a, uint32_t b) {
+                return next->entries[a].reqs.size > next->entries[b].reqs.size;
+            });
+
+            for (uint32_t i : bySize) {
+                const ResourceDecl& res = resources[transients[i]];
+                PhysicalSet::Entry& entry = next->entries[i];
+                const std::pair<uint32_t, uint32_t> lifetime{ res.firstUse, res.lastUse };
+
+                uint32_t slotIndex = UINT32_MAX;
+                for (uint32_t s = 0; s < next->slots.size() && slotIndex == UINT32_MAX; s++) {
+                    const auto& slot = next->slots[s];
+                    if (slot.isImage != res.isImage) continue;
+                    if ((slot.reqs.memoryTypeBits & entry.reqs.memoryTypeBits) == 0) continue;
+
+                    const bool overlaps = std::any_of(slot.lifetimes.begin(), slot.lifetimes.end(), [&](const auto& l) {
+                        return lifetime.first <= l.second && l.first <= lifetime.second;
+                    });
+                    if (!overlaps) slotIndex = s;
+                }
+
+                if (slotIndex == UINT32_MAX) {
+                    PhysicalSet::Slot slot;
+                    slot.isImage = res.isImage;
+                    slot.reqs = entry.reqs;
+                    next->slots.push_back(slot);
+                    slotIndex = static_cast<uint32_t>(next->slots.size() - 1);
+                }
+
+                auto& slot = next->slots[slotIndex];
+                slot.reqs.size = std::max(slot.reqs.size, entry.reqs.size);
+                slot.reqs.alignment = std::max(slot.reqs.alignment, entry.reqs.alignment);
+                slot.reqs.memoryTypeBits &= entry.reqs.memoryTypeBits;
+                slot.lifetimes.push_back(lifetime);
+                entry.slot = slotIndex;
+            }
+
+            for (auto& slot : next->slots) {
+                slot.memory = allocator.allocate(slot.reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                 slot.isImage ? GpuAllocator::Kind::Image : GpuAllocator::Kind::Buffer);
+            }
+
+            for (uint32_t i = 0; i < transients.size(); i++) {
+                const ResourceDecl& res = resources[transients[i]];
+                PhysicalSet::Entry& entry = next->entries[i];
+                const GpuAllocation& memory = next->slots[entry.slot].memory;
+
+                if (!res.isImage) {
+                    VK_CHECK(vkBindBufferMemory(device, entry.buffer, memory.memory, memory.offset));
+                    continue;
+                }
+
+                VK_CHECK(vkBindImageMemory(device, entry.image, memory.memory, memory.offset));
+
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = entry.image;
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = res.imageDesc.format;
+                viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+                VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &entry.view));
+            }
+        } catch (...) {
+            next->destroy(device, allocator);
+            throw;
+        }
+
+        physical = std::move(next);
+        physicalSignature = signature;
+        stats.rebuilds++;
+
+        stats.transientImages = 0;
+        stats.transientBuffers = 0;
+        stats.transientBytes = 0;
+        stats.allocatedBytes = 0;
+        for (uint32_t i = 0; i < transients.size(); i++) {
+            (resources[transients[i]].isImage ? stats.transientImages : stats.transientBuffers)++;
+            stats.transientBytes += physical->entries[i].reqs.size;
+        }
+        for (const auto& slot : physical->slots) stats.allocatedBytes += slot.reqs.size;
+
+        if (!transients.empty()) printf("[render graph] %u transient resources, %.2f MiB in %zu allocations (%.2f MiB without aliasing)\n",
+               static_cast<uint32_t>(transients.size()), stats.allocatedBytes / (1024.0 * 1024.0), physical->slots.size(),
+               stats.transientBytes / (1024.0 * 1024.0));
+    }
+
+    for (uint32_t i = 0; i < transients.size(); i++) {
+        resources[transients[i]].physical = i;
+    }
+}
+
+void RenderGraph::buildBarriers(const std::vector<uint32_t>& order) {
+    std::vector<UseState> states(resources.size());
+    std::vector<bool> touched(resources.size(), false);
+
+    for (Resource r = 0; r < resources.size(); r++) {
+        if (resources[r].imported) {
+            const ImageState& s = *resources[r].state;
+            states[r].layout = s.layout;
+            states[r].writeStages = s.stages;
+            states[r].writeAccess = s.access;
+        }
+    }
+
+    stats.barrierCount = 0;
+    compiled.clear();
+    compiled.reserve(order.size());
+
+    for (uint32_t pos = 0; pos < order.size(); pos++) {
+        const PassDecl& pass = passes[order[pos]];
+        CompiledPass cp;
+        cp.pass = order[pos];
+
+        // one merged use per resource, a pass can't see the same image in two layouts
+        struct Merged {
+            Resource resource;
+            AccessInfo info;
+            bool colorAttachment;
+        };
+        std::vector<Merged> merged;
+        for (const auto& use : pass.uses) {
+            const AccessInfo info = accessInfo(use.access);
+            auto it = std::find_if(merged.begin(), merged.end(), [&](const Merged& m) { return m.resource == use.resource; });
+            if (it == merged.end()) {
+                merged.push_back({ use.resource, info, use.access == Access::ColorAttachment });
+                continue;
+            }
+            if (resources[use.resource].isImage && it->info.layout != info.layout)
+                throw std::runtime_error("render graph: " + pass.name + " uses " + resources[use.resource].name + " in two layouts");
+            it->info.stages |= info.stages;
+            it->info.access |= info.access;
+            it->info.write |= info.write;
+            it->colorAttachment |= use.access == Access::ColorAttachment;
+        }
+
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<VkImageView> attachmentViews;
+
+        for (const Merged& m : merged) {
+            ResourceDecl& res = resources[m.resource];
+            UseState& state = states[m.resource];
+            PhysicalSet::Slot* slot = res.imported ? nullptr : &physical->slots[physical->entries[res.physical].slot];
+
+            VkPipelineStageFlags src = 0;
+            VkAccessFlags srcAccess = 0;
+            VkImageLayout oldLayout = state.layout;
+            bool needed = false;
+
+            if (!touched[m.resource] && slot) {
+                // first use this frame, contents are whatever the previous resident left, wait for it to be done
+                src = slot->stages;
+                srcAccess = slot->writeAccess;
+                oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                needed = true;
+            } else if (m.info.write) {
+                // write after anything: wait for earlier writes and reads
+                src = state.writeStages | state.readStages;
+                srcAccess = state.writeAccess;
+                needed = src != 0 || (res.isImage && oldLayout != m.info.layout);
+            } else if (res.isImage && oldLayout != m.info.layout) {
+                src = state.writeStages | state.readStages;
+                srcAccess = state.writeAccess;
+                needed = true;
+            } else if ((m.info.stages & ~state.visibleStages) != 0 && state.writeStages != 0) {
+                // read after write, unless an earlier barrier already covered these stages
+                src = state.writeStages;
+                srcAccess = state.writeAccess;
+                needed = true;
+            }
+
+            if (needed) {
+                if (src == 0) src = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                cp.srcStages |= src;
+                cp.dstStages |= m.info.stages;
+
+                const bool layoutChange = res.isImage && oldLayout != m.info.layout;
+                if (res.isImage && (layoutChange || srcAccess != 0)) {
+                    VkImageMemoryBarrier barrier{};
+                    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                    barrier.srcAccessMask = srcAccess;
+                    barrier.dstAccessMask = m.info.access;
+                    barrier.oldLayout = oldLayout;
+                    barrier.newLayout = m.info.layout;
+                    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.image = getImage(m.resource);
+                    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+                    cp.imageBarriers.push_back(barrier);
+                } else if (!res.isImage && srcAccess != 0) {
+                    VkBufferMemoryBarrier barrier{};
+                    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                    barrier.srcAccessMask = srcAccess;
+                    barrier.dstAccessMask = m.info.access;
+                    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.buffer = getBuffer(m.resource);
+                    barrier.offset = 0;
+                    barrier.size = VK_WHOLE_SIZE;
+                    cp.bufferBarriers.push_back(barrier);
+                }
+            }
+
+            // render pass load op, from what the image holds right before this pass
+            if (m.colorAttachment) {
+                const bool cleared = std::any_of(pass.clears.begin(), pass.clears.end(), [&](const auto& c) { return c.first == m.resource; });
+                const bool undefined = oldLayout == VK_IMAGE_LAYOUT_UNDEFINED;
+                const bool lastUse = !res.imported && res.lastUse == pos;
+
+                VkAttachmentDescription desc{};
+                desc.format = res.imageDesc.format;
+                desc.samples = VK_SAMPLE_COUNT_1_BIT;
+                desc.loadOp = cleared ? VK_ATTACHMENT_LOAD_OP_CLEAR : undefined ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
+                desc.storeOp = lastUse ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+                desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                desc.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                desc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                attachments.push_back(desc);
+                attachmentViews.push_back(getImageView(m.resource));
+
+                VkClearValue clearValue{};
+                for (const auto& c : pass.clears) {
+                    if (c.first == m.resource) clearValue.color = c.second;
+                }
+                cp.clearValues.push_back(clearValue);
+
+                if (attachments.size() == 1) {
+                    cp.extent = res.extent;
+                } else if (cp.extent.width != res.extent.width || cp.extent.height != res.extent.height) {
+                    throw std::runtime_error("render graph: color attachments of " + pass.name + " differ in size");
+                }
+            }
+
+            // what the resource looks like after this pass
+            if (m.info.write || (res.isImage && oldLayout != m.info.layout) || (!touched[m.resource] && slot)) {
+                state.writeStages = m.info.stages;
+                state.writeAccess = m.info.write ? (m.info.access & WRITE_ACCESS) : 0;
+                state.readStages = 0;
+                state.visibleStages = m.info.stages;
+            } else {
+                state.readStages |= m.info.stages;
+                if (needed) state.visibleStages |= m.info.stages;
+            }
+            if (res.isImage) state.layout = m.info.layout;
+            touched[m.resource] = true;
+
+            if (slot) {
+                slot->stages = state.writeStages | state.readStages;
+                slot->writeAccess = state.writeAccess;
+            }
+        }
+
+        if (cp.srcStages) {
+            const uint32_t count = static_cast<uint32_t>(cp.imageBarriers.size() + cp.bufferBarriers.size());
+            stats.barrierCount += std::max(1u, count);
+        }
+
+        if (!attachments.empty() && engine->hasDynamicRendering()) {
+            // the same load / store ops, nothing to create or cache
+            for (size_t i = 0; i < attachments.size(); i++) {
+                VkRenderingAttachmentInfo info{};
+                info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+                info.imageView = attachmentViews[i];
+                info.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                info.loadOp = attachments[i].loadOp;
+                info.storeOp = attachments[i].storeOp;
+                info.clearValue = cp.clearValues[i];
+                cp.colorAttachments.push_back(info);
+            }
+        } else if (!attachments.empty()) {
+            cp.renderPass = getRenderPass(attachments);
+            cp.framebuffer = getFramebuffer(cp.renderPass, attachmentViews, cp.extent);
+        } else {
+            cp.extent = renderExtent;
+        }
+        compiled.push_back(std::move(cp));
+    }
+
+    // imports carry their state into the next frame
+    for (Resource r = 0; r < resources.size(); r++) {
+        if (!resources[r].imported || !touched[r]) continue;
+        ImageState& s = *resources[r].state;
+        s.layout = states[r].layout;
+        s.stages = states[r].writeStages | states[r].readStages;
+        s.access = states[r].writeAccess;
+    }
+}
+
+void RenderGraph::execute(VkCommandBuffer cmd) {
+    for (const CompiledPass& cp : compiled) {
+        const PassDecl& pass = passes[cp.pass];
+
+        if (cp.srcStages) {
+            vkCmdPipelineBarrier(cmd, cp.srcStages, cp.dstStages, 0,
+                                 0, nullptr,
+                                 static_cast<uint32_t>(cp.bufferBarriers.size()), cp.bufferBarriers.data(),
+                                 static_cast<uint32_t>(cp.imageBarriers.size()), cp.imageBarriers.data());
+        }
+
+        PassContext ctx{ cmd, cp.extent, cp.renderPass };
+        const bool raster = cp.renderPass || !cp.colorAttachments.empty();
+
+        if (raster) {
+            if (cp.renderPass) {
+                VkRenderPassBeginInfo rpInfo{};
+                rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                rpInfo.renderPass = cp.renderPass;
+                rpInfo.framebuffer = cp.framebuffer;
+                rpInfo.renderArea.extent = cp.extent;
+                rpInfo.clearValueCount = static_cast<uint32_t>(cp.clearValues.size());
+                rpInfo.pClearValues = cp.clearValues.data();
+                vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
+            } else {
+                VkRenderingInfo info{};
+                info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+                info.renderArea.extent = cp.extent;
+                info.layerCount = 1;
+                info.colorAttachmentCount = static_cast<uint32_t>(cp.colorAttachments.size());
+                info.pColorAttachments = cp.colorAttachments.data();
+                engine->beginRendering(cmd, info);
+            }
+
+            VkViewport vp{ 0.0f, 0.0f, static_cast<float>(cp.extent.width), static_cast<float>(cp.extent.height), 0.0f, 1.0f };
+            VkRect2D sci{ {0, 0}, cp.extent };
+            vkCmdSetViewport(cmd, 0, 1, &vp);
+            vkCmdSetScissor(cmd, 0, 1, &sci);
+        }
+
+        if (pass.execute) pass.execute(ctx);
+
+        if (cp.renderPass) vkCmdEndRenderPass(cmd);
+        else if (raster) engine->endRendering(cmd);
+    }
+}
+
+VkImage RenderGraph::getImage(Resource resource) const {
+    const ResourceDecl& res = resources.at(resource);
+    if (res.imported) return res.image;
+    return res.physical == UINT32_MAX ? VK_NULL_HANDLE : physical->entries[res.physical].image;
+}
+
+VkImageView RenderGraph::getImageView(Resource resource) const {
+    const ResourceDecl& res = resources.at(resource);
+    if (res.imported) return res.view;
+    return res.physical == UINT32_MAX ? VK_NULL_HANDLE : physical->entries[res.physical].view;
+}
+
+VkBuffer RenderGraph::getBuffer(Resource resource) const {
+    const ResourceDecl& res = resources.at(resource);
+    return res.physical == UINT32_MAX ? VK_NULL_HANDLE : physical->entries[res.physical].buffer;
+}
+
+VkExtent2D RenderGraph::getExtent(Resource resource) const {
+    return resources.at(resource).extent;
+}
+
+VkFormat RenderGraph::getFormat(Resource resource) const {
+    return resources.at(resource).imageDesc.format;
+}
+
+VkDescriptorSet RenderGraph::allocateSet(VkDescriptorSetLayout layout) {
+    VkDescriptorSetAllocateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr,
+                                      descriptorPools[frameIndex], 1, &layout };
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    std::lock_guard<std::mutex> lock(descriptorPoolMutex);
+    if (vkAllocateDescriptorSets(device, &info, &set) != VK_SUCCESS)
+        throw std::runtime_error("render graph: frame descriptor pool exhausted");
+    return set;
+}
+
+VkRenderPass RenderGraph::getCompatibleRenderPass(VkFormat format) {
+    // load / store ops don't take part in render pass compatibility
+    VkAttachmentDescription desc{};
+    desc.format = format;
+    desc.samples = VK_SAMPLE_COUNT_1_BIT;
+    desc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    desc.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    desc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    return getRenderPass({ desc });
+}
+
+VkRenderPass RenderGraph::getRenderPass(const std::vector<VkAttachmentDescription>& attachments) {
+    uint64_t key = Hash::FNV_OFFSET;
+    for (const auto& a : attachments) {
+        key = Hash::combine(key, static_cast<uint64_t>(a.format));
+        key = Hash::combine(key, (static_cast<uint64_t>(a.loadOp) << 32) | static_cast<uint64_t>(a.storeOp));
+    }
+
+    std::lock_guard<std::mutex> lock(renderPassMutex);
+    auto it = renderPasses.find(key);
+    if (it != renderPasses.end()) return it->second;
+
+    // layouts are handled by the graph's barriers, the pass neither transitions nor waits on anything
+    std::vector<VkAttachmentReference> refs;
+    for (uint32_t i = 0; i < attachments.size(); i++) {
+        refs.push_back({ i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(refs.size());
+    subpass.pColorAttachments = refs.data();
+
+    VkRenderPassCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    info.attachmentCount = static_cast<uint32_t>(attachments.size());
+    info.pAttachments = attachments.data();
+    info.subpassCount = 1;
+    info.pSubpasses = &subpass;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateRenderPass(device, &info, nullptr, &renderPass));
+    renderPasses.emplace(key, renderPass);
+    return renderPass;
+}
+
+VkFramebuffer RenderGraph::getFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView>& views, VkExtent2D extent) {
+    uint64_t key = Hash::combine(Hash::FNV_OFFSET, reinterpret_cast<uint64_t>(renderPass));
+    for (VkImageView view : views) key = Hash::combine(key, reinterpret_cast<uint64_t>(view));
+    key = Hash::combine(key, (static_cast<uint64_t>(extent.width) << 32) | extent.height);
+
+    auto it = framebuffers.find(key);
+    if (it != framebuffers.end()) {
+        it->second.lastUsed = frameNumber;
+        return it->second.framebuffer;
+    }
+
+    VkFramebufferCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    info.renderPass = renderPass;
+    info.attachmentCount = static_cast<uint32_t>(views.size());
+    info.pAttachments = views.data();
+    info.width = extent.width;
+    info.height = extent.height;
+    info.layers = 1;
+
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateFramebuffer(device, &info, nullptr, &framebuffer));
+    framebuffers[key] = { framebuffer, frameNumber, views };
+    return framebuffer;
+}
@@ -0,0 +1,66 @@
+// copyright 2025 swaroop.
+
+#include <core/resolution_governor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    // weight of a new sample, ~10 frames of memory
+    constexpr double SMOOTHING = 0.1;
+}
+
+void ResolutionGovernor::setConfig(const Config& newConfig) {
+    config = newConfig;
+    config.minScale = std::clamp(config.minScale, 0.05f, 1.0f);
+    config.maxScale = std::clamp(config.maxScale, config.minScale, 1.0f);
+    config.step = std::max(config.step, 0.01f);
+
+    // starts at full quality, the first slow frames bring it down
+    scale = config.maxScale;
+    smoothedMs = 0.0;
+    settle = 0;
+    underFrames = 0;
+}
+
+void ResolutionGovernor::update(double gpuMs, uint32_t settleFrames) {
+    if (gpuMs <= 0.0) return;
+    if (settle > 0) {
+        settle--;
+        return;
+    }
+
+    smoothedMs = smoothedMs > 0.0 ? smoothedMs + (gpuMs - smoothedMs) * SMOOTHING : gpuMs;
+
+    const double high = config.budgetMs * (1.0 + config.hysteresis);
+    const double low = config.budgetMs * (1.0 - config.hysteresis);
+
+    bool changed = false;
+    if (smoothedMs > high) {
+        underFrames = 0;
+        if (scale > config.minScale) changed = retarget();
+    } else if (smoothedMs < low) {
+        if (scale < config.maxScale && ++underFrames >= config.growFrames) changed = retarget();
+    } else {
+        underFrames = 0;
+    }
+
+    // the next few samples are frames recorded before the change
+    if (changed) settle = settleFrames;
+}
+
+bool ResolutionGovernor::retarget() {
+    const float wanted = scale * static_cast<float>(std::sqrt(config.budgetMs / smoothedMs));
+
+    // snapping down keeps a shrink from landing right back over the budget
+    float snapped = std::floor(wanted / config.step + 1e-4f) * config.step;
+    snapped = std::clamp(snapped, config.minScale, config.maxScale);
+    underFrames = 0;
+    if (std::fabs(snapped - scale) < 1e-4f) return false;
+
+    printf("[resolution governor] %.2f -> %.2f (gpu %.2f ms, budget %.2f ms)\n", scale, snapped, smoothedMs, config.budgetMs);
+    scale = snapped;
+    smoothedMs = 0.0;
+    return true;
+}
@@ -0,0 +1,226 @@
+// copyright 2025 swaroop.
+
+#include <core/secondary_recorder.h>
+#include <engine.h>
+
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+
+#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in SecondaryRecorder"); } while (0)
+
+void SecondaryRecorder::init(Engine* engineRef, uint32_t framesInFlight, uint32_t maxWorkers) {
+    engine = engineRef;
+    device = engine->getDevice();
+
+    // no threads of our own, the cores are the JobSystem's to hand out
+    workerCount = engine->getJobSystem().getWorkerCount();
+    recordingWorkers = maxWorkers ? std::min(maxWorkers, workerCount) : workerCount;
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = engine->getGraphicsQueueFamily();
+
+    pools.resize(framesInFlight);
+    for (auto& framePools : pools) {
+        framePools.resize(workerCount + 1);
+        for (auto& pool : framePools) {
+            VK_CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &pool.pool));
+        }
+    }
+
+    // cached buffers are re-recorded one at a time, so they need resetting on their own
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    caches.resize(framesInFlight);
+    for (auto& cache : caches) {
+        VK_CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &cache.pool));
+    }
+}
+
+void SecondaryRecorder::shutdown() {
+    // the JobSystem shut down first, no job is recording anymore
+    // destroying a pool frees its buffers
+    for (auto& framePools : pools) {
+        for (auto& pool : framePools) {
+            if (pool.pool) vkDestroyCommandPool(device, pool.pool, nullptr);
+        }
+    }
+    pools.clear();
+
+    for (auto& cache : caches) {
+        if (cache.pool) vkDestroyCommandPool(device, cache.pool, nullptr);
+    }
+    caches.clear();
+}
+
+void SecondaryRecorder::beginFrame(uint32_t index) {
+    frameIndex = index;
+    for (auto& pool : pools[frameIndex]) {
+        if (pool.used == 0) continue;
+        vkResetCommandPool(device, pool.pool, 0);
+        pool.used = 0;
+    }
+}
+
+void SecondaryRecorder::drain() {
+    // a thread outside the pool running jobs in a wait() has no pool here, the render thread takes its share
+    const uint32_t thread = engine->getJobSystem().getCurrentWorker();
+    if (thread >= workerCount) return;
+
+    // picked up after record() returned, the queue is empty then
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!queue.empty()) {
+        const uint32_t job = queue.front();
+        queue.pop_front();
+
+        lock.unlock();
+        recordJob(thread, job);
+        lock.lock();
+
+        if (--outstanding == 0) jobsFinished.notify_all();
+    }
+}
+
+std::vector<VkCommandBuffer> SecondaryRecorder::record(const Target& targetRef, const std::vector<Job>& jobList) {
+    std::vector<VkCommandBuffer> recorded(jobList.size(), VK_NULL_HANDLE);
+    const uint32_t renderThread = workerCount;
+
+    // entries past the end belong to jobs that are gone, this slot's last submit is done with them
+    Cache& cache = caches[frameIndex];
+    for (size_t i = jobList.size(); i < cache.entries.size(); i++) {
+        if (cache.entries[i].buffer) vkFreeCommandBuffers(device, cache.pool, 1, &cache.entries[i].buffer);
+    }
+    cache.entries.resize(jobList.size());
+    replayed = 0;
+
+    uint32_t parallel = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        target = &targetRef;
+        jobs = &jobList;
+        results = &recorded;
+        error = nullptr;
+        outstanding = 0;
+        for (uint32_t i = 0; i < jobList.size(); i++) {
+            if (!jobList[i].parallel || jobList[i].cacheKey) continue;
+            queue.push_back(i);
+            outstanding++;
+        }
+        parallel = outstanding;
+    }
+    // each job records until the queue is empty, a worker busy with something else just leaves it to the rest
+    JobSystem& jobSystem = engine->getJobSystem();
+    for (uint32_t i = 0; i < std::min(parallel, recordingWorkers); i++) {
+        jobSystem.submit([this] { drain(); });
+    }
+
+    for (uint32_t i = 0; i < jobList.size(); i++) {
+        if (jobList[i].cacheKey) recordCached(i);
+        else if (!jobList[i].parallel) recordJob(renderThread, i);
+    }
+
+    // whatever the workers haven't started yet is quicker done here than waited for
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!queue.empty()) {
+        const uint32_t job = queue.front();
+        queue.pop_front();
+
+        lock.unlock();
+        recordJob(renderThread, job);
+        lock.lock();
+        outstanding--;
+    }
+    jobsFinished.wait(lock, [&] { return outstanding == 0; });
+
+    target = nullptr;
+    jobs = nullptr;
+    results = nullptr;
+    if (error) std::rethrow_exception(std::exchange(error, nullptr));
+    return recorded;
+}
+
+void SecondaryRecorder::recordJob(uint32_t thread, uint32_t job) {
+    // an error leaves the buffer out, the pass it belonged to is thrown away with the frame anyway
+    try {
+        recordInto(allocate(thread), job, false);
+    } catch (...) {
+        setError();
+    }
+}
+
+void SecondaryRecorder::recordCached(uint32_t job) {
+    Cached& entry = caches[frameIndex].entries[job];
+    const uint64_t key = (*jobs)[job].cacheKey;
+    if (entry.buffer && entry.key == key) {
+        (*results)[job] = entry.buffer;
+        replayed++;
+        return;
+    }
+
+    try {
+        if (!entry.buffer) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = caches[frameIndex].pool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+            VK_CHECK(vkAllocateCommandBuffers(device, &allocInfo, &entry.buffer));
+        }
+
+        // stays unusable if recording throws halfway
+        entry.key = 0;
+        recordInto(entry.buffer, job, true);
+        entry.key = key;
+    } catch (...) {
+        setError();
+    }
+}
+
+void SecondaryRecorder::recordInto(VkCommandBuffer cmd, uint32_t job, bool reusable) {
+    VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &target->colorFormat;
+    renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.pNext = target->renderPass ? nullptr : &renderingInfo;
+    inheritance.renderPass = target->renderPass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = reusable ? VK_NULL_HANDLE : target->framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    if (!reusable) beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+    VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    (*jobs)[job].record(cmd);
+
+    VK_CHECK(vkEndCommandBuffer(cmd));
+    (*results)[job] = cmd;
+}
+
+void SecondaryRecorder::setError() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error) error = std::current_exception();
+}
+
+VkCommandBuffer SecondaryRecorder::allocate(uint32_t thread) {
+    Pool& pool = pools[frameIndex][thread];
+    if (pool.used == pool.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VK_CHECK(vkAllocateCommandBuffers(device, &allocInfo, &cmd));
+        pool.buffers.push_back(cmd);
+    }
+    return pool.buffers[pool.used++];
+}
@@ -0,0 +1,86 @@
+// copyright 2025 swaroop.
+
+#include <core/shader_compiler.h>
+
+#include <glslang/Public/ShaderLang.h>
+#include <glslang/Public/ResourceLimits.h>
+#include <SPIRV/GlslangToSpv.h>
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace {
+    bool stageFromPath(const std::string& path, EShLanguage& stage) {
+        const std::string ext = std::filesystem::path(path).extension().string();
+        if (ext == ".vert") stage = EShLangVertex;
+        else if (ext == ".frag") stage = EShLangFragment;
+        else if (ext == ".comp") stage = EShLangCompute;
+        else return false;
+        return true;
+    }
+
+    void initGlslang() {
+        // process wide, glslang keeps per-thread pools after this so workers can compile concurrently
+        static std::once_flag once;
+        std::call_once(once, [] { glslang::InitializeProcess(); });
+    }
+}
+
+bool ShaderCompiler::isShaderSource(const std::string& path) {
+    EShLanguage stage;
+    return stageFromPath(path, stage);
+}
+
+bool ShaderCompiler::compileFile(const std::string& path, std::vector<uint32_t>& spirv, std::string& log) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        log = "could not open " + path;
+        return false;
+    }
+
+    std::stringstream source;
+    source << in.rdbuf();
+    return compile(source.str(), path, spirv, log);
+}
+
+bool ShaderCompiler::compile(const std::string& source, const std::string& name, std::vector<uint32_t>& spirv, std::string& log) {
+    EShLanguage stage;
+    if (!stageFromPath(name, stage)) {
+        log = "unknown shader stage for " + name;
+        return false;
+    }
+    initGlslang();
+
+    // same targets the offline build uses (cmake/shader_demo.cmake), compute gets 1.1 for subgroup operations
+    const bool compute = stage == EShLangCompute;
+    glslang::TShader shader(stage);
+    const char* text = source.c_str();
+    const char* fileName = name.c_str();
+    shader.setStringsWithLengthsAndNames(&text, nullptr, &fileName, 1);
+    shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, compute ? glslang::EShTargetVulkan_1_1 : glslang::EShTargetVulkan_1_0);
+    shader.setEnvTarget(glslang::EShTargetSpv, compute ? glslang::EShTargetSpv_1_3 : glslang::EShTargetSpv_1_0);
+
+    const auto messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+    if (!shader.parse(GetDefaultResources(), 100, false, messages)) {
+        log = shader.getInfoLog();
+        return false;
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+    if (!program.link(messages)) {
+        log = program.getInfoLog();
+        return false;
+    }
+
+    std::vector<unsigned int> words;
+    glslang::SpvOptions options;
+    glslang::GlslangToSpv(*program.getIntermediate(stage), words, &options);
+
+    spirv.assign(words.begin(), words.end());
+    log.clear();
+    return true;
+}
@@ -0,0 +1,107 @@
+// copyright 2025 swaroop.
+
+#include <core/shader_hot_reload.h>
+#include <core/shader_compiler.h>
+#include <core/pipeline_store.h>
+#include <engine.h>
+
+#include <cstdio>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+bool ShaderHotReload::start(Engine* engineRef) {
+    engine = engineRef;
+
+    // same search the spir-v loader does, the engine usually runs from a build directory
+    fs::path root;
+    for (const char* candidate : { "shader_repo", "../shader_repo", "../../shader_repo", "../../../shader_repo" }) {
+        std::error_code ec;
+        if (fs::is_directory(candidate, ec)) {
+            root = candidate;
+            break;
+        }
+    }
+    if (root.empty()) {
+        printf("[hot reload] shader_repo not found, watching nothing\n");
+        return false;
+    }
+
+    std::vector<std::string> dirs;
+    std::error_code ec;
+    for (const auto& demo : fs::directory_iterator(root, ec)) {
+        const fs::path shaders = demo.path() / "shaders";
+        if (fs::is_directory(shaders, ec)) dirs.push_back(shaders.generic_string());
+    }
+
+    // the engine's fullscreen / upscale shaders sit next to shader_repo
+    const fs::path engineDir = root.parent_path() / "shaders";
+    engineShaders.clear();
+    if (fs::is_directory(engineDir, ec)) {
+        engineShaders = engineDir.lexically_normal().generic_string();
+        dirs.push_back(engineDir.generic_string());
+    }
+
+    if (!watcher.start(dirs, [this](const std::vector<std::string>& paths) { onFilesChanged(paths); })) {
+        printf("[hot reload] no shader directories under %s\n", root.generic_string().c_str());
+        return false;
+    }
+
+    printf("[hot reload] watching %zu shader directories\n", dirs.size());
+    return true;
+}
+
+void ShaderHotReload::stop() {
+    watcher.stop();
+}
+
+void ShaderHotReload::onFilesChanged(const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+        if (!ShaderCompiler::isShaderSource(path)) continue;
+
+        // programs refer to their spir-v as shader_repo/<demo>/shaders/<file>.spv, or shaders/<file>.spv for the engine's
+        const fs::path source(path);
+        const std::string file = source.filename().generic_string() + ".spv";
+        std::string spvKey;
+        if (!engineShaders.empty() && source.parent_path().lexically_normal().generic_string() == engineShaders) {
+            spvKey = "shaders/" + file;
+        } else {
+            const std::string demo = source.parent_path().parent_path().filename().generic_string();
+            spvKey = "shader_repo/" + demo + "/shaders/" + file;
+        }
+
+        std::vector<uint32_t> spirv;
+        std::string log;
+        bool ok = ShaderCompiler::compileFile(path, spirv, log);
+
+        if (ok) ok = engine->getPipelineStore().reload(spvKey, std::move(spirv), log);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ok) {
+            errors.erase(path);
+            lastReloaded = source.filename().generic_string();
+            reloadCount++;
+            printf("[hot reload] %s reloaded\n", lastReloaded.c_str());
+        } else {
+            errors[path] = log;
+            printf("[hot reload] %s failed:\n%s\n", path.c_str(), log.c_str());
+        }
+    }
+}
+
+std::vector<ShaderHotReload::Error> ShaderHotReload::getErrors() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Error> out;
+    for (const auto& [path, log] : errors) out.push_back({ path, log });
+    return out;
+}
+
+std::string ShaderHotReload::getLastReloaded() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastReloaded;
+}
+
+uint32_t ShaderHotReload::getReloadCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reloadCount;
+}
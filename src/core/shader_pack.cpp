@@ -0,0 +1,255 @@
+// copyright 2025 swaroop.
+
+#include <core/shader_pack.h>
+#include <util/hash.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t PACK_MAGIC = 0x50534B56; // "VKSP"
+    constexpr uint32_t PACK_VERSION = 1;
+    constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+    struct PackHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+        uint64_t indexOffset;
+        uint64_t stringsOffset;
+        uint64_t fileSize;
+    };
+
+    struct PackEntry {
+        uint64_t nameHash;
+        uint64_t contentHash;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+        uint32_t nameOffset; // into the string table
+        uint32_t nameLength;
+    };
+
+    uint64_t alignUp(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+    bool entryLess(const PackEntry& e, uint64_t hash) { return e.nameHash < hash; }
+}
+
+bool ShaderPack::open(const std::string& path) {
+    close();
+    if (!map(path)) return false;
+
+    auto fail = [&](const char* why) {
+        printf("[shader pack] %s: %s\n", path.c_str(), why);
+        close();
+        return false;
+    };
+
+    if (mappedSize < sizeof(PackHeader)) return fail("truncated");
+
+    const auto* header = reinterpret_cast<const PackHeader*>(base);
+    if (header->magic != PACK_MAGIC || header->version != PACK_VERSION) return fail("not a shader pack or wrong version");
+    if (header->fileSize != mappedSize) return fail("size mismatch");
+    if (header->indexOffset + uint64_t(header->entryCount) * sizeof(PackEntry) > mappedSize) return fail("index out of bounds");
+
+    const auto* entries = reinterpret_cast<const PackEntry*>(base + header->indexOffset);
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        const PackEntry& e = entries[i];
+        if (header->stringsOffset + e.nameOffset + e.nameLength > mappedSize ||
+            e.dataOffset + e.dataSize > mappedSize ||
+            e.dataOffset % 4 != 0 || e.dataSize % 4 != 0)
+            return fail("entry out of bounds");
+
+        // a stale or half-written pack would hand the driver garbage, catch it here instead
+        if (Hash::fnv1a(base + e.dataOffset, static_cast<size_t>(e.dataSize)) != e.contentHash)
+            return fail("content hash mismatch");
+    }
+
+    entryCount = header->entryCount;
+    printf("[shader pack] %s: %u shaders\n", path.c_str(), entryCount);
+    return true;
+}
+
+void ShaderPack::close() {
+    unmap();
+    entryCount = 0;
+}
+
+ShaderPack::Blob ShaderPack::find(std::string_view name) const {
+    if (!base) return {};
+
+    const auto* header = reinterpret_cast<const PackHeader*>(base);
+    const auto* entries = reinterpret_cast<const PackEntry*>(base + header->indexOffset);
+    const char* strings = reinterpret_cast<const char*>(base + header->stringsOffset);
+    const uint64_t hash = Hash::fnv1a(name);
+
+    for (const PackEntry* e = std::lower_bound(entries, entries + entryCount, hash, entryLess);
+         e != entries + entryCount && e->nameHash == hash; ++e) {
+        if (std::string_view(strings + e->nameOffset, e->nameLength) != name) continue;
+        return { reinterpret_cast<const uint32_t*>(base + e->dataOffset), static_cast<size_t>(e->dataSize), e->contentHash };
+    }
+    return {};
+}
+
+bool ShaderPack::write(const std::string& path, const std::vector<std::pair<std::string, std::vector<char>>>& files,
+                       std::string& error) {
+    std::vector<PackEntry> entries;
+    std::string strings;
+
+    for (const auto& [name, data] : files) {
+        if (data.size() % 4 != 0) {
+            error = name + " is not a spir-v module (size is not a multiple of 4)";
+            return false;
+        }
+
+        PackEntry e{};
+        e.nameHash = Hash::fnv1a(name);
+        e.contentHash = Hash::fnv1a(data.data(), data.size());
+        e.dataSize = data.size();
+        e.nameOffset = static_cast<uint32_t>(strings.size());
+        e.nameLength = static_cast<uint32_t>(name.size());
+        strings += name;
+        entries.push_back(e);
+    }
+
+    // blobs stay in input order, only the index is sorted
+    PackHeader header{};
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.indexOffset = sizeof(PackHeader);
+    header.stringsOffset = header.indexOffset + entries.size() * sizeof(PackEntry);
+
+    uint64_t offset = alignUp(header.stringsOffset + strings.size(), BLOB_ALIGNMENT);
+    for (auto& e : entries) {
+        e.dataOffset = offset;
+        offset = alignUp(offset + e.dataSize, BLOB_ALIGNMENT);
+    }
+    header.fileSize = offset;
+
+    std::vector<PackEntry> index = entries;
+    std::stable_sort(index.begin(), index.end(), [](const PackEntry& a, const PackEntry& b) { return a.nameHash < b.nameHash; });
+
+    std::vector<char> out(static_cast<size_t>(header.fileSize), 0);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + header.indexOffset, index.data(), index.size() * sizeof(PackEntry));
+    memcpy(out.data() + header.stringsOffset, strings.data(), strings.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        memcpy(out.data() + entries[i].dataOffset, files[i].second.data(), files[i].second.size());
+    }
+
+    // same write-then-rename as the pipeline cache, a running engine never maps a torn file
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f.is_open()) {
+            error = "could not write " + tmpPath;
+            return false;
+        }
+        f.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!f.good()) {
+            error = "could not write " + tmpPath;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        error = "could not replace " + path;
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool ShaderPack::map(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    base = static_cast<const uint8_t*>(view);
+    mappedSize = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void ShaderPack::unmap() {
+    if (base) UnmapViewOfFile(base);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+    base = nullptr;
+    mappedSize = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+#else
+
+bool ShaderPack::map(const std::string& path) {
+    const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+
+    struct stat st{};
+    if (fstat(file, &st) != 0 || st.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+        ::close(file);
+        return false;
+    }
+
+    fd = file;
+    base = static_cast<const uint8_t*>(view);
+    mappedSize = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void ShaderPack::unmap() {
+    if (base) munmap(const_cast<uint8_t*>(base), mappedSize);
+    if (fd >= 0) ::close(fd);
+    base = nullptr;
+    mappedSize = 0;
+    fd = -1;
+}
+
+#endif
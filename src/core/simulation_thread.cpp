@@ -0,0 +1,78 @@
+// copyright 2025 swaroop.
+
+#include <core/simulation_thread.h>
+#include <core/engine_object.h>
+#include <core/layer_component.h>
+
+#include <cstdio>
+#include <exception>
+
+void SimulationThread::start(double rate) {
+    if (isRunning()) return;
+
+    step = 1.0 / std::max(1.0, rate);
+    steps = 0;
+    time = 0.0;
+    stopping = false;
+    originNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    thread = std::thread(&SimulationThread::loop, this);
+}
+
+void SimulationThread::stop() {
+    if (!isRunning()) return;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void SimulationThread::setApp(EngineObject* appRef) {
+    std::lock_guard<std::mutex> lock(stepMutex);
+    app = appRef;
+}
+
+double SimulationThread::getRenderTime() const {
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    return static_cast<double>(now - originNs.load()) * 1e-9 - step;
+}
+
+void SimulationThread::loop() {
+    const auto stepDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(step));
+    auto next = Clock::now() + stepDuration;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            if (wake.wait_until(lock, next, [&] { return stopping; })) return;
+        }
+
+        // stalled (debugger, suspended laptop), drop the backlog and keep render time lined up with what's left
+        const auto behind = Clock::now() - next;
+        if (behind > stepDuration * MAX_CATCH_UP) {
+            const auto dropped = behind / stepDuration;
+            next += stepDuration * dropped;
+            originNs += std::chrono::duration_cast<std::chrono::nanoseconds>(stepDuration * dropped).count();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(stepMutex);
+            const double stepTime = static_cast<double>(steps + 1) * step;
+            if (app) {
+                try {
+                    for (LayerComponent* layer : app->getLayers()) {
+                        layer->onSimulate(step, stepTime);
+                    }
+                } catch (const std::exception& e) {
+                    // nothing up the stack to catch it on this thread, stop stepping the object instead
+                    printf("[simulation] %s stopped stepping: %s\n", app->getName().c_str(), e.what());
+                    app = nullptr;
+                }
+            }
+            steps++;
+            time.store(stepTime, std::memory_order_release);
+        }
+        next += stepDuration;
+    }
+}
@@ -0,0 +1,156 @@
+// copyright 2025 swaroop.
+
+#include <core/swapchain.h>
+#include <engine.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in Swapchain"); } while (0)
+
+void Swapchain::init(Engine* engineRef, VkSurfaceKHR surfaceRef) {
+    engine = engineRef;
+    device = engine->getDevice();
+    physicalDevice = engine->getPhysicalDevice();
+    surface = surfaceRef;
+    chooseFormat();
+}
+
+void Swapchain::shutdown() {
+    if (!device) return;
+
+    for (auto& image : images) {
+        if (image.view) vkDestroyImageView(device, image.view, nullptr);
+        if (image.renderFinished) vkDestroySemaphore(device, image.renderFinished, nullptr);
+    }
+    images.clear();
+    imageCount = 0;
+
+    if (swapchain) vkDestroySwapchainKHR(device, swapchain, nullptr);
+    swapchain = VK_NULL_HANDLE;
+    device = VK_NULL_HANDLE;
+}
+
+void Swapchain::chooseFormat() {
+    uint32_t formatCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, formats.data());
+    if (formats.empty()) throw std::runtime_error("surface reports no formats");
+
+    surfaceFormat = formats[0];
+    for (auto& f : formats) {
+        if (f.format == VK_FORMAT_B8G8R8A8_UNORM && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+            surfaceFormat = f;
+            break;
+        }
+    }
+}
+
+bool Swapchain::create(VkExtent2D windowExtent) {
+    VkSurfaceCapabilitiesKHR caps;
+    VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps));
+
+    // 0xFFFFFFFF means the swapchain decides, within the surface's limits
+    extent = caps.currentExtent;
+    if (extent.width == UINT32_MAX) {
+        extent.width = std::clamp(windowExtent.width, caps.minImageExtent.width, caps.maxImageExtent.width);
+        extent.height = std::clamp(windowExtent.height, caps.minImageExtent.height, caps.maxImageExtent.height);
+    }
+
+    // no wait for idle: frames in flight may still present from the old swapchain and wait on its semaphores,
+    // so all of it is retired together and goes once those frames are done
+    VkSwapchainKHR oldSwapchain = swapchain;
+    std::vector<Image> oldImages = std::move(images);
+    images.clear();
+    swapchain = VK_NULL_HANDLE;
+    imageCount = 0;
+
+    if (extent.width == 0 || extent.height == 0) {
+        retire(oldSwapchain, std::move(oldImages));
+        return false;
+    }
+
+    VkSwapchainCreateInfoKHR sci{};
+    sci.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    sci.surface = surface;
+    sci.minImageCount = std::clamp(caps.minImageCount + 1, caps.minImageCount, caps.maxImageCount > 0 ? caps.maxImageCount : 100);
+    minImageCount = std::max(2u, caps.minImageCount);
+    sci.imageFormat = surfaceFormat.format;
+    sci.imageColorSpace = surfaceFormat.colorSpace;
+    sci.imageExtent = extent;
+    sci.imageArrayLayers = 1;
+    sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    sci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    sci.preTransform = caps.currentTransform;
+    sci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    sci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    sci.clipped = VK_TRUE;
+    // lets the driver hand over what it can, the old swapchain stays valid for presents already queued
+    sci.oldSwapchain = oldSwapchain;
+
+    VkResult result = vkCreateSwapchainKHR(device, &sci, nullptr, &swapchain);
+    retire(oldSwapchain, std::move(oldImages));
+    if (result != VK_SUCCESS) {
+        swapchain = VK_NULL_HANDLE;
+        throw std::runtime_error("failed to create swapchain");
+    }
+
+    VK_CHECK(vkGetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr));
+    std::vector<VkImage> swapchainImages(imageCount);
+    VK_CHECK(vkGetSwapchainImagesKHR(device, swapchain, &imageCount, swapchainImages.data()));
+
+    VkSemaphoreCreateInfo semInfo{};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    images.resize(imageCount);
+
+    for (uint32_t i = 0; i < imageCount; i++) {
+        Image& image = images[i];
+        image.image = swapchainImages[i];
+
+        if (vkCreateSemaphore(device, &semInfo, nullptr, &image.renderFinished) != VK_SUCCESS)
+            throw std::runtime_error("semaphore creation failed");
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = surfaceFormat.format;
+        viewInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device, &viewInfo, nullptr, &image.view) != VK_SUCCESS)
+            throw std::runtime_error("swapchain view creation failed");
+    }
+    return true;
+}
+
+// the images belong to the swapchain, only the views and semaphores are ours
+void Swapchain::retire(VkSwapchainKHR old, std::vector<Image> oldImages) {
+    if (!old && oldImages.empty()) return;
+
+    engine->retire([device = device, old, oldImages = std::move(oldImages)]() {
+        for (const auto& image : oldImages) {
+            if (image.view) vkDestroyImageView(device, image.view, nullptr);
+            if (image.renderFinished) vkDestroySemaphore(device, image.renderFinished, nullptr);
+        }
+        if (old) vkDestroySwapchainKHR(device, old, nullptr);
+    });
+}
+
+VkResult Swapchain::acquire(VkSemaphore imageAvailable, uint32_t& imageIndex) {
+    if (!swapchain) return VK_ERROR_OUT_OF_DATE_KHR;
+    return vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, imageAvailable, VK_NULL_HANDLE, &imageIndex);
+}
+
+VkResult Swapchain::present(VkQueue queue, uint32_t imageIndex) {
+    VkPresentInfoKHR pi{};
+    pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    pi.waitSemaphoreCount = 1;
+    pi.pWaitSemaphores = &images[imageIndex].renderFinished;
+    pi.swapchainCount = 1;
+    pi.pSwapchains = &swapchain;
+    pi.pImageIndices = &imageIndex;
+    return vkQueuePresentKHR(queue, &pi);
+}
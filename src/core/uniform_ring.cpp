@@ -0,0 +1,124 @@
+// copyright 2025 swaroop.
+
+#include <core/uniform_ring.h>
+#include <core/pipeline_store.h>
+#include <engine.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in UniformRing"); } while (0)
+
+void UniformRing::init(Engine* engineRef, uint32_t framesInFlight, VkDeviceSize size) {
+    engine = engineRef;
+    device = engine->getDevice();
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(engine->getPhysicalDevice(), &props);
+    alignment = std::max<VkDeviceSize>(props.limits.minUniformBufferOffsetAlignment, 16);
+
+    // every region starts aligned and can hold at least one full block
+    regionSize = std::max(size, MAX_BLOCK_SIZE);
+    regionSize = (regionSize + alignment - 1) / alignment * alignment;
+    staticStride = (MAX_BLOCK_SIZE + alignment - 1) / alignment * alignment;
+    staticCount = 0;
+    freeStaticBlocks.clear();
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = regionSize * framesInFlight;
+    bufInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // device local when the driver maps vram (rebar, integrated), the shader reads it every pixel
+    engine->getAllocator().createBuffer(bufInfo,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffer, memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+    VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0, 1, 1, &poolSize };
+    VK_CHECK(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool));
+
+    VkDescriptorSetLayout setLayout = engine->getPipelineStore().getDefaultSetLayout();
+    VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, descriptorPool, 1, &setLayout };
+    VK_CHECK(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet));
+
+    VkDescriptorBufferInfo dbi{ buffer, 0, MAX_BLOCK_SIZE };
+    VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, descriptorSet, 0, 0, 1,
+                                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, nullptr, &dbi, nullptr };
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    beginFrame(0);
+}
+
+void UniformRing::shutdown() {
+    if (!device) return;
+
+    if (descriptorPool) vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    engine->getAllocator().destroyBuffer(buffer, memory);
+
+    descriptorPool = VK_NULL_HANDLE;
+    descriptorSet = VK_NULL_HANDLE;
+    buffer = VK_NULL_HANDLE;
+    memory = {};
+    device = VK_NULL_HANDLE;
+}
+
+void UniformRing::beginFrame(uint32_t frameIndex) {
+    regionBegin = regionSize * frameIndex;
+    head = regionBegin;
+}
+
+uint32_t UniformRing::push(const void* data, VkDeviceSize size) {
+    if (size > MAX_BLOCK_SIZE)
+        throw std::runtime_error("uniform block larger than UniformRing::MAX_BLOCK_SIZE");
+
+    // the descriptor always reads MAX_BLOCK_SIZE bytes, so the last block still needs that much room
+    VkDeviceSize offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(headMutex);
+        offset = head;
+        if (offset + MAX_BLOCK_SIZE > regionBegin + regionSize - staticCount * staticStride)
+            throw std::runtime_error("uniform ring region full, raise its size");
+        head = (offset + size + alignment - 1) / alignment * alignment;
+    }
+
+    // the block is ours once head has moved past it
+    memcpy(static_cast<uint8_t*>(memory.mapped) + offset, data, static_cast<size_t>(size));
+    return static_cast<uint32_t>(offset);
+}
+
+uint32_t UniformRing::allocateStatic() {
+    std::lock_guard<std::mutex> lock(headMutex);
+    if (!freeStaticBlocks.empty()) {
+        const uint32_t block = freeStaticBlocks.back();
+        freeStaticBlocks.pop_back();
+        return block;
+    }
+
+    // the dynamic part keeps room for at least one block, and whatever was pushed this frame stays where it is
+    const VkDeviceSize staticBegin = regionSize - (staticCount + 1) * staticStride;
+    if (staticBegin < MAX_BLOCK_SIZE || regionBegin + staticBegin < head)
+        throw std::runtime_error("uniform ring region full, raise its size");
+    return staticCount++;
+}
+
+void UniformRing::freeStatic(uint32_t block) {
+    // frames in flight may still read their copy, the next owner only writes the copy of a frame that is done
+    std::lock_guard<std::mutex> lock(headMutex);
+    freeStaticBlocks.push_back(block);
+}
+
+uint32_t UniformRing::writeStatic(uint32_t block, const void* data, VkDeviceSize size) {
+    if (size > MAX_BLOCK_SIZE)
+        throw std::runtime_error("uniform block larger than UniformRing::MAX_BLOCK_SIZE");
+
+    const uint32_t offset = getStaticOffset(block);
+    memcpy(static_cast<uint8_t*>(memory.mapped) + offset, data, static_cast<size_t>(size));
+    return offset;
+}
+
+uint32_t UniformRing::getStaticOffset(uint32_t block) const {
+    return static_cast<uint32_t>(regionBegin + regionSize - (block + 1) * staticStride);
+}
@@ -0,0 +1,401 @@
+// copyright 2025 swaroop.
+
+#include <core/upload_queue.h>
+#include <engine.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in UploadQueue"); } while (0)
+
+namespace {
+    // where uploaded data is read from once it reaches the graphics family
+    constexpr VkPipelineStageFlags CONSUMER_STAGES =
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    constexpr VkAccessFlags BUFFER_READS = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+}
+
+void UploadQueue::init(Engine* engineRef, VkDeviceSize size) {
+    engine = engineRef;
+    device = engine->getDevice();
+    queue = engine->getTransferQueue();
+    family = engine->getTransferQueueFamily();
+    graphicsFamily = engine->getGraphicsQueueFamily();
+    dedicated = family != graphicsFamily;
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(engine->getPhysicalDevice(), &props);
+    // 16 covers the texel size of every color format, buffer to image copies need offsets aligned to it
+    copyAlignment = std::max<VkDeviceSize>(props.limits.optimalBufferCopyOffsetAlignment, 16);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = family;
+    VK_CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool));
+
+    if (engine->hasTimelineSemaphores()) {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+        VkSemaphoreCreateInfo semInfo{};
+        semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semInfo.pNext = &typeInfo;
+        VK_CHECK(vkCreateSemaphore(device, &semInfo, nullptr, &timeline));
+
+        getCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+        waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+        if (!getCounterValue || !waitSemaphores) {
+            vkDestroySemaphore(device, timeline, nullptr);
+            timeline = VK_NULL_HANDLE;
+        }
+    }
+
+    stagingSize = (std::max<VkDeviceSize>(size, copyAlignment) + copyAlignment - 1) / copyAlignment * copyAlignment;
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = stagingSize;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    engine->getAllocator().createBuffer(bufInfo,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMemory);
+
+    head = 0;
+    tail = 0;
+    nextValue = 1;
+    completedValue = 0;
+
+    printf("[upload] %s queue family %u, %s, %llu KB staging\n", dedicated ? "dedicated transfer" : "graphics", family,
+           timeline ? "timeline semaphores" : "fences", static_cast<unsigned long long>(stagingSize / 1024));
+}
+
+void UploadQueue::shutdown() {
+    if (!device) return;
+
+    GpuAllocator& allocator = engine->getAllocator();
+    auto release = [&](Batch& batch) {
+        for (auto& [buffer, memory] : batch.oversized) allocator.destroyBuffer(buffer, memory);
+        if (batch.fence) vkDestroyFence(device, batch.fence, nullptr);
+    };
+    release(open);
+    for (auto& batch : inFlight) release(batch);
+    for (auto& batch : spare) release(batch);
+    open = {};
+    openRecording = false;
+    inFlight.clear();
+    spare.clear();
+    acquires.clear();
+
+    // the pool takes every command buffer with it
+    if (commandPool) vkDestroyCommandPool(device, commandPool, nullptr);
+    if (timeline) vkDestroySemaphore(device, timeline, nullptr);
+    allocator.destroyBuffer(staging, stagingMemory);
+
+    commandPool = VK_NULL_HANDLE;
+    timeline = VK_NULL_HANDLE;
+    staging = VK_NULL_HANDLE;
+    stagingMemory = {};
+    device = VK_NULL_HANDLE;
+}
+
+uint64_t UploadQueue::uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+    if (size == 0) throw std::runtime_error("empty buffer upload");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [src, srcOffset] = stage(data, size);
+    VkCommandBuffer cmd = beginOpen();
+
+    VkBufferCopy region{ srcOffset, dstOffset, size };
+    vkCmdCopyBuffer(cmd, src, dst, 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dedicated ? 0 : BUFFER_READS;
+    barrier.srcQueueFamilyIndex = dedicated ? family : VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = dedicated ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = dst;
+    barrier.offset = dstOffset;
+    barrier.size = size;
+    open.buffers.push_back(barrier);
+    return open.value;
+}
+
+uint64_t UploadQueue::uploadImage(VkImage dst, VkExtent3D extent, const void* data, VkDeviceSize size) {
+    if (size == 0) throw std::runtime_error("empty image upload");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [src, srcOffset] = stage(data, size);
+    VkCommandBuffer cmd = beginOpen();
+
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = 0;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = dst;
+    toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = srcOffset;
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = extent;
+    vkCmdCopyBufferToImage(cmd, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // release and acquire both carry the same layout change, only one of them performs it
+    VkImageMemoryBarrier toRead = toTransfer;
+    toRead.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toRead.dstAccessMask = dedicated ? 0 : VK_ACCESS_SHADER_READ_BIT;
+    toRead.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toRead.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    toRead.srcQueueFamilyIndex = dedicated ? family : VK_QUEUE_FAMILY_IGNORED;
+    toRead.dstQueueFamilyIndex = dedicated ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+    open.images.push_back(toRead);
+    return open.value;
+}
+
+void UploadQueue::flush() {
+    if (!canFlushHere()) throw std::runtime_error("UploadQueue::flush off the main thread without a transfer queue");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    collect();
+    submitOpen();
+}
+
+uint64_t UploadQueue::recordAcquires(VkCommandBuffer cmd) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (acquires.empty()) return 0;
+
+    // isComplete() may have told a layer it could use something this frame, everything it saw finished is acquired
+    const uint64_t completed = queryCompleted();
+    std::vector<VkBufferMemoryBarrier> buffers;
+    std::vector<VkImageMemoryBarrier> images;
+    uint64_t value = 0;
+    while (!acquires.empty() && acquires.front().value <= completed) {
+        Acquire& acquire = acquires.front();
+        buffers.insert(buffers.end(), acquire.buffers.begin(), acquire.buffers.end());
+        images.insert(images.end(), acquire.images.begin(), acquire.images.end());
+        value = acquire.value;
+        acquires.pop_front();
+    }
+    if (value == 0) return 0;
+
+    // the frame's submit waits on `value` at ALL_COMMANDS, which chains into this barrier's first scope
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, CONSUMER_STAGES, 0,
+                         0, nullptr,
+                         static_cast<uint32_t>(buffers.size()), buffers.data(),
+                         static_cast<uint32_t>(images.size()), images.data());
+    return timeline ? value : 0;
+}
+
+bool UploadQueue::isComplete(uint64_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return value <= queryCompleted();
+}
+
+void UploadQueue::wait(uint64_t value) {
+    // still in the open batch, get it onto the queue or wait for the main thread to do so
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (value < nextValue) break;
+            if (!openRecording || value > nextValue) throw std::runtime_error("waiting on an upload that was never made");
+            if (canFlushHere()) {
+                submitOpen();
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (timeline) {
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timeline;
+        waitInfo.pValues = &value;
+        VK_CHECK(waitSemaphores(device, &waitInfo, UINT64_MAX));
+        return;
+    }
+
+    // batch fences get recycled by other threads, poll instead of holding on to one
+    while (!isComplete(value)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+VkCommandBuffer UploadQueue::beginOpen() {
+    if (openRecording) return open.cmd;
+
+    if (!spare.empty()) {
+        open = std::move(spare.back());
+        spare.pop_back();
+    } else {
+        open = {};
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        VK_CHECK(vkAllocateCommandBuffers(device, &allocInfo, &open.cmd));
+
+        if (!timeline) {
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            VK_CHECK(vkCreateFence(device, &fenceInfo, nullptr, &open.fence));
+        }
+    }
+    open.value = nextValue;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(open.cmd, &beginInfo));
+    openRecording = true;
+    return open.cmd;
+}
+
+/*
+ * copies `data` into the ring and returns where it landed
+ * an allocation never straddles the end, the rest of the ring is skipped instead
+ * no room even after retiring finished batches means a staging buffer of its own, uploads never wait for space
+ */
+std::pair<VkBuffer, VkDeviceSize> UploadQueue::stage(const void* data, VkDeviceSize size) {
+    const VkDeviceSize aligned = (size + copyAlignment - 1) / copyAlignment * copyAlignment;
+
+    if (aligned <= stagingSize) {
+        for (int attempt = 0; attempt < 2; attempt++) {
+            const VkDeviceSize position = head % stagingSize;
+            const VkDeviceSize skip = position + aligned > stagingSize ? stagingSize - position : 0;
+            if (head + skip + aligned - tail <= stagingSize) {
+                const VkDeviceSize offset = (head + skip) % stagingSize;
+                memcpy(static_cast<char*>(stagingMemory.mapped) + offset, data, static_cast<size_t>(size));
+                head += skip + aligned;
+                return { staging, offset };
+            }
+            collect();
+        }
+    }
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = size;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    GpuAllocation memory;
+    engine->getAllocator().createBuffer(bufInfo,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, memory);
+    memcpy(memory.mapped, data, static_cast<size_t>(size));
+
+    // owned by the batch the copy lands in, freed once that batch finished
+    beginOpen();
+    open.oversized.emplace_back(buffer, memory);
+    return { buffer, 0 };
+}
+
+void UploadQueue::submitOpen() {
+    if (!openRecording) return;
+
+    if (!open.buffers.empty() || !open.images.empty()) {
+        // dedicated: release to the graphics family, nothing waits here; otherwise straight to the consumers
+        const VkPipelineStageFlags dstStage =
+            dedicated ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) : CONSUMER_STAGES;
+        vkCmdPipelineBarrier(open.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0,
+                             0, nullptr,
+                             static_cast<uint32_t>(open.buffers.size()), open.buffers.data(),
+                             static_cast<uint32_t>(open.images.size()), open.images.data());
+    }
+    VK_CHECK(vkEndCommandBuffer(open.cmd));
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &open.value;
+
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &open.cmd;
+    if (timeline) {
+        si.pNext = &timelineInfo;
+        si.signalSemaphoreCount = 1;
+        si.pSignalSemaphores = &timeline;
+    }
+    VK_CHECK(vkQueueSubmit(queue, 1, &si, open.fence));
+
+    if (dedicated) {
+        // the acquire mirrors the release, the access it grants is what the graphics side reads
+        Acquire acquire;
+        acquire.value = open.value;
+        acquire.buffers = std::move(open.buffers);
+        acquire.images = std::move(open.images);
+        for (auto& barrier : acquire.buffers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = BUFFER_READS;
+        }
+        for (auto& barrier : acquire.images) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        }
+        acquires.push_back(std::move(acquire));
+    }
+    open.buffers.clear();
+    open.images.clear();
+
+    open.stagingEnd = head;
+    inFlight.push_back(std::move(open));
+    open = {};
+    openRecording = false;
+    nextValue++;
+}
+
+// retires every finished batch: ring space, oversized staging buffers, command buffer and fence back to the spares
+void UploadQueue::collect() {
+    const uint64_t completed = queryCompleted();
+    while (!inFlight.empty() && inFlight.front().value <= completed) {
+        Batch batch = std::move(inFlight.front());
+        inFlight.pop_front();
+
+        tail = batch.stagingEnd;
+        for (auto& [buffer, memory] : batch.oversized) engine->getAllocator().destroyBuffer(buffer, memory);
+        batch.oversized.clear();
+        if (batch.fence) VK_CHECK(vkResetFences(device, 1, &batch.fence));
+        VK_CHECK(vkResetCommandBuffer(batch.cmd, 0));
+        spare.push_back(std::move(batch));
+    }
+}
+
+uint64_t UploadQueue::queryCompleted() {
+    if (timeline) {
+        uint64_t value = 0;
+        VK_CHECK(getCounterValue(device, timeline, &value));
+        completedValue = std::max(completedValue, value);
+        return completedValue;
+    }
+
+    // batches finish in submission order on one queue
+    for (const Batch& batch : inFlight) {
+        if (batch.value <= completedValue) continue;
+        if (vkGetFenceStatus(device, batch.fence) != VK_SUCCESS) break;
+        completedValue = batch.value;
+    }
+    return completedValue;
+}
+
+// the graphics queue is only ever submitted to from the main thread
+bool UploadQueue::canFlushHere() const {
+    return dedicated || engine->getJobSystem().isMainThread();
+}
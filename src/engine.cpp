@@ -2,6 +2,8 @@
 
 #include <engine.h>
 #include <core/engine_object.h>
+#include <core/layer_component.h>
+#include <util/hash.h>
 #include <select_menu/select_menu.h>
 #include "plasma_ball.h"
 #include "screen_coordinates.h"
@@ -17,58 +19,122 @@
 #include <cstdio>
 #include <algorithm>
 #include <functional>
+#include <cstring>
 
 
-static std::function<void()> g_RenderFrameFn = nullptr;
+/*
+ * live resize: win32 and cocoa sit in SDL_PollEvent for as long as a window drag lasts,
+ * event watchers still run from inside that loop and may draw on SDL_EVENT_WINDOW_EXPOSED
+ */
+static std::function<void(const SDL_Event&)> g_WindowEventFn = nullptr;
 
 static bool SDLCALL WindowEventWatcher(void* userdata, SDL_Event* event) {
     if (event->type == SDL_EVENT_WINDOW_EXPOSED || 
         event->type == SDL_EVENT_WINDOW_RESIZED || 
-        event->type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED ||
-        event->type == SDL_EVENT_WINDOW_MOVED) 
+        event->type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED)
     {
-        if (g_RenderFrameFn) {
-            g_RenderFrameFn();
+        // watchers run on whichever thread pushed the event, frames are only recorded on the main one
+        if (g_WindowEventFn && SDL_IsMainThread()) {
+            g_WindowEventFn(*event);
         }
     }
     return false;
 }
 
-Engine::Engine() {
-    initSDL();
-    initWindow();
+Engine::Engine(const EngineConfig& cfg) : config(cfg) {
+    config.framesInFlight = std::max(1u, config.framesInFlight);
+
+    if (!config.headless) {
+        try {
+            initSDL();
+            initWindow();
+        } catch (const std::exception& e) {
+            fallbackToHeadless(e.what());
+        }
+    }
+    if (config.headless) {
+        viewport.initHeadless(static_cast<float>(config.width), static_cast<float>(config.height));
+    }
+
     initVulkan();
+    if (!config.headless) {
+        // first, the color format everything is built against comes from the surface
+        swapchain.init(this, surface);
+        colorFormat = swapchain.getFormat();
+        createSwapchain();
+    }
     createImGuiPool();
-    createImGuiRenderPass();
+    if (!dynamicRenderingSupported) createImGuiRenderPass();
+    openShaderPack();
+    // the one pool of cpu workers, pipeline prewarm and parallel recording run on it
+    jobSystem.init(config.jobWorkers, config.jobAffinity);
+    pipelineStore.init(this);
+    uniformRing.init(this, config.framesInFlight);
+    renderGraph.init(this, config.framesInFlight);
+    secondaryRecorder.init(this, config.framesInFlight, config.recordingThreads);
+    uploadQueue.init(this, config.uploadStagingSize);
     
-    createSwapchain();
-    createFramebuffers();
-    createCommandBuffers();
+    if (config.headless) {
+        createOffscreenTargets();
+    } else {
+        createFramebuffers();
+    }
+    createFrameContexts();
     
     initImGui();
+
+    if (config.hotReload && !config.headless) hotReload.start(this);
+    if (config.fixedStepSimulation) simulation.start(config.simulationRate);
 }
 
 Engine::~Engine() {
-    g_RenderFrameFn = nullptr;
+    g_WindowEventFn = nullptr;
     SDL_RemoveEventWatch(WindowEventWatcher, nullptr);
 
+    // stop compiling before anything the reload thread touches goes away
+    hotReload.stop();
+    simulation.stop();
+    // layers' jobs finish while the layers are still around, prewarm builds nobody is waiting for don't
+    pipelineStore.pausePrewarm();
+    jobSystem.shutdown();
+
     vkDeviceWaitIdle(device);
 
+    delete pending_app;
+    pending_app = nullptr;
+    delete current_app;
+    current_app = nullptr;
+
+    // everything is idle, no need to wait for the frames the remaining entries were retired against
+    deletionQueue.flush();
+
+    uploadQueue.shutdown();
+    secondaryRecorder.shutdown();
+    renderGraph.shutdown();
+    uniformRing.shutdown();
+    pipelineStore.shutdown();
+    pipelineCache.shutdown();
+
     ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplSDL3_Shutdown();
+    if (window) ImGui_ImplSDL3_Shutdown();
     ImGui::DestroyContext();
 
-    for (auto fb : framebuffers)
-        vkDestroyFramebuffer(device, fb, nullptr);
-    framebuffers.clear();
+    destroyFramebuffers();
+    swapchain.shutdown();
+    destroyOffscreenTargets();
 
-    vkFreeCommandBuffers(device, commandPool,
-                         static_cast<uint32_t>(commandBuffers.size()),
-                         commandBuffers.data());
+    for (auto& frame : frames) {
+        if (frame.inFlight) vkDestroyFence(device, frame.inFlight, nullptr);
+        if (frame.imageAvailable) vkDestroySemaphore(device, frame.imageAvailable, nullptr);
+        if (frame.timestamps) vkDestroyQueryPool(device, frame.timestamps, nullptr);
+        if (frame.commandBuffer) vkFreeCommandBuffers(device, commandPool, 1, &frame.commandBuffer);
+    }
+    frames.clear();
 
-    if (swapchain) vkDestroySwapchainKHR(device, swapchain, nullptr);
+    if (commandPool) vkDestroyCommandPool(device, commandPool, nullptr);
     if (imguiRenderPass) vkDestroyRenderPass(device, imguiRenderPass, nullptr);
     if (imguiPool) vkDestroyDescriptorPool(device, imguiPool, nullptr);
+    gpuAllocator.shutdown();
     if (device) vkDestroyDevice(device, nullptr);
     if (surface) vkDestroySurfaceKHR(instance, surface, nullptr);
     if (instance) vkDestroyInstance(instance, nullptr);
@@ -79,161 +145,320 @@ Engine::~Engine() {
 }
 
 void Engine::switchProject(EngineObject* new_app) {
-    if (current_app) delete current_app;
-    current_app = new_app;
+    // a second request in the same frame replaces the first, that one was never set up
+    if (switchPending && pending_app != new_app) delete pending_app;
+
+    pending_app = new_app;
+    switchPending = true;
+}
+
+void Engine::applyPendingSwitch() {
+    if (!switchPending) return;
+
+    EngineObject* next = pending_app;
+    pending_app = nullptr;
+    switchPending = false;
+
+    // neither steps nor jobs of the outgoing layers may still be running, the prewarm backlog can keep going after
+    simulation.setApp(nullptr);
+    pipelineStore.pausePrewarm();
+    jobSystem.waitIdle();
+    pipelineStore.resumePrewarm();
+    delete current_app;
+    current_app = next;
     if (current_app) current_app->onSetup();
+    simulation.setApp(current_app);
 }
 
-void Engine::run() {
+void Engine::run(EngineObject* initial_app) {
     // load the first EngineObject subclass to begin
-    switchProject(new SelectMenuObject(this));
+    switchProject(initial_app ? initial_app : new SelectMenuObject(this));
     // switchProject(new PlasmaBallObject(this));
     // switchProject(new ScreenCoordinatesObject(this));
 
+    quitRequested = false;
+    if (config.headless) runHeadless();
+    else runWindowed();
+}
+
+void Engine::runHeadless() {
+    uint64_t lastTime = SDL_GetPerformanceCounter();
+
+    // no compositor or vsync in the loop, frames go out as fast as the fences allow
+    for (uint64_t rendered = 0; !quitRequested; rendered++) {
+        if (config.frameLimit && rendered >= config.frameLimit) break;
+
+        const uint64_t now = SDL_GetPerformanceCounter();
+        const float deltaTime = static_cast<float>(now - lastTime) / static_cast<float>(SDL_GetPerformanceFrequency());
+        lastTime = now;
+
+        renderFrame(deltaTime);
+    }
+
+    vkDeviceWaitIdle(device);
+    printf("[engine] headless run finished after %llu frames\n", static_cast<unsigned long long>(frameCount));
+}
+
+void Engine::runWindowed() {
     uint64_t lastTime = SDL_GetPerformanceCounter();
+    bool drawing = false;
 
-    auto renderFrame = [&]() {
+    auto tickFrame = [&]() {
         const uint64_t now = SDL_GetPerformanceCounter();
         const float deltaTime = static_cast<float>(now - lastTime) / static_cast<float>(SDL_GetPerformanceFrequency());
         lastTime = now;
 
-        if (swapchainExtent.width == 0 || swapchainExtent.height == 0) {
+        drawing = true;
+        renderFrame(deltaTime);
+        drawing = false;
+    };
+
+    // resize events only flag the swapchain, renderFrame() recreates it once for however many came in
+    g_WindowEventFn = [&](const SDL_Event& event) {
+        if (event.window.windowID != SDL_GetWindowID(window)) return;
+
+        if (event.type == SDL_EVENT_WINDOW_EXPOSED) {
+            if (!drawing) tickFrame();
+        } else {
+            swapchainDirty = true;
+        }
+    };
+    SDL_AddEventWatch(WindowEventWatcher, nullptr);
+
+    while (!quitRequested) {
+        if (config.frameLimit && frameCount >= config.frameLimit) break;
+
+        const uint64_t framesBefore = frameCount;
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            ImGui_ImplSDL3_ProcessEvent(&event);
+            if (event.type == SDL_EVENT_QUIT)
+                quitRequested = true;
+
+            // normally flagged by the watcher already, unless SDL couldn't call it on the main thread
+            if ((event.type == SDL_EVENT_WINDOW_RESIZED || event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED) &&
+                event.window.windowID == SDL_GetWindowID(window))
+                swapchainDirty = true;
+        }
+
+        // the watcher already drew while the events were pumped, don't draw the same moment twice
+        if (frameCount != framesBefore) continue;
+
+        tickFrame();
+
+        // minimized, nothing to present to until the window comes back
+        if (swapchain.getExtent().width == 0 || swapchain.getExtent().height == 0) {
+            SDL_Delay(100); 
+        }
+    }
+
+    SDL_RemoveEventWatch(WindowEventWatcher, nullptr);
+    g_WindowEventFn = nullptr;
+}
+
+void Engine::renderFrame(float deltaTime) {
+    if (swapchainDirty && !config.headless) recreateSwapchain();
+
+    const VkExtent2D extent = getRenderExtent();
+    if (extent.width == 0 || extent.height == 0) {
+        return;
+    }
+
+    FrameContext& frame = frames[currentFrame];
+
+    // only blocks when the cpu is a full framesInFlight ahead of the gpu
+    vkWaitForFences(device, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+    collectGpuTimings(frame);
+
+    // one queue, so every frame submitted before this slot's last one is done as well
+    completedFrameCount = std::max(completedFrameCount, frame.submittedFrame);
+    deletionQueue.collect(completedFrameCount);
+    uniformRing.beginFrame(currentFrame);
+    secondaryRecorder.beginFrame(currentFrame);
+    pipelineStore.applyReloads();
+
+    uint32_t imageIndex = 0;
+    VkImage targetImage = VK_NULL_HANDLE;
+    VkImageView targetView = VK_NULL_HANDLE;
+    VkFramebuffer targetFramebuffer = VK_NULL_HANDLE;
+
+    if (config.headless) {
+        const OffscreenTarget& target = offscreenTargets[currentFrame];
+        targetImage = target.image;
+        targetView = target.view;
+        targetFramebuffer = target.framebuffer;
+    } else {
+        VkResult acquireResult = swapchain.acquire(frame.imageAvailable, imageIndex);
+        if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreateSwapchain();
             return;
         }
+        if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
+            throw std::runtime_error("failed to acquire swapchain image");
+        // still presentable, replaced before the next frame
+        if (acquireResult == VK_SUBOPTIMAL_KHR) swapchainDirty = true;
+
+        targetImage = swapchain.getImage(imageIndex);
+        targetView = swapchain.getView(imageIndex);
+        if (!framebuffers.empty()) targetFramebuffer = framebuffers[imageIndex];
+    }
 
-        // setup/render imgui
-        ImGui_ImplVulkan_NewFrame();
+    // reset only once we know this frame will actually submit, otherwise the next wait deadlocks
+    vkResetFences(device, 1, &frame.inFlight);
+
+    applyPendingSwitch();
+
+    // setup/render imgui
+    ImGui_ImplVulkan_NewFrame();
+    if (config.headless) {
+        // no platform backend without a window, feed imgui the frame size and clock by hand
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(static_cast<float>(extent.width), static_cast<float>(extent.height));
+        io.DeltaTime = std::max(deltaTime, 1e-6f);
+    } else {
         ImGui_ImplSDL3_NewFrame();
-        ImGui::NewFrame();
+    }
+    ImGui::NewFrame();
 
-        // tick EngineObject on every iteration
-        if (current_app) {
-            current_app->update(deltaTime);
-        }
-        ImGui::Render();
+    // main-thread jobs released since the last frame, before layers look at their results
+    jobSystem.runMainThreadJobs();
 
-        // vulkan bullshit
-        VkCommandBuffer cmd = commandBuffers[currentFrame];
-        
-        vkResetCommandBuffer(cmd, 0);
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        vkBeginCommandBuffer(cmd, &beginInfo);
+    // tick EngineObject on every iteration
+    if (current_app) {
+        current_app->update(deltaTime);
+    }
+    ImGui::Render();
 
-        VkClearValue clearColor = {{{0.1f, 0.1f, 0.1f, 1.0f}}};
-        VkRenderPassBeginInfo rpInfo{};
-        rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        rpInfo.renderPass = imguiRenderPass;
-        rpInfo.framebuffer = framebuffers[currentFrame];
-        rpInfo.renderArea.extent = swapchainExtent;
-        rpInfo.clearValueCount = 1;
-        rpInfo.pClearValues = &clearColor;
+    // layers declare their offscreen passes, the swapchain / offscreen target pass always comes last
+    renderGraph.beginFrame(currentFrame, extent);
+    if (current_app) {
+        current_app->buildGraph(renderGraph);
+    }
+    renderGraph.addBackbufferPass([this, targetImage, targetView, targetFramebuffer, extent](const RenderGraph::PassContext& ctx) {
+        // once a layer records in parallel or replays a recording the whole pass goes through secondaries,
+        // see SecondaryRecorder
+        if (current_app && (current_app->hasParallelLayers() || current_app->hasCachedLayers())) {
+            beginBackbuffer(ctx.cmd, targetImage, targetView, targetFramebuffer, extent, true);
+            recordBackbufferSecondaries(ctx.cmd, targetFramebuffer, extent);
+            endBackbuffer(ctx.cmd, targetImage);
+            return;
+        }
+
+        beginBackbuffer(ctx.cmd, targetImage, targetView, targetFramebuffer, extent);
 
-        vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
-        
         if (current_app) {
             /*
              * needs to be called before ImGui::Render()
              * cannot render before calling ImGui::NewFrame() and rendering all the layers inside EngineObject
              */
-            current_app->render(cmd); // calls internal render hook (which does nothing lol)
+            current_app->render(ctx.cmd); // calls internal render hook (which does nothing lol)
         }
 
         /*
          * this line here renders imgui
          */
-        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd);
-        
-        vkCmdEndRenderPass(cmd);
-        vkEndCommandBuffer(cmd);
-
-        VkSubmitInfo si{};
-        si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        si.commandBufferCount = 1;
-        si.pCommandBuffers = &cmd;
-        
-        vkQueueSubmit(graphicsQueue, 1, &si, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue);
-
-        VkPresentInfoKHR pi{};
-        pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        pi.swapchainCount = 1;
-        pi.pSwapchains = &swapchain;
-
-
-        uint32_t imageIndex = static_cast<uint32_t>(currentFrame);
-        pi.pImageIndices = &imageIndex;
-
-        VkResult presentResult = vkQueuePresentKHR(graphicsQueue, &pi);
-        
-        // handle swapchain invalidation during present - some drivers might signal it here
-        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
-            // usually handled within the event loop
-            // currently we rely on the SDL event to trigger the recreation logic above
-        }
+        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), ctx.cmd);
 
-        currentFrame = (currentFrame + 1) % framebuffers.size();
-    };
+        endBackbuffer(ctx.cmd, targetImage);
+    });
+    renderGraph.compile();
 
-    // g_RenderFrameFn = renderFrame;
-    // SDL_AddEventWatch(WindowEventWatcher, nullptr);
+    // vulkan bullshit
+    VkCommandBuffer cmd = frame.commandBuffer;
+    
+    vkResetCommandBuffer(cmd, 0);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &beginInfo);
 
-    bool running = true;
-    while (running) {
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            ImGui_ImplSDL3_ProcessEvent(&event);
-            if (event.type == SDL_EVENT_QUIT)
-                running = false;
-            
-            // handle window resize
-            if (event.type == SDL_EVENT_WINDOW_RESIZED || event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED) {
-                if (event.window.windowID == SDL_GetWindowID(window)) {
-                    int w = 0, h = 0;
-                    SDL_GetWindowSize(window, &w, &h);
-                    
-                    // only resize if the window has valid dimensions - not minimized
-                    if (w > 0 && h > 0) {
-                        viewport.onResize();
-                        vkDeviceWaitIdle(device);
-
-                        for (auto fb : framebuffers) 
-                            vkDestroyFramebuffer(device, fb, nullptr);
-                        framebuffers.clear();
-
-                        vkFreeCommandBuffers(device, commandPool, 
-                                           static_cast<uint32_t>(commandBuffers.size()), 
-                                           commandBuffers.data());
-                        commandBuffers.clear();
-
-                        if (swapchain) {
-                            vkDestroySwapchainKHR(device, swapchain, nullptr);
-                            swapchain = VK_NULL_HANDLE;
-                        }
-
-                        createSwapchain();
-                        createFramebuffers();
-                        createCommandBuffers();
-                        
-                        renderFrame();
-                    }
-                }
-            }
-        }
+    // copies staged since the last frame go out now, whatever finished meanwhile is handed to this frame
+    uploadQueue.flush();
+    const uint64_t uploadWait = uploadQueue.recordAcquires(cmd);
 
-        if (swapchainExtent.width == 0 || swapchainExtent.height == 0) {
-            SDL_Delay(100); 
-            continue;
-        }
+    if (frame.timestamps) {
+        vkCmdResetQueryPool(cmd, frame.timestamps, 0, 2);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestamps, 0);
+    }
+
+    renderGraph.execute(cmd);
+
+    if (frame.timestamps) {
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestamps, 1);
+    }
+    vkEndCommandBuffer(cmd);
+
+    VkSemaphore signal = config.headless ? VK_NULL_HANDLE : swapchain.getRenderFinished(imageIndex);
 
-        renderFrame();
+    VkSemaphore waits[2];
+    VkPipelineStageFlags waitStages[2];
+    uint64_t waitValues[2] = { 0, 0 }; // binary semaphores ignore theirs
+    uint32_t waitCount = 0;
+    if (!config.headless) {
+        waits[waitCount] = frame.imageAvailable;
+        waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    // already signalled when recordAcquires() returned it, orders the ownership acquires and never stalls
+    if (uploadWait) {
+        waits[waitCount] = uploadQueue.getTimeline();
+        waitValues[waitCount] = uploadWait;
+        waitStages[waitCount++] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
     }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.pNext = uploadWait ? &timelineInfo : nullptr;
+    si.waitSemaphoreCount = waitCount;
+    si.pWaitSemaphores = waits;
+    si.pWaitDstStageMask = waitStages;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &cmd;
+    if (!config.headless) {
+        si.signalSemaphoreCount = 1;
+        si.pSignalSemaphores = &signal;
+    }
+    
+    if (vkQueueSubmit(graphicsQueue, 1, &si, frame.inFlight) != VK_SUCCESS)
+        throw std::runtime_error("failed to submit frame");
+
+    lastSubmittedFrame = currentFrame;
+    frameCount++;
+    frame.submittedFrame = frameCount;
+
+    pipelineCache.tick(static_cast<double>(SDL_GetTicks()) / 1000.0, jobSystem);
+
+    if (config.headless) {
+        currentFrame = (currentFrame + 1) % config.framesInFlight;
+        return;
+    }
+
+    VkResult presentResult = swapchain.present(graphicsQueue, imageIndex);
+    
+    // some platforms never send a resize event and only report it here
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+        swapchainDirty = true;
+    } else if (presentResult != VK_SUCCESS) {
+        throw std::runtime_error("failed to present swapchain image");
+    }
+
+    currentFrame = (currentFrame + 1) % config.framesInFlight;
 }
 
 void Engine::initImGui() {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
-    ImGui_ImplSDL3_InitForVulkan(window);
+    if (window) {
+        ImGui_ImplSDL3_InitForVulkan(window);
+    } else {
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = ImVec2(static_cast<float>(offscreenExtent.width), static_cast<float>(offscreenExtent.height));
+    }
 
     ImGui_ImplVulkan_InitInfo info{};
     info.Instance = instance;
@@ -242,8 +467,10 @@ void Engine::initImGui() {
     info.QueueFamily = graphicsQueueFamily; // required by the version of imgui in use
     info.Queue = graphicsQueue;
     info.DescriptorPool = imguiPool;
-    info.MinImageCount = 2;
-    info.ImageCount = 2;
+    info.MinImageCount = config.headless ? 2 : swapchain.getMinImageCount();
+    info.ImageCount = config.headless
+        ? std::max(2u, config.framesInFlight)
+        : swapchain.getImageCount();
     
     /*
      * imgui now uses ImGui_ImplVulkan_PipelineInfo instead of RenderPassData
@@ -256,6 +483,16 @@ void Engine::initImGui() {
     info.PipelineInfoMain.RenderPass = imguiRenderPass;
     info.PipelineInfoMain.Subpass = 0;
 
+#ifdef IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING
+    // no render pass to be compatible with, only the format imgui draws into
+    if (dynamicRenderingSupported) {
+        info.UseDynamicRendering = true;
+        info.PipelineInfoMain.PipelineRenderingCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+        info.PipelineInfoMain.PipelineRenderingCreateInfo.colorAttachmentCount = 1;
+        info.PipelineInfoMain.PipelineRenderingCreateInfo.pColorAttachmentFormats = &colorFormat;
+    }
+#endif
+
     ImGui_ImplVulkan_Init(&info);
 
 }
@@ -275,60 +512,166 @@ void Engine::initWindow() {
     viewport.init(window);
 }
 
+void Engine::fallbackToHeadless(const char* reason) {
+    printf("[engine] %s, falling back to headless rendering\n", reason);
+
+    if (window) {
+        SDL_DestroyWindow(window);
+        window = nullptr;
+    }
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    viewport = Viewport();
+    viewport.initHeadless(static_cast<float>(config.width), static_cast<float>(config.height));
+    config.headless = true;
+}
+
+void Engine::openShaderPack() {
+    if (config.shaderPackPath.empty()) return;
+    if (shaderPack.open(config.shaderPackPath)) return;
+
+    // the build drops the pack next to the executable, which isn't always the working directory
+    if (const char* base = SDL_GetBasePath()) {
+        if (shaderPack.open(std::string(base) + config.shaderPackPath)) return;
+    }
+    printf("[engine] no shader pack found, loading loose spir-v from spirv/opt/\n");
+}
+
 void Engine::initVulkan() {
-    uint32_t extCount = 0;
-    const char* const* extNames = SDL_Vulkan_GetInstanceExtensions(&extCount);
+    std::vector<const char*> instanceExtensions;
+
+    if (!config.headless) {
+        uint32_t extCount = 0;
+        const char* const* extNames = SDL_Vulkan_GetInstanceExtensions(&extCount);
+
+        uint32_t availableCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, nullptr);
+        std::vector<VkExtensionProperties> available(availableCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, available.data());
+
+        // a software icd like lavapipe on a box without a display may not expose the surface extensions at all
+        bool supported = extNames != nullptr && extCount > 0;
+        for (uint32_t i = 0; supported && i < extCount; i++) {
+            supported = std::any_of(available.begin(), available.end(), [&](const VkExtensionProperties& p) {
+                return strcmp(p.extensionName, extNames[i]) == 0;
+            });
+        }
+
+        if (supported) instanceExtensions.assign(extNames, extNames + extCount);
+        else fallbackToHeadless("surface extensions unavailable");
+    }
+
+    // 1.1 for subgroup operations in compute layers, a 1.0 loader doesn't know vkEnumerateInstanceVersion and rejects anything newer
+    uint32_t instanceVersion = VK_API_VERSION_1_0;
+    auto enumerateVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+        vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+    if (enumerateVersion) enumerateVersion(&instanceVersion);
+
+    VkApplicationInfo app{};
+    app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app.pApplicationName = "vk_shader_engine";
+    app.pEngineName = "vk_shader_engine";
+    app.apiVersion = instanceVersion >= VK_API_VERSION_1_1 ? VK_API_VERSION_1_1 : VK_API_VERSION_1_0;
 
     VkInstanceCreateInfo ci{};
     ci.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    ci.enabledExtensionCount = extCount;
-    ci.ppEnabledExtensionNames = extNames;
+    ci.pApplicationInfo = &app;
+    ci.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+    ci.ppEnabledExtensionNames = instanceExtensions.data();
 
     if (vkCreateInstance(&ci, nullptr, &instance) != VK_SUCCESS)
         throw std::runtime_error("instance creation failed");
 
-    if (!SDL_Vulkan_CreateSurface(window, instance, nullptr, &surface))
-        throw std::runtime_error("surface creation failed");
+    if (!config.headless && !SDL_Vulkan_CreateSurface(window, instance, nullptr, &surface)) {
+        surface = VK_NULL_HANDLE;
+        fallbackToHeadless("surface creation failed");
+    }
 
-    uint32_t gpuCount = 0;
-    vkEnumeratePhysicalDevices(instance, &gpuCount, nullptr);
-    if (gpuCount == 0) throw std::runtime_error("no GPUs found");
+    pickPhysicalDevice();
+    pickTransferFamily();
+    querySubgroupProperties(app.apiVersion);
 
-    std::vector<VkPhysicalDevice> gpus(gpuCount);
-    vkEnumeratePhysicalDevices(instance, &gpuCount, gpus.data());
-    physicalDevice = gpus[0];
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo qci[2]{};
+    for (auto& info : qci) {
+        info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        info.queueCount = 1;
+        info.pQueuePriorities = &priority;
+    }
+    qci[0].queueFamilyIndex = graphicsQueueFamily;
+    qci[1].queueFamilyIndex = transferQueueFamily;
+    const uint32_t queueCreateCount = transferQueueFamily != graphicsQueueFamily ? 2 : 1;
+
+    std::vector<const char*> deviceExtensions;
+    if (!config.headless) deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gplFeatures{};
+    gplFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    pipelineLibrariesSupported = config.pipelineLibraries && queryPipelineLibrarySupport();
+    if (pipelineLibrariesSupported) {
+        deviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        gplFeatures.graphicsPipelineLibrary = VK_TRUE;
+    }
 
-    uint32_t qCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &qCount, nullptr);
-    std::vector<VkQueueFamilyProperties> qp(qCount);
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &qCount, qp.data());
+    // core in 1.3, an extension (with what it depends on) below that
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+    dynamicRenderingSupported = config.dynamicRendering && queryDynamicRenderingSupport();
+    if (dynamicRenderingSupported) {
+        deviceExtensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+    }
 
-    for (uint32_t i = 0; i < qCount; i++) {
-        if (qp[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-            graphicsQueueFamily = i;
-            break;
-        }
+    // no features to enable, the pipeline cache's hit / miss stats come from it
+    const bool creationFeedbackSupported = queryCreationFeedbackSupport();
+    if (creationFeedbackSupported) deviceExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+    // core in 1.2, UploadQueue signals its batches with it
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineSemaphoresSupported = queryTimelineSemaphoreSupport();
+    if (timelineSemaphoresSupported) {
+        deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        timelineFeatures.timelineSemaphore = VK_TRUE;
     }
 
-    float priority = 1.0f;
-    VkDeviceQueueCreateInfo qci{};
-    qci.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    qci.queueFamilyIndex = graphicsQueueFamily;
-    qci.queueCount = 1;
-    qci.pQueuePriorities = &priority;
+    // every enabled feature struct, chained in front of the previous one
+    void* features = nullptr;
+    if (pipelineLibrariesSupported) {
+        gplFeatures.pNext = features;
+        features = &gplFeatures;
+    }
+    if (dynamicRenderingSupported) {
+        dynamicRenderingFeatures.pNext = features;
+        features = &dynamicRenderingFeatures;
+    }
+    if (timelineSemaphoresSupported) {
+        timelineFeatures.pNext = features;
+        features = &timelineFeatures;
+    }
 
-    const char* deviceExtensions[] = { "VK_KHR_swapchain" };
     VkDeviceCreateInfo dci{};
     dci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    dci.queueCreateInfoCount = 1;
-    dci.pQueueCreateInfos = &qci;
-    dci.enabledExtensionCount = 1;
-    dci.ppEnabledExtensionNames = deviceExtensions;
+    dci.pNext = features;
+    dci.queueCreateInfoCount = queueCreateCount;
+    dci.pQueueCreateInfos = qci;
+    dci.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    dci.ppEnabledExtensionNames = deviceExtensions.data();
 
     if (vkCreateDevice(physicalDevice, &dci, nullptr, &device) != VK_SUCCESS)
         throw std::runtime_error("device creation failed");
 
     vkGetDeviceQueue(device, graphicsQueueFamily, 0, &graphicsQueue);
+    vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+
+    if (dynamicRenderingSupported) {
+        cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+        cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+        dynamicRenderingSupported = cmdBeginRendering && cmdEndRendering;
+    }
+    gpuAllocator.init(physicalDevice, device);
 
     VkCommandPoolCreateInfo cpi{};
     cpi.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -336,6 +679,202 @@ void Engine::initVulkan() {
     cpi.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     if (vkCreateCommandPool(device, &cpi, nullptr, &commandPool) != VK_SUCCESS)
         throw std::runtime_error("command pool creation failed");
+
+    // windowed, the swapchain picks it from what the surface supports
+    if (config.headless) colorFormat = config.offscreenFormat;
+
+    pipelineCache.init(device, physicalDevice, config.pipelineCachePath, creationFeedbackSupported);
+}
+
+/*
+ * prefers real gpus but accepts cpu implementations (lavapipe, swiftshader) so headless boxes still run
+ * windowed mode additionally needs present support and VK_KHR_swapchain
+ */
+void Engine::pickPhysicalDevice() {
+    uint32_t gpuCount = 0;
+    vkEnumeratePhysicalDevices(instance, &gpuCount, nullptr);
+    if (gpuCount == 0) throw std::runtime_error("no GPUs found");
+
+    std::vector<VkPhysicalDevice> gpus(gpuCount);
+    vkEnumeratePhysicalDevices(instance, &gpuCount, gpus.data());
+
+    auto typeScore = [](VkPhysicalDeviceType type) {
+        switch (type) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return 4;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 3;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return 2;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU: return 1;
+            default: return 0;
+        }
+    };
+
+    int bestScore = -1;
+    for (VkPhysicalDevice gpu : gpus) {
+        uint32_t qCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &qCount, nullptr);
+        std::vector<VkQueueFamilyProperties> qp(qCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &qCount, qp.data());
+
+        int family = -1;
+        for (uint32_t i = 0; i < qCount; i++) {
+            if (!(qp[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) continue;
+
+            if (!config.headless) {
+                VkBool32 present = VK_FALSE;
+                vkGetPhysicalDeviceSurfaceSupportKHR(gpu, i, surface, &present);
+                if (!present) continue;
+            }
+            family = static_cast<int>(i);
+            break;
+        }
+        if (family < 0) continue;
+
+        if (!config.headless) {
+            uint32_t extCount = 0;
+            vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extCount, nullptr);
+            std::vector<VkExtensionProperties> exts(extCount);
+            vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extCount, exts.data());
+            bool hasSwapchain = std::any_of(exts.begin(), exts.end(), [](const VkExtensionProperties& p) {
+                return strcmp(p.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0;
+            });
+            if (!hasSwapchain) continue;
+        }
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(gpu, &props);
+        int score = typeScore(props.deviceType);
+        if (score > bestScore) {
+            bestScore = score;
+            physicalDevice = gpu;
+            graphicsQueueFamily = static_cast<uint32_t>(family);
+        }
+    }
+
+    if (bestScore < 0) throw std::runtime_error("no suitable GPU found");
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    printf("[engine] using device: %s%s\n", props.deviceName, config.headless ? " (headless)" : "");
+}
+
+/*
+ * a family that can copy without being the one that draws, so uploads never queue up behind a frame
+ * transfer-only (dma engines) first, then any other non-graphics family, the graphics family when there is neither
+ * or EngineConfig::transferQueue is off
+ */
+void Engine::pickTransferFamily() {
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qp(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &qCount, qp.data());
+
+    transferQueueFamily = graphicsQueueFamily;
+    if (!config.transferQueue) return;
+
+    int bestScore = 0;
+    for (uint32_t i = 0; i < qCount; i++) {
+        const VkQueueFlags flags = qp[i].queueFlags;
+        // graphics and compute queues implicitly support transfers
+        if (!(flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT))) continue;
+        if (flags & VK_QUEUE_GRAPHICS_BIT) continue;
+
+        int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+        if (score > bestScore) {
+            bestScore = score;
+            transferQueueFamily = i;
+        }
+    }
+}
+
+// left zeroed (no supported stages) on 1.0, where subgroup operations don't exist
+void Engine::querySubgroupProperties(uint32_t instanceVersion) {
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    apiVersion = std::min(instanceVersion, props.apiVersion);
+    subgroupProperties = {};
+    subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+    if (apiVersion < VK_API_VERSION_1_1) return;
+
+    VkPhysicalDeviceProperties2 props2{};
+    props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props2.pNext = &subgroupProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &props2);
+    subgroupProperties.pNext = nullptr;
+
+    printf("[engine] vulkan %u.%u, subgroup size %u\n", VK_API_VERSION_MAJOR(apiVersion), VK_API_VERSION_MINOR(apiVersion),
+           subgroupProperties.subgroupSize);
+}
+
+static bool hasDeviceExtensions(VkPhysicalDevice gpu, std::initializer_list<const char*> names) {
+    uint32_t extCount = 0;
+    vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extCount, nullptr);
+    std::vector<VkExtensionProperties> exts(extCount);
+    vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extCount, exts.data());
+    return std::all_of(names.begin(), names.end(), [&](const char* name) {
+        return std::any_of(exts.begin(), exts.end(), [&](const VkExtensionProperties& p) { return strcmp(p.extensionName, name) == 0; });
+    });
+}
+
+// VK_EXT_graphics_pipeline_library, the feature query needs vulkan 1.1
+bool Engine::queryPipelineLibrarySupport() {
+    if (apiVersion < VK_API_VERSION_1_1) return false;
+    if (!hasDeviceExtensions(physicalDevice, { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME }))
+        return false;
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gpl{};
+    gpl.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &gpl;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    printf("[engine] graphics pipeline library %s\n", gpl.graphicsPipelineLibrary ? "enabled" : "unsupported");
+    return gpl.graphicsPipelineLibrary == VK_TRUE;
+}
+
+// VK_KHR_dynamic_rendering, same 1.1 requirement; imgui has to be built with its dynamic rendering path too
+bool Engine::queryDynamicRenderingSupport() {
+#ifndef IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING
+    return false;
+#else
+    if (apiVersion < VK_API_VERSION_1_1) return false;
+    if (!hasDeviceExtensions(physicalDevice, { VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME, VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+                                               VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME }))
+        return false;
+
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering{};
+    dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamicRendering;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    printf("[engine] dynamic rendering %s\n", dynamicRendering.dynamicRendering ? "enabled" : "unsupported");
+    return dynamicRendering.dynamicRendering == VK_TRUE;
+#endif
+}
+
+// VK_EXT_pipeline_creation_feedback, an extension with nothing to query beyond its presence
+bool Engine::queryCreationFeedbackSupport() {
+    const bool supported = hasDeviceExtensions(physicalDevice, { VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME });
+    printf("[engine] pipeline creation feedback %s\n", supported ? "enabled" : "unsupported");
+    return supported;
+}
+
+// VK_KHR_timeline_semaphore, same 1.1 requirement
+bool Engine::queryTimelineSemaphoreSupport() {
+    if (apiVersion < VK_API_VERSION_1_1) return false;
+    if (!hasDeviceExtensions(physicalDevice, { VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME })) return false;
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphore{};
+    timelineSemaphore.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &timelineSemaphore;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    printf("[engine] timeline semaphores %s\n", timelineSemaphore.timelineSemaphore ? "enabled" : "unsupported");
+    return timelineSemaphore.timelineSemaphore == VK_TRUE;
 }
 
 void Engine::createImGuiPool() {
@@ -354,14 +893,15 @@ void Engine::createImGuiPool() {
 
 void Engine::createImGuiRenderPass() {
     VkAttachmentDescription color{};
-    color.format = VK_FORMAT_B8G8R8A8_UNORM;
+    color.format = colorFormat;
     color.samples = VK_SAMPLE_COUNT_1_BIT;
     color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // offscreen frames end up ready for readback instead of presentation
+    color.finalLayout = config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference ref{};
     ref.attachment = 0;
@@ -393,86 +933,361 @@ void Engine::createImGuiRenderPass() {
         throw std::runtime_error("render pass creation failed");
 }
 
-void Engine::createSwapchain() {
-    VkSurfaceCapabilitiesKHR caps;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps);
-    swapchainExtent = caps.currentExtent;
+bool Engine::createSwapchain() {
+    int w = 0, h = 0;
+    SDL_GetWindowSizeInPixels(window, &w, &h);
+    return swapchain.create({ static_cast<uint32_t>(std::max(w, 0)), static_cast<uint32_t>(std::max(h, 0)) });
+}
+
+// render pass path only, dynamic rendering draws into the swapchain's views directly
+void Engine::createFramebuffers() {
+    if (dynamicRenderingSupported) return;
 
-    uint32_t formatCount = 0;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
-    std::vector<VkSurfaceFormatKHR> formats(formatCount);
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, formats.data());
+    framebuffers.resize(swapchain.getImageCount());
+    for (uint32_t i = 0; i < swapchain.getImageCount(); i++) {
+        VkImageView view = swapchain.getView(i);
 
-    VkSurfaceFormatKHR chosenFormat = formats[0];
-    for (auto &f : formats) {
-        if (f.format == VK_FORMAT_B8G8R8A8_UNORM && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-            chosenFormat = f;
-            break;
+        VkFramebufferCreateInfo fbInfo{};
+        fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        fbInfo.renderPass = imguiRenderPass;
+        fbInfo.attachmentCount = 1;
+        fbInfo.pAttachments = &view;
+        fbInfo.width = swapchain.getExtent().width;
+        fbInfo.height = swapchain.getExtent().height;
+        fbInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device, &fbInfo, nullptr, &framebuffers[i]) != VK_SUCCESS)
+            throw std::runtime_error("framebuffer creation failed");
+    }
+}
+
+void Engine::destroyFramebuffers() {
+    for (auto fb : framebuffers)
+        vkDestroyFramebuffer(device, fb, nullptr);
+    framebuffers.clear();
+}
+
+void Engine::createFrameContexts() {
+    frames.resize(config.framesInFlight);
+
+    std::vector<VkCommandBuffer> buffers(frames.size());
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(buffers.size());
+    if (vkAllocateCommandBuffers(device, &allocInfo, buffers.data()) != VK_SUCCESS)
+        throw std::runtime_error("command buffer allocation failed");
+
+    VkSemaphoreCreateInfo semInfo{};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    // created signaled so the very first wait on each frame returns immediately
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i].commandBuffer = buffers[i];
+        if (vkCreateSemaphore(device, &semInfo, nullptr, &frames[i].imageAvailable) != VK_SUCCESS ||
+            vkCreateFence(device, &fenceInfo, nullptr, &frames[i].inFlight) != VK_SUCCESS)
+            throw std::runtime_error("frame sync object creation failed");
+    }
+
+    // timestamps are optional, a queue family with zero valid bits simply reports no gpu timings
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qp(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &qCount, qp.data());
+
+    const uint32_t validBits = qp[graphicsQueueFamily].timestampValidBits;
+    timestampsSupported = validBits > 0 && props.limits.timestampPeriod > 0.0f;
+    if (!timestampsSupported) return;
+
+    timestampPeriodNs = props.limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    VkQueryPoolCreateInfo qpi{};
+    qpi.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    qpi.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    qpi.queryCount = 2;
+    for (auto& frame : frames) {
+        if (vkCreateQueryPool(device, &qpi, nullptr, &frame.timestamps) != VK_SUCCESS)
+            throw std::runtime_error("timestamp query pool creation failed");
+    }
+}
+
+void Engine::collectGpuTimings(FrameContext& frame) {
+    if (!frame.timestamps || frame.submittedFrame == 0 || frame.submittedFrame <= gpuTimedFrame) return;
+
+    // the fence for this slot has been waited on, so the results are already there
+    uint64_t ticks[2] = {};
+    VkResult result = vkGetQueryPoolResults(device, frame.timestamps, 0, 2, sizeof(ticks), ticks,
+                                            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) return;
+
+    const uint64_t elapsed = ((ticks[1] & timestampMask) - (ticks[0] & timestampMask)) & timestampMask;
+    gpuFrameTimeMs = static_cast<double>(elapsed) * timestampPeriodNs * 1e-6;
+    gpuTimedFrame = frame.submittedFrame;
+}
+
+/*
+ * only what depends on the window size is rebuilt: the swapchain, its views and (render pass path) the framebuffers
+ * command buffers, frame sync objects and pipelines stay as they are
+ * nothing waits for the device, the old objects are retired against the frames that may still use them
+ */
+void Engine::recreateSwapchain() {
+    viewport.onResize();
+
+    if (!framebuffers.empty()) {
+        retire([device = device, old = std::move(framebuffers)]() {
+            for (auto fb : old) vkDestroyFramebuffer(device, fb, nullptr);
+        });
+        framebuffers.clear();
+    }
+
+    // stays dirty while minimized, the next frame tries again
+    swapchainDirty = !createSwapchain();
+    createFramebuffers();
+
+    // a no-op unless the count changed, imgui waits for idle itself then
+    ImGui_ImplVulkan_SetMinImageCount(swapchain.getMinImageCount());
+}
+
+void Engine::beginBackbuffer(VkCommandBuffer cmd, VkImage image, VkImageView view, VkFramebuffer framebuffer, VkExtent2D extent,
+                             bool secondaries) {
+    VkClearValue clearColor = {{{0.1f, 0.1f, 0.1f, 1.0f}}};
+
+    if (!dynamicRenderingSupported) {
+        VkRenderPassBeginInfo rpInfo{};
+        rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        rpInfo.renderPass = imguiRenderPass;
+        rpInfo.framebuffer = framebuffer;
+        rpInfo.renderArea.extent = extent;
+        rpInfo.clearValueCount = 1;
+        rpInfo.pClearValues = &clearColor;
+
+        vkCmdBeginRenderPass(cmd, &rpInfo, secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+        return;
+    }
+
+    // what the render pass did on its own: last frame's contents are cleared anyway, so start from UNDEFINED
+    // the acquire semaphore is waited on at color attachment output, which this barrier chains onto
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkRenderingAttachmentInfo color{};
+    color.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    color.imageView = view;
+    color.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color.clearValue = clearColor;
+
+    VkRenderingInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    info.flags = secondaries ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+    info.renderArea.extent = extent;
+    info.layerCount = 1;
+    info.colorAttachmentCount = 1;
+    info.pColorAttachments = &color;
+    beginRendering(cmd, info);
+}
+
+void Engine::recordBackbufferSecondaries(VkCommandBuffer cmd, VkFramebuffer framebuffer, VkExtent2D extent) {
+    // what a cached recording was made against besides the layer's own state
+    uint64_t targetKey = Hash::combine(Hash::FNV_OFFSET, (static_cast<uint64_t>(extent.width) << 32) | extent.height);
+    targetKey = Hash::combine(targetKey, static_cast<uint64_t>(colorFormat));
+    targetKey = Hash::combine(targetKey, reinterpret_cast<uint64_t>(imguiRenderPass));
+
+    // one secondary per layer in stack order, imgui last so it stays on top; imgui changes every frame
+    std::vector<SecondaryRecorder::Job> jobs;
+    for (LayerComponent* layer : current_app->getLayers()) {
+        SecondaryRecorder::Job job{ [layer](VkCommandBuffer secondary) { layer->onRender(secondary); }, layer->isParallelRecording() };
+        if (const uint64_t key = layer->getRecordingKey()) {
+            job.cacheKey = Hash::combine(Hash::combine(targetKey, key), reinterpret_cast<uint64_t>(layer));
         }
+        jobs.push_back(std::move(job));
     }
+    jobs.push_back({ [](VkCommandBuffer secondary) { ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), secondary); }, false });
 
-    VkSwapchainCreateInfoKHR sci{};
-    sci.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    sci.surface = surface;
-    sci.minImageCount = std::clamp(caps.minImageCount + 1, caps.minImageCount, caps.maxImageCount > 0 ? caps.maxImageCount : 100);
-    sci.imageFormat = chosenFormat.format;
-    sci.imageColorSpace = chosenFormat.colorSpace;
-    sci.imageExtent = swapchainExtent;
-    sci.imageArrayLayers = 1;
-    sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    sci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    sci.preTransform = caps.currentTransform;
-    sci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    sci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    sci.clipped = VK_TRUE;
-    sci.oldSwapchain = VK_NULL_HANDLE;
+    SecondaryRecorder::Target target;
+    target.renderPass = imguiRenderPass;
+    target.framebuffer = framebuffer;
+    target.colorFormat = colorFormat;
 
-    if (vkCreateSwapchainKHR(device, &sci, nullptr, &swapchain) != VK_SUCCESS)
-        throw std::runtime_error("failed to create swapchain");
+    const std::vector<VkCommandBuffer> secondaries = secondaryRecorder.record(target, jobs);
+    vkCmdExecuteCommands(cmd, static_cast<uint32_t>(secondaries.size()), secondaries.data());
 }
 
-void Engine::createFramebuffers() {
-    uint32_t imgCount;
-    vkGetSwapchainImagesKHR(device, swapchain, &imgCount, nullptr);
-    std::vector<VkImage> swapchainImages(imgCount);
-    vkGetSwapchainImagesKHR(device, swapchain, &imgCount, swapchainImages.data());
+void Engine::endBackbuffer(VkCommandBuffer cmd, VkImage image) {
+    if (!dynamicRenderingSupported) {
+        vkCmdEndRenderPass(cmd);
+        return;
+    }
+    endRendering(cmd);
+
+    // offscreen frames end up ready for readback instead of presentation, readbackFrame() adds its own dependency
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
 
-    framebuffers.resize(imgCount);
+void Engine::createOffscreenTargets() {
+    VkFormatProperties formatProps;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, colorFormat, &formatProps);
+    if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT))
+        throw std::runtime_error("offscreen format is not renderable on this device");
+
+    offscreenExtent = { std::max(1u, config.width), std::max(1u, config.height) };
+    offscreenTargets.resize(config.framesInFlight);
+
+    for (auto& target : offscreenTargets) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = colorFormat;
+        imageInfo.extent = { offscreenExtent.width, offscreenExtent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        gpuAllocator.createImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.image, target.memory);
 
-    for (size_t i = 0; i < imgCount; i++) {
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        viewInfo.image = swapchainImages[i];
+        viewInfo.image = target.image;
         viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        viewInfo.format = VK_FORMAT_B8G8R8A8_UNORM;
-        viewInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+        viewInfo.format = colorFormat;
         viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         viewInfo.subresourceRange.levelCount = 1;
         viewInfo.subresourceRange.layerCount = 1;
-        VkImageView imageView;
-        vkCreateImageView(device, &viewInfo, nullptr, &imageView);
+        if (vkCreateImageView(device, &viewInfo, nullptr, &target.view) != VK_SUCCESS)
+            throw std::runtime_error("offscreen view creation failed");
+
+        if (dynamicRenderingSupported) continue;
 
         VkFramebufferCreateInfo fbInfo{};
         fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         fbInfo.renderPass = imguiRenderPass;
         fbInfo.attachmentCount = 1;
-        fbInfo.pAttachments = &imageView;
-        fbInfo.width = swapchainExtent.width;
-        fbInfo.height = swapchainExtent.height;
+        fbInfo.pAttachments = &target.view;
+        fbInfo.width = offscreenExtent.width;
+        fbInfo.height = offscreenExtent.height;
         fbInfo.layers = 1;
+        if (vkCreateFramebuffer(device, &fbInfo, nullptr, &target.framebuffer) != VK_SUCCESS)
+            throw std::runtime_error("offscreen framebuffer creation failed");
+    }
+}
 
-        vkCreateFramebuffer(device, &fbInfo, nullptr, &framebuffers[i]);
+void Engine::destroyOffscreenTargets() {
+    for (auto& target : offscreenTargets) {
+        if (target.framebuffer) vkDestroyFramebuffer(device, target.framebuffer, nullptr);
+        if (target.view) vkDestroyImageView(device, target.view, nullptr);
+        gpuAllocator.destroyImage(target.image, target.memory);
     }
+    offscreenTargets.clear();
 }
 
-void Engine::createCommandBuffers() {
-    commandBuffers.resize(framebuffers.size());
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
-    vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data());
+bool Engine::readbackFrame(std::vector<uint8_t>& pixels) {
+    if (!config.headless || frameCount == 0) return false;
+
+    uint32_t texelSize = 0;
+    switch (colorFormat) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB: texelSize = 4; break;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: texelSize = 8; break;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: texelSize = 16; break;
+        default: return false;
+    }
+
+    const OffscreenTarget& target = offscreenTargets[lastSubmittedFrame];
+    vkWaitForFences(device, 1, &frames[lastSubmittedFrame].inFlight, VK_TRUE, UINT64_MAX);
+
+    const VkDeviceSize size = static_cast<VkDeviceSize>(offscreenExtent.width) * offscreenExtent.height * texelSize;
+
+    VkBuffer staging = VK_NULL_HANDLE;
+    GpuAllocation stagingMemory;
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = size;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    try {
+        // cached memory makes the cpu side read much faster where the driver has it
+        gpuAllocator.createBuffer(bufInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                  staging, stagingMemory, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    VkCommandBuffer cmd = beginSingleTimeCommands();
+
+    // the backbuffer pass already left the image in TRANSFER_SRC, only the write -> read dependency is missing
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = target.image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { offscreenExtent.width, offscreenExtent.height, 1 };
+    vkCmdCopyImageToBuffer(cmd, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging, 1, &region);
+
+    VkBufferMemoryBarrier hostBarrier{};
+    hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.buffer = staging;
+    hostBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+    endSingleTimeCommands(cmd);
+
+    pixels.resize(static_cast<size_t>(size));
+    memcpy(pixels.data(), stagingMemory.mapped, pixels.size());
+
+    gpuAllocator.destroyBuffer(staging, stagingMemory);
+    return true;
 }
 
 VkCommandBuffer Engine::beginSingleTimeCommands() {
@@ -499,7 +1314,17 @@ void Engine::endSingleTimeCommands(VkCommandBuffer cmd) {
     si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     si.commandBufferCount = 1;
     si.pCommandBuffers = &cmd;
-    vkQueueSubmit(graphicsQueue, 1, &si, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
+
+    // waits for this submit alone, not for everything else on the graphics queue
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence done = VK_NULL_HANDLE;
+    if (vkCreateFence(device, &fenceInfo, nullptr, &done) != VK_SUCCESS)
+        throw std::runtime_error("failed to create single time fence");
+
+    VkResult result = vkQueueSubmit(graphicsQueue, 1, &si, done);
+    if (result == VK_SUCCESS) result = vkWaitForFences(device, 1, &done, VK_TRUE, UINT64_MAX);
+    vkDestroyFence(device, done, nullptr);
     vkFreeCommandBuffers(device, commandPool, 1, &cmd);
+    if (result != VK_SUCCESS) throw std::runtime_error("single time commands failed");
 }
\ No newline at end of file
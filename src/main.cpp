@@ -1,18 +1,57 @@
 #include <SDL3/SDL_main.h>
 
 #include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
 #include "../include/engine.h"
 
 /*
  * assuming windows build platform
+ *
+ * --headless               render offscreen, no window or swapchain
+ * --size <w>x<h>           offscreen resolution in headless mode
+ * --frames <n>             stop after n frames (0 = run until quit)
+ * --frames-in-flight <n>   how far the cpu may run ahead of the gpu
+ * --no-hot-reload          don't watch shader_repo for glsl edits
+ * --shader-pack <path>     packed spir-v to load, empty string uses loose .spv files only
+ * --fixed-step <hz>        simulate layers at a fixed rate on their own thread, decoupled from rendering
  */
 int main(int argc, char* argv[]) {
+    EngineConfig config{};
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--headless") == 0) {
+            config.headless = true;
+        } else if (strcmp(argv[i], "--size") == 0 && hasValue) {
+            unsigned w = 0, h = 0;
+            if (sscanf(argv[++i], "%ux%u", &w, &h) == 2 && w > 0 && h > 0) {
+                config.width = w;
+                config.height = h;
+            }
+        } else if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+            config.frameLimit = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--frames-in-flight") == 0 && hasValue) {
+            config.framesInFlight = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--no-hot-reload") == 0) {
+            config.hotReload = false;
+        } else if (strcmp(argv[i], "--shader-pack") == 0 && hasValue) {
+            config.shaderPackPath = argv[++i];
+        } else if (strcmp(argv[i], "--fixed-step") == 0 && hasValue) {
+            config.fixedStepSimulation = true;
+            config.simulationRate = strtod(argv[++i], nullptr);
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << "\n";
+        }
+    }
+
     try {
-        Engine app;
+        Engine app(config);
         app.run();
     } catch (const std::exception& e) {
         std::cerr << "fatal error: " << e.what() << "\n";
         return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,236 @@
+// copyright 2025 swaroop.
+
+#include <templates/default_compute_shader_layer.h>
+#include <engine.h>
+#include <core/engine_object.h>
+#include <core/uniform_ring.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+DefaultComputeShaderLayer::DefaultComputeShaderLayer(EngineObject* parent, const std::string& name, std::string compPath,
+                                                     uint32_t workgroupX, uint32_t workgroupY)
+    : LayerComponent(parent, name), workgroupX(workgroupX), workgroupY(workgroupY)
+{
+    const std::vector<ShaderProgramDesc> programs = computePrograms(compPath, workgroupX, workgroupY);
+    desc = programs[0];
+    compositeDesc = programs[1];
+    if (auto* e = getEngine()) device = e->getDevice();
+}
+
+std::vector<ShaderProgramDesc> DefaultComputeShaderLayer::computePrograms(const std::string& compPath, uint32_t workgroupX,
+                                                                          uint32_t workgroupY) {
+    ShaderProgramDesc compute;
+    compute.compPath = compPath;
+    compute.specialization = { { WORKGROUP_X_ID, workgroupX }, { WORKGROUP_Y_ID, workgroupY } };
+
+    // the same stretch dynamic resolution uses, at scale 1 it is a plain copy
+    return { compute, { "shaders/fullscreen.vert.spv", "shaders/upscale.frag.spv" } };
+}
+
+void DefaultComputeShaderLayer::onAttach() {
+    if (!device) device = getEngine()->getDevice();
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(getEngine()->getPhysicalDevice(), &props);
+    const VkPhysicalDeviceLimits& limits = props.limits;
+    if (workgroupX == 0 || workgroupY == 0 || workgroupX > limits.maxComputeWorkGroupSize[0] ||
+        workgroupY > limits.maxComputeWorkGroupSize[1] || workgroupX * workgroupY > limits.maxComputeWorkGroupInvocations)
+        throw std::runtime_error(getName() + ": workgroup size " + std::to_string(workgroupX) + "x" +
+                                 std::to_string(workgroupY) + " is outside the device limits");
+
+    // usually already built by the prewarm workers while the select menu was up
+    PipelineStore& store = getEngine()->getPipelineStore();
+    compositeProgram = store.acquire(compositeDesc);
+    program = store.acquire(desc);
+    setupUniforms();
+}
+
+void DefaultComputeShaderLayer::onDetach() {
+    // the pipelines belong to the PipelineStore, the storage image to the render graph
+    program = nullptr;
+    compositeProgram = nullptr;
+    uniformMembers = nullptr;
+    uniformSource = UniformSource::None;
+}
+
+void DefaultComputeShaderLayer::onUpdate(float deltaTime) {
+    syncProgram();
+
+    if (getEngine()->hasFixedStepSimulation()) {
+        const double renderTime = getEngine()->getSimulation().getRenderTime();
+        totalTime = static_cast<float>(shaderClock.sample(renderTime, [](double a, double b, double t) { return a + (b - a) * t; }));
+    } else {
+        totalTime += deltaTime;
+    }
+
+    setUniform("iTime", &totalTime, sizeof(totalTime));
+    setUniform("iFrame", &frameIndex, sizeof(frameIndex));
+    frameIndex++;
+}
+
+void DefaultComputeShaderLayer::onSimulate(double step, double time) {
+    simulatedTime += step;
+    shaderClock.publish(simulatedTime, time);
+}
+
+void DefaultComputeShaderLayer::onBuildGraph(RenderGraph& graph) {
+    target = RenderGraph::INVALID_RESOURCE;
+    if (!program || uniformSource == UniformSource::Unsupported) return;
+
+    RenderGraph::ImageDesc imageDesc;
+    imageDesc.format = STORAGE_FORMAT;
+    imageDesc.scale = imageScale;
+
+    graph.addPass(getName() + " compute",
+        [&](RenderGraph::PassBuilder& builder) {
+            target = builder.createImage(getName() + " image", imageDesc);
+            builder.write(target, RenderGraph::Access::ComputeStorageWrite);
+        },
+        [this, &graph](const RenderGraph::PassContext& ctx) {
+            syncProgram();
+            if (program->setLayouts.size() < 2) return;
+
+            VkDescriptorSet set = graph.allocateSet(program->setLayouts[1]);
+            VkDescriptorImageInfo imageInfo{ VK_NULL_HANDLE, graph.getImageView(target), VK_IMAGE_LAYOUT_GENERAL };
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = set;
+            write.dstBinding = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            write.pImageInfo = &imageInfo;
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+            recordDispatch(ctx.cmd, graph.getExtent(target), set);
+        });
+    graph.sampleInBackbuffer(target);
+}
+
+void DefaultComputeShaderLayer::recordDispatch(VkCommandBuffer cmd, VkExtent2D extent, VkDescriptorSet set) {
+    if (!program || !program->pipeline || uniformSource == UniformSource::Unsupported) return;
+
+    // the shader draws at the image's size, not the window's
+    const float resolution[3] = { static_cast<float>(extent.width), static_cast<float>(extent.height), 1.0f };
+    setUniform("iResolution", resolution, sizeof(resolution));
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program->pipeline);
+
+    if (uniformSource == UniformSource::PushConstants) {
+        vkCmdPushConstants(
+            cmd,
+            program->layout,
+            PipelineStore::UNIFORM_STAGES,
+            0,
+            static_cast<uint32_t>(uniformBlock.size()),
+            uniformBlock.data());
+    } else if (uniformSource == UniformSource::Ring) {
+        UniformRing& ring = getEngine()->getUniformRing();
+        const uint32_t offset = ring.push(uniformBlock.data(), uniformBlock.size());
+        VkDescriptorSet descriptorSet = ring.getDescriptorSet();
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program->layout, 0, 1, &descriptorSet, 1, &offset);
+    }
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, program->layout, 1, 1, &set, 0, nullptr);
+
+    vkCmdDispatch(cmd, (extent.width + workgroupX - 1) / workgroupX, (extent.height + workgroupY - 1) / workgroupY, 1);
+}
+
+void DefaultComputeShaderLayer::onRender(VkCommandBuffer cmd) {
+    if (target == RenderGraph::INVALID_RESOURCE || !compositeProgram || !compositeProgram->pipeline) return;
+
+    auto size = getEngine()->getViewport().getLogicalSize();
+    if (size.x <= 0 || size.y <= 0) return;
+    const VkExtent2D extent{ static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y) };
+
+    RenderGraph& graph = getEngine()->getRenderGraph();
+    const VkExtent2D imageExtent = graph.getExtent(target);
+
+    // Upscale in shaders/upscale.frag, the whole image was written so only the clamp to the last texel center matters
+    const float push[4] = { 1.0f, 1.0f, (imageExtent.width - 0.5f) / imageExtent.width,
+                            (imageExtent.height - 0.5f) / imageExtent.height };
+
+    VkDescriptorSet set = graph.allocateSet(compositeProgram->setLayouts[0]);
+    VkDescriptorImageInfo imageInfo{ graph.getLinearSampler(), graph.getImageView(target),
+                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    VkViewport vp{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+    VkRect2D sci{ {0, 0}, extent };
+    vkCmdSetViewport(cmd, 0, 1, &vp);
+    vkCmdSetScissor(cmd, 0, 1, &sci);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, compositeProgram->pipeline);
+    vkCmdPushConstants(cmd, compositeProgram->layout, PipelineStore::UNIFORM_STAGES, 0, sizeof(push), push);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, compositeProgram->layout, 0, 1, &set, 0, nullptr);
+    vkCmdDraw(cmd, 3, 1, 0, 0);
+}
+
+void DefaultComputeShaderLayer::setupUniforms() {
+    PipelineStore& store = getEngine()->getPipelineStore();
+    generation = program->generation;
+
+    const ShaderReflection& refl = program->reflection;
+    const ShaderReflection::Binding* ubo = refl.findBinding(0, 0);
+    const ShaderReflection::Binding* image = refl.findBinding(1, 0);
+
+    // not fatal, a hot reload can land here and the next save may fix it
+    auto unsupported = [&](const char* problem) {
+        printf("[%s] %s: %s\n", getName().c_str(), desc.compPath.c_str(), problem);
+        uniformSource = UniformSource::Unsupported;
+        uniformMembers = nullptr;
+        uniformBlock.clear();
+    };
+
+    auto hasSpec = [&](uint32_t id) {
+        return std::any_of(refl.specConstants.begin(), refl.specConstants.end(),
+                           [id](const ShaderReflection::SpecConstant& s) { return s.id == id; });
+    };
+    if (!hasSpec(WORKGROUP_X_ID) || !hasSpec(WORKGROUP_Y_ID))
+        return unsupported("declare layout(local_size_x_id = 0, local_size_y_id = 1) in, the dispatch size depends on it");
+    if (!image || image->type != VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+        return unsupported("set 1 binding 0 has to be the storage image");
+
+    if (refl.pushConstants.size > 0) {
+        uniformSource = UniformSource::PushConstants;
+        uniformMembers = &refl.pushConstants.members;
+        uniformBlock.assign((refl.pushConstants.size + 3u) & ~3u, 0);
+    } else if (ubo && ubo->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+        // the ring's descriptor set is only compatible when set 0 holds nothing but the block
+        if (program->setLayouts[0] != store.getDefaultSetLayout())
+            return unsupported("set 0 may only hold the uniform block, move other resources to set 1+");
+        if (ubo->blockSize > UniformRing::MAX_BLOCK_SIZE)
+            return unsupported("uniform block larger than the uniform ring allows");
+
+        uniformSource = UniformSource::Ring;
+        uniformMembers = &ubo->members;
+        uniformBlock.assign(ubo->blockSize, 0);
+    } else {
+        uniformSource = UniformSource::None;
+        uniformMembers = nullptr;
+        uniformBlock.clear();
+    }
+}
+
+bool DefaultComputeShaderLayer::setUniform(const std::string& member, const void* data, size_t size) {
+    syncProgram();
+    if (!uniformMembers) return false;
+
+    for (const auto& m : *uniformMembers) {
+        if (m.name != member) continue;
+        if (m.offset >= uniformBlock.size()) return false;
+
+        // a shader declaring the member smaller than we send it (vec2 vs vec3) just gets the leading components
+        const size_t count = std::min({ size, static_cast<size_t>(m.size), uniformBlock.size() - m.offset });
+        memcpy(uniformBlock.data() + m.offset, data, count);
+        return true;
+    }
+    return false;
+}
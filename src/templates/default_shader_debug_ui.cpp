@@ -4,6 +4,8 @@
 #include <imgui/imgui.h>
 
 #include "engine.h"
+#include <core/engine_object.h>
+#include <templates/default_shader_layer.h>
 #include "select_menu/select_menu.h"
 
 DefaultShaderDebugUILayer::DefaultShaderDebugUILayer(EngineObject* parent, const std::string& name)
@@ -31,6 +33,50 @@ void DefaultShaderDebugUILayer::onUpdate(float deltaTime) {
         }
         
         ImGui::PopStyleColor();
+
+        // hot reload, the last good shader keeps running while these are up
+        const ShaderHotReload& reload = getEngine()->getHotReload();
+        for (const auto& error : reload.getErrors()) {
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+            ImGui::TextUnformatted(error.path.c_str());
+            ImGui::TextUnformatted(error.log.c_str());
+            ImGui::PopStyleColor();
+        }
+        if (reload.getReloadCount() > 0) {
+            ImGui::TextDisabled("reloaded %s (%u)", reload.getLastReloaded().c_str(), reload.getReloadCount());
+        }
+
+        for (LayerComponent* layer : getParent()->getLayers()) {
+            auto* shaderLayer = dynamic_cast<DefaultShaderLayer*>(layer);
+            if (!shaderLayer) continue;
+
+            // layers trading resolution for frame time
+            if (shaderLayer->hasDynamicResolution()) {
+                const ResolutionGovernor& governor = shaderLayer->getResolutionGovernor();
+                ImGui::TextDisabled("render scale %.2f (gpu %.2f / %.2f ms)", governor.getScale(),
+                                    getEngine()->getGpuFrameTimeMs(), governor.getConfig().budgetMs);
+            }
+
+            // spec variants, all prewarmed so clicking through them doesn't hitch
+            if (shaderLayer->getSpecVariants().size() > 1) {
+                ImGui::TextDisabled("variant");
+                for (const auto& variant : shaderLayer->getSpecVariants()) {
+                    ImGui::SameLine();
+                    if (ImGui::RadioButton(variant.name.c_str(), variant.name == shaderLayer->getSpecVariant()))
+                        shaderLayer->setSpecVariant(variant.name);
+                }
+            }
+        }
+
+        // last frame's graph, only worth showing once a layer adds passes of its own
+        const RenderGraph::Stats& graph = getEngine()->getRenderGraph().getStats();
+        if (graph.passCount > 1) {
+            ImGui::TextDisabled("graph: %u passes (%u culled), %u barriers", graph.passCount, graph.culledPasses, graph.barrierCount);
+            if (graph.transientImages + graph.transientBuffers > 0) {
+                ImGui::TextDisabled("transients: %.1f MiB in %.1f MiB",
+                                    graph.transientBytes / (1024.0 * 1024.0), graph.allocatedBytes / (1024.0 * 1024.0));
+            }
+        }
     }
     ImGui::End();
 }
\ No newline at end of file
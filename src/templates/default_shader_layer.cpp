@@ -4,316 +4,675 @@
 #include <engine.h>
 #include <util/viewport.h>
 #include <core/engine_object.h>
+#include <core/pipeline_store.h>
+#include <core/uniform_ring.h>
+#include <util/hash.h>
 
-#include <fstream>
 #include <vector>
 #include <stdexcept>
-#include <iostream>
-#include <filesystem>
-#include <cstring>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
 
-#define VK_CHECK(x) do { if ((x) != VK_SUCCESS) throw std::runtime_error("Vulkan Error in DefaultShaderLayer"); } while (0)
+DefaultShaderLayer::DefaultShaderLayer(EngineObject* parent, const std::string& name, std::string vertPath, std::string fragPath)
+    : LayerComponent(parent, name)
+{
+    mainPass.desc = { std::move(vertPath), std::move(fragPath) };
+    if (auto* e = getEngine()) device = e->getDevice();
+}
 
-/*
- * @brief AI-Generated sloppy helper function
- */
-static std::vector<char> readFile(const std::string& filename) {
-    auto tryPath = [&](std::string p) {
-        std::ifstream f(p, std::ios::ate | std::ios::binary);
-        if (!f.is_open()) return std::vector<char>{};
-        size_t size = (size_t)f.tellg();
-        std::vector<char> buf(size);
-        f.seekg(0); f.read(buf.data(), size);
-        return buf;
-    };
+DefaultShaderLayer::DefaultShaderLayer(EngineObject* parent, const std::string& name, const ShaderProgramDesc& desc)
+    : DefaultShaderLayer(parent, name, desc.vertPath, desc.fragPath)
+{
+    // specialization, color format and the rest of it as given, spec variants replace the specialization later
+    mainPass.desc = desc;
+}
 
-    // multiple search directories to locate the shader files
-    auto data = tryPath(filename);
-    if (data.empty()) data = tryPath("../" + filename);
-    if (data.empty()) data = tryPath("../../" + filename);
-    if (data.empty()) data = tryPath("../../../" + filename);
-    
-    if (data.empty() && filename.find("shader_repo/") == std::string::npos) {
-         data = tryPath("../../shader_repo/" + filename); 
+void DefaultShaderLayer::addFeedbackBuffer(const FeedbackBuffer& buffer) {
+    if (feedback.size() >= MAX_FEEDBACK_BUFFERS)
+        throw std::runtime_error(getName() + ": at most 4 feedback buffers");
+    if ((buffer.width == 0) != (buffer.height == 0))
+        throw std::runtime_error(getName() + ": feedback buffer needs both width and height, or neither");
+
+    FeedbackTarget target;
+    target.config = buffer;
+    target.pass.desc = { buffer.vertPath.empty() ? mainPass.desc.vertPath : buffer.vertPath, buffer.fragPath, buffer.format };
+    feedback.push_back(std::move(target));
+}
+
+void DefaultShaderLayer::enableDynamicResolution(const ResolutionGovernor::Config& config) {
+    dynamicResolution = true;
+    governor.setConfig(config);
+}
+
+std::vector<ShaderProgramDesc> DefaultShaderLayer::dynamicResolutionPrograms(const ShaderProgramDesc& program) {
+    ShaderProgramDesc scaled = program;
+    scaled.colorFormat = SCALED_FORMAT;
+    return { scaled, { "shaders/fullscreen.vert.spv", "shaders/upscale.frag.spv" } };
+}
+
+void DefaultShaderLayer::addSpecVariant(const SpecVariant& variant) {
+    for (const auto& existing : specVariants) {
+        if (existing.name == variant.name)
+            throw std::runtime_error(getName() + ": spec variant '" + variant.name + "' added twice");
     }
+    specVariants.push_back(variant);
+}
 
-    if (data.empty()) {
-        std::cerr << "[Shader Error] Could not find file: " << filename << "\nCWD: " << std::filesystem::current_path() << "\n";
-        throw std::runtime_error("Shader missing: " + filename);
+const std::string& DefaultShaderLayer::getSpecVariant() const {
+    static const std::string none;
+    return specVariants.empty() ? none : specVariants[currentVariant].name;
+}
+
+std::vector<ShaderProgramDesc> DefaultShaderLayer::specVariantPrograms(const ShaderProgramDesc& program,
+                                                                       const std::vector<SpecVariant>& variants) {
+    if (variants.empty()) return { program };
+
+    std::vector<ShaderProgramDesc> programs;
+    for (const auto& variant : variants) {
+        programs.push_back(program);
+        programs.back().specialization = variant.values;
     }
-    return data;
+    return programs;
 }
 
+bool DefaultShaderLayer::setSpecVariant(const std::string& name) {
+    auto it = std::find_if(specVariants.begin(), specVariants.end(), [&](const SpecVariant& v) { return v.name == name; });
+    if (it == specVariants.end()) return false;
 
-DefaultShaderLayer::DefaultShaderLayer(EngineObject* parent, const std::string& name, std::string vertPath, std::string fragPath)
-    : LayerComponent(parent, name)
-    , vertexShaderPath(std::move(vertPath))
-    , fragmentShaderPath(std::move(fragPath))
-{
-    if (auto* e = getEngine()) device = e->getDevice();
+    const size_t index = static_cast<size_t>(it - specVariants.begin());
+    if (index == currentVariant) return true;
+    if (!mainPass.program) {
+        // not attached, createPipeline() starts from this one
+        currentVariant = index;
+        return true;
+    }
+
+    // prewarmed at attach, so this is a map lookup unless a worker is still on it
+    PipelineStore& store = getEngine()->getPipelineStore();
+    const std::vector<Pass*> passes = specializedPasses();
+    std::vector<const PipelineStore::Program*> programs;
+    try {
+        for (Pass* pass : passes) {
+            ShaderProgramDesc desc = pass->desc;
+            desc.specialization = it->values;
+            programs.push_back(store.acquire(desc));
+        }
+    } catch (const std::exception& e) {
+        printf("[%s] spec variant %s: %s\n", getName().c_str(), name.c_str(), e.what());
+        return false;
+    }
+
+    for (size_t i = 0; i < passes.size(); i++) {
+        Pass& pass = *passes[i];
+        pass.desc.specialization = it->values;
+        pass.program = programs[i];
+
+        // same block layout in every variant as long as no constant sizes an array in it, keep what was written
+        std::vector<uint8_t> block = std::move(pass.uniformBlock);
+        setupUniforms(pass);
+        if (block.size() == pass.uniformBlock.size()) pass.uniformBlock = std::move(block);
+    }
+
+    currentVariant = index;
+    printf("[%s] spec variant %s\n", getName().c_str(), name.c_str());
+    return true;
+}
+
+std::vector<DefaultShaderLayer::Pass*> DefaultShaderLayer::specializedPasses() {
+    std::vector<Pass*> passes{ &mainPass };
+    for (auto& target : feedback) passes.push_back(&target.pass);
+    return passes;
+}
+
+// a name no pass declares is skipped when building, most likely a typo
+void DefaultShaderLayer::checkSpecVariants() {
+    for (const auto& variant : specVariants) {
+        for (const auto& value : variant.values) {
+            if (value.name.empty()) continue;
+
+            bool declared = false;
+            for (Pass* pass : specializedPasses()) {
+                const auto& constants = pass->program->reflection.specConstants;
+                declared |= std::any_of(constants.begin(), constants.end(),
+                                        [&](const ShaderReflection::SpecConstant& c) { return c.name == value.name; });
+            }
+            if (!declared) {
+                printf("[%s] spec variant %s: no shader declares '%s'\n",
+                       getName().c_str(), variant.name.c_str(), value.name.c_str());
+            }
+        }
+    }
 }
 
 void DefaultShaderLayer::onAttach() {
-    createResources();
+    if (!device) device = getEngine()->getDevice();
+    // static blocks come out of every frame's region, only layers that can replay take one
+    if (cachedRecording && feedback.empty() && !dynamicResolution) {
+        staticUniforms = getEngine()->getUniformRing().allocateStatic();
+    }
     createPipeline();
 }
 
 void DefaultShaderLayer::onDetach() {
-    if (!device) return;
-    vkDeviceWaitIdle(device);
-
-    auto safeDestroy = [&](auto& obj, auto deleter) { 
-        if (obj) { deleter(device, obj, nullptr); obj = VK_NULL_HANDLE; } 
-    };
-
-    safeDestroy(graphicsPipeline, vkDestroyPipeline);
-    safeDestroy(pipelineLayout, vkDestroyPipelineLayout);
-    safeDestroy(descriptorPool, vkDestroyDescriptorPool);
-    safeDestroy(descriptorSetLayout, vkDestroyDescriptorSetLayout);
-    safeDestroy(uniformBuffer, vkDestroyBuffer);
-    
-    if (uniformBufferMemory) { vkFreeMemory(device, uniformBufferMemory, nullptr); uniformBufferMemory = VK_NULL_HANDLE; }
-    mappedData = nullptr;
+    // the pipelines and their layouts belong to the PipelineStore and stay alive for the next launch
+    // uniforms live in the engine's ring, the feedback images are the only thing of our own
+    if (staticUniforms != NO_STATIC_BLOCK) {
+        getEngine()->getUniformRing().freeStatic(staticUniforms);
+        staticUniforms = NO_STATIC_BLOCK;
+    }
+    for (auto& target : feedback) {
+        for (auto& image : target.images) destroyFeedbackImage(image);
+        destroyFeedbackImage(target.retiring);
+        target.extent = {};
+        target.pass.program = nullptr;
+        target.pass.uniformMembers = nullptr;
+        target.pass.uniformSource = UniformSource::None;
+    }
+    for (Pass* pass : { &mainPass, &upscalePass }) {
+        pass->program = nullptr;
+        pass->uniformMembers = nullptr;
+        pass->uniformSource = UniformSource::None;
+    }
 }
 
 void DefaultShaderLayer::onUpdate(float deltaTime) {
-    totalTime += deltaTime;
+    syncProgram(mainPass);
+    for (auto& target : feedback) syncProgram(target.pass);
+
+    if (getEngine()->hasFixedStepSimulation()) {
+        const double renderTime = getEngine()->getSimulation().getRenderTime();
+        totalTime = static_cast<float>(shaderClock.sample(renderTime, [](double a, double b, double t) { return a + (b - a) * t; }));
+    } else {
+        totalTime += deltaTime;
+    }
+
+    if (dynamicResolution) {
+        Engine* e = getEngine();
+        // one sample per timed frame, the scale shows up in them framesInFlight frames later
+        if (!e->isHeadless() && e->hasGpuTimings() && e->getGpuTimedFrame() != governedFrame) {
+            governedFrame = e->getGpuTimedFrame();
+            governor.update(e->getGpuFrameTimeMs(), e->getFramesInFlight());
+        }
+
+        const float scale = e->isHeadless() ? governor.getConfig().maxScale : governor.getScale();
+        const VkExtent2D render = e->getRenderExtent();
+        scaledExtent = { std::max(1u, static_cast<uint32_t>(render.width * scale)),
+                         std::max(1u, static_cast<uint32_t>(render.height * scale)) };
+    }
+
     updateUniforms();
+    frameIndex++;
+}
+
+bool DefaultShaderLayer::canReplay() const {
+    return staticUniforms != NO_STATIC_BLOCK && feedback.empty() && !dynamicResolution &&
+           mainPass.program && mainPass.program->pipeline && mainPass.uniformSource != UniformSource::PushConstants;
+}
+
+uint64_t DefaultShaderLayer::getRecordingKey() const {
+    if (!canReplay()) return 0;
+
+    // hot reloads and spec variant switches hand out a different pipeline, resizes a different viewport
+    auto size = getEngine()->getViewport().getLogicalSize();
+    uint64_t key = Hash::combine(Hash::FNV_OFFSET, reinterpret_cast<uint64_t>(mainPass.program->pipeline));
+    key = Hash::combine(key, reinterpret_cast<uint64_t>(mainPass.program->layout));
+    key = Hash::combine(key, (static_cast<uint64_t>(std::max(0.0f, size.x)) << 32) | static_cast<uint64_t>(std::max(0.0f, size.y)));
+    key = Hash::combine(key, staticUniforms);
+    return key;
+}
+
+void DefaultShaderLayer::onBuildGraph(RenderGraph& graph) {
+    // a replayed recording reads this frame's copy of the static block, onRender may not run at all
+    // written here rather than in onUpdate so setUniform() calls from a subclass's onUpdate make it in
+    if (canReplay() && mainPass.uniformSource == UniformSource::Ring) {
+        getEngine()->getUniformRing().writeStatic(staticUniforms, mainPass.uniformBlock.data(), mainPass.uniformBlock.size());
+    }
+
+    mainChannels.clear();
+    scaledTarget = RenderGraph::INVALID_RESOURCE;
+
+    if (!feedback.empty()) buildFeedbackPasses(graph);
+    if (!dynamicResolution) return;
+
+    // sized for the max scale so a scale change only moves the viewport, the graph keeps its memory
+    RenderGraph::ImageDesc desc;
+    desc.format = SCALED_FORMAT;
+    desc.scale = governor.getConfig().maxScale;
+
+    graph.addPass(getName() + " scaled",
+        [&](RenderGraph::PassBuilder& builder) {
+            scaledTarget = builder.createImage(getName() + " scaled", desc);
+            builder.write(scaledTarget, RenderGraph::Access::ColorAttachment);
+            for (RenderGraph::Resource r : mainChannels) builder.read(r, RenderGraph::Access::FragmentSampled);
+        },
+        [this, &graph](const RenderGraph::PassContext& ctx) {
+            syncProgram(mainPass);
+            VkDescriptorSet channels = VK_NULL_HANDLE;
+            if (!mainChannels.empty()) channels = writeChannelSet(graph, mainPass, mainChannels);
+            recordPass(mainPass, ctx.cmd, scaledExtent, channels);
+        });
+    graph.sampleInBackbuffer(scaledTarget);
+}
+
+void DefaultShaderLayer::buildFeedbackPasses(RenderGraph& graph) {
+    for (auto& target : feedback) {
+        // whatever was drawn last frame becomes this frame's history
+        const uint32_t last = target.current;
+        target.current ^= 1;
+
+        destroyFeedbackImage(target.retiring);
+        const VkExtent2D extent = feedbackExtent(target.config);
+        if (extent.width != target.extent.width || extent.height != target.extent.height) {
+            resizeFeedbackTarget(target, extent, last);
+        }
+    }
+
+    // both halves of every pair are in the graph, passes pick this or last frame's side
+    std::vector<RenderGraph::Resource> current(feedback.size());
+    std::vector<RenderGraph::Resource> previous(feedback.size());
+    for (size_t i = 0; i < feedback.size(); i++) {
+        FeedbackTarget& target = feedback[i];
+        const std::string name = getName() + " buffer " + static_cast<char>('A' + i);
+        for (uint32_t side = 0; side < 2; side++) {
+            FeedbackImage& image = target.images[side];
+            const RenderGraph::Resource res = graph.importImage(name, image.image, image.view, target.config.format,
+                                                                target.extent, &image.state);
+            (side == target.current ? current : previous)[i] = res;
+        }
+        if (target.seedHistory) {
+            seedHistory(graph, target, previous[i]);
+            target.seedHistory = false;
+        }
+    }
+
+    for (size_t i = 0; i < feedback.size(); i++) {
+        std::vector<RenderGraph::Resource> channels(feedback.size());
+        for (size_t j = 0; j < feedback.size(); j++) {
+            channels[j] = j < i ? current[j] : previous[j];
+        }
+
+        Pass* pass = &feedback[i].pass;
+        graph.addPass(getName() + " buffer " + static_cast<char>('A' + i),
+            [&](RenderGraph::PassBuilder& builder) {
+                builder.write(current[i], RenderGraph::Access::ColorAttachment);
+                for (RenderGraph::Resource r : channels) builder.read(r, RenderGraph::Access::FragmentSampled);
+            },
+            [this, pass, channels, &graph](const RenderGraph::PassContext& ctx) {
+                syncProgram(*pass);
+                recordPass(*pass, ctx.cmd, ctx.extent, writeChannelSet(graph, *pass, channels));
+            });
+    }
+
+    // with dynamic resolution the layer's shader draws in a pass of its own, that pass reads them instead
+    mainChannels = current;
+    if (!dynamicResolution) {
+        for (RenderGraph::Resource r : current) graph.sampleInBackbuffer(r);
+    }
 }
 
 void DefaultShaderLayer::onRender(VkCommandBuffer cmd) {
-    if (!graphicsPipeline) return;
+    syncProgram(mainPass);
 
     auto size = getEngine()->getViewport().getLogicalSize();
     if (size.x <= 0 || size.y <= 0) return;
+    const VkExtent2D extent{ static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y) };
+
+    if (dynamicResolution) {
+        recordUpscale(cmd, extent);
+        return;
+    }
+
+    VkDescriptorSet channels = VK_NULL_HANDLE;
+    if (!mainChannels.empty()) channels = writeChannelSet(getEngine()->getRenderGraph(), mainPass, mainChannels);
+
+    recordPass(mainPass, cmd, extent, channels);
+}
+
+void DefaultShaderLayer::recordUpscale(VkCommandBuffer cmd, VkExtent2D extent) {
+    syncProgram(upscalePass);
+    if (scaledTarget == RenderGraph::INVALID_RESOURCE || !upscalePass.program) return;
+
+    RenderGraph& graph = getEngine()->getRenderGraph();
+    const VkExtent2D imageExtent = graph.getExtent(scaledTarget);
+
+    // only the top left scaledExtent was drawn, clamp to its last texel center so the filter stays inside
+    const float uvScale[2] = { static_cast<float>(scaledExtent.width) / imageExtent.width,
+                               static_cast<float>(scaledExtent.height) / imageExtent.height };
+    const float uvMax[2] = { (scaledExtent.width - 0.5f) / imageExtent.width,
+                             (scaledExtent.height - 0.5f) / imageExtent.height };
+    writeUniform(upscalePass, "uvScale", uvScale, sizeof(uvScale));
+    writeUniform(upscalePass, "uvMax", uvMax, sizeof(uvMax));
+
+    VkDescriptorSet set = graph.allocateSet(upscalePass.program->setLayouts[0]);
+    VkDescriptorImageInfo imageInfo{ graph.getLinearSampler(), graph.getImageView(scaledTarget),
+                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    recordPass(upscalePass, cmd, extent, set, 0);
+}
+
+void DefaultShaderLayer::recordPass(Pass& pass, VkCommandBuffer cmd, VkExtent2D extent, VkDescriptorSet set, uint32_t setIndex) {
+    if (!pass.program || !pass.program->pipeline) return;
+    if (pass.uniformSource == UniformSource::Unsupported) return;
 
-    VkViewport vp{ 0.0f, 0.0f, size.x, size.y, 0.0f, 1.0f };
-    VkRect2D sci{ {0, 0}, {(uint32_t)size.x, (uint32_t)size.y} };
+    VkViewport vp{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+    VkRect2D sci{ {0, 0}, extent };
 
     vkCmdSetViewport(cmd, 0, 1, &vp);
     vkCmdSetScissor(cmd, 0, 1, &sci);
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-    vkCmdBindDescriptorSets(
-        cmd, 
-        VK_PIPELINE_BIND_POINT_GRAPHICS, 
-        pipelineLayout, 
-        0, 
-        1, 
-        &descriptorSet, 
-        0, 
-        nullptr);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pass.program->pipeline);
+
+    if (pass.uniformSource == UniformSource::PushConstants) {
+        vkCmdPushConstants(
+            cmd,
+            pass.program->layout,
+            PipelineStore::UNIFORM_STAGES,
+            0,
+            static_cast<uint32_t>(pass.uniformBlock.size()),
+            pass.uniformBlock.data());
+    } else if (pass.uniformSource == UniformSource::Ring) {
+        // a fresh slot every frame, the block an earlier frame is still reading is left alone
+        // a replayable recording binds this frame slot's copy of the static block instead, written in onBuildGraph
+        UniformRing& ring = getEngine()->getUniformRing();
+        const uint32_t offset = &pass == &mainPass && canReplay()
+            ? ring.getStaticOffset(staticUniforms)
+            : ring.push(pass.uniformBlock.data(), pass.uniformBlock.size());
+        VkDescriptorSet descriptorSet = ring.getDescriptorSet();
+        vkCmdBindDescriptorSets(
+            cmd, 
+            VK_PIPELINE_BIND_POINT_GRAPHICS, 
+            pass.program->layout, 
+            0, 
+            1, 
+            &descriptorSet, 
+            1, 
+            &offset);
+    }
+    if (set) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pass.program->layout, setIndex, 1, &set, 0, nullptr);
+    }
     vkCmdDraw(cmd, 3, 1, 0, 0);
 }
 
-void DefaultShaderLayer::createResources() {
-    VkPhysicalDevice gpu = getEngine()->getPhysicalDevice();
-
-    // memory type finder
-    auto findMem = [&](uint32_t filter, VkMemoryPropertyFlags props) {
-        VkPhysicalDeviceMemoryProperties mem;
-        vkGetPhysicalDeviceMemoryProperties(gpu, &mem);
-        for (uint32_t i = 0; i < mem.memoryTypeCount; i++)
-            if ((filter & (1 << i)) && (mem.memoryTypes[i].propertyFlags & props) == props) return i;
-        throw std::runtime_error("No suitable memory");
-    };
-
-    // uniform buffer
-    VkDeviceSize size = sizeof(UniformBufferObject);
-    VkBufferCreateInfo bufInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, 
-        nullptr, 
-        0, 
-        size, 
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-        VK_SHARING_MODE_EXCLUSIVE };
-    VK_CHECK(vkCreateBuffer(device, &bufInfo, nullptr, &uniformBuffer));
-
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device, uniformBuffer, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, 
-        nullptr, 
-        memReq.size, 
-        findMem(memReq.memoryTypeBits, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) };
-    
-    VK_CHECK(vkAllocateMemory(device, 
-        &allocInfo, 
-        nullptr, 
-        &uniformBufferMemory));
-    VK_CHECK(vkBindBufferMemory(device, 
-        uniformBuffer, 
-        uniformBufferMemory, 
-        0));
-    VK_CHECK(vkMapMemory(device, 
-        uniformBufferMemory, 
-        0, 
-        size, 
-        0, 
-        &mappedData));
-
-    /*
-     * descriptors
-     * not formatted because i coped these
-     */
-    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 };
-    VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0, 1, 1, &poolSize };
-    VK_CHECK(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool));
-
-    VkDescriptorSetLayoutBinding binding{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr };
-    VkDescriptorSetLayoutCreateInfo layInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0, 1, &binding };
-    VK_CHECK(vkCreateDescriptorSetLayout(device, &layInfo, nullptr, &descriptorSetLayout));
-
-    VkDescriptorSetAllocateInfo allocSetInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, descriptorPool, 1, &descriptorSetLayout };
-    VK_CHECK(vkAllocateDescriptorSets(device, &allocSetInfo, &descriptorSet));
-
-    VkDescriptorBufferInfo dbi{ uniformBuffer, 0, size };
-    VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, descriptorSet, 0, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &dbi, nullptr };
-    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+void DefaultShaderLayer::createPipeline() {
+    // usually already built by the prewarm workers while the select menu was up
+    PipelineStore& store = getEngine()->getPipelineStore();
+    if (dynamicResolution) {
+        const std::vector<ShaderProgramDesc> programs = dynamicResolutionPrograms(mainPass.desc);
+        mainPass.desc = programs[0];
+        upscalePass.desc = programs[1];
+        upscalePass.program = store.acquire(upscalePass.desc);
+        setupUniforms(upscalePass);
+    }
+
+    if (!specVariants.empty()) {
+        // the other variants build in the background, switching to one later doesn't compile on the render thread
+        std::vector<ShaderProgramDesc> variants;
+        for (Pass* pass : specializedPasses()) {
+            pass->desc.specialization = specVariants[currentVariant].values;
+            for (auto& desc : specVariantPrograms(pass->desc, specVariants)) variants.push_back(std::move(desc));
+        }
+        store.prewarm(variants);
+    }
+
+    mainPass.program = store.acquire(mainPass.desc);
+    setupUniforms(mainPass);
+
+    for (auto& target : feedback) {
+        target.pass.program = store.acquire(target.pass.desc);
+        setupUniforms(target.pass);
+    }
+
+    checkSpecVariants();
 }
 
-void DefaultShaderLayer::createPipeline() {
-    auto createMod = [&](const std::string& path) {
-        auto code = readFile(path);
-        VkShaderModuleCreateInfo info{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, nullptr, 0, code.size(), (uint32_t*)code.data() };
-        VkShaderModule mod;
-        VK_CHECK(vkCreateShaderModule(device, &info, nullptr, &mod));
-        return mod;
-    };
-
-    VkShaderModule vs = createMod(vertexShaderPath);
-    VkShaderModule fs = createMod(fragmentShaderPath);
-
-    VkPipelineShaderStageCreateInfo stages[] = {
-        { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            nullptr,
-            0,
-            VK_SHADER_STAGE_VERTEX_BIT,
-            vs,
-            "main" },
-        { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            nullptr,
-            0,
-            VK_SHADER_STAGE_FRAGMENT_BIT,
-            fs,
-            "main" }
-    };
-
-    /*
-     * code to generate the standard screen triangle
-     */
-    VkPipelineVertexInputStateCreateInfo vi{
-        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
-    VkPipelineInputAssemblyStateCreateInfo ia{
-        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        nullptr,
-        0,
-        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-        VK_FALSE
-    };
-    VkPipelineViewportStateCreateInfo vp{
-        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        nullptr,
-        0,
-        1,
-        nullptr,
-        1,
-        nullptr
-    };
-    VkPipelineRasterizationStateCreateInfo rs{
-        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        nullptr,
-        0,
-        VK_FALSE,
-        VK_FALSE,
-        VK_POLYGON_MODE_FILL,
-        VK_CULL_MODE_NONE,
-        VK_FRONT_FACE_COUNTER_CLOCKWISE,
-        VK_FALSE,
-        0,
-        0,
-        0,
-        1.0f
-    };
-    VkPipelineMultisampleStateCreateInfo ms{
-        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        nullptr,
-        0,
-        VK_SAMPLE_COUNT_1_BIT,
-        VK_FALSE,
-        1.0f,
-        nullptr,
-        VK_FALSE,
-        VK_FALSE
-    };
-    
-
-    // some more bullshit
-    VkPipelineColorBlendAttachmentState att{};
-    att.blendEnable = VK_FALSE;
-    att.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-    att.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    att.colorBlendOp = VK_BLEND_OP_ADD;
-    att.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    att.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    att.alphaBlendOp = VK_BLEND_OP_ADD;
-    att.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-    VkPipelineColorBlendStateCreateInfo cb{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        nullptr,
-        0,
-        VK_FALSE,
-        VK_LOGIC_OP_COPY,
-        1,
-        &att,
-        {0,0,0,0}
-    };
-    
-    VkPipelineLayoutCreateInfo pli{
-        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        nullptr,
-        0,
-        1,
-        &descriptorSetLayout,
-        0,
-        nullptr
-    };
-    VK_CHECK(vkCreatePipelineLayout(device, &pli, nullptr, &pipelineLayout));
-
-    VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    VkPipelineDynamicStateCreateInfo dyn{
-        VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        nullptr,
-        0,
-        2,
-        dynStates
-    };
-
-    VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
-    pci.stageCount = 2; pci.pStages = stages;
-    pci.pVertexInputState = &vi; pci.pInputAssemblyState = &ia;
-    pci.pViewportState = &vp; pci.pRasterizationState = &rs;
-    pci.pMultisampleState = &ms; pci.pColorBlendState = &cb;
-    pci.pDynamicState = &dyn; pci.layout = pipelineLayout;
-    pci.renderPass = getEngine()->getRenderPass();
-    pci.subpass = 0;
-    pci.pDepthStencilState = nullptr; // disable depth
-
-    VK_CHECK(vkCreateGraphicsPipelines(
-        device,
-        VK_NULL_HANDLE,
-        1,
-        &pci,
-        nullptr,
-        &graphicsPipeline
-    ));
-
-    vkDestroyShaderModule(device, vs, nullptr);
-    vkDestroyShaderModule(device, fs, nullptr);
+void DefaultShaderLayer::setupUniforms(Pass& pass) {
+    PipelineStore& store = getEngine()->getPipelineStore();
+    pass.generation = pass.program->generation;
+
+    const ShaderReflection& refl = pass.program->reflection;
+    const ShaderReflection::Binding* ubo = refl.findBinding(0, 0);
+
+    if (refl.pushConstants.size > 0) {
+        pass.uniformSource = UniformSource::PushConstants;
+        pass.uniformMembers = &refl.pushConstants.members;
+        pass.uniformBlock.assign((refl.pushConstants.size + 3u) & ~3u, 0);
+    } else if (ubo && ubo->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+        // the ring's descriptor set is only compatible when set 0 holds nothing but the block
+        // not fatal, a hot reload can land here and the next save may fix it
+        const char* problem = nullptr;
+        if (pass.program->setLayouts[0] != store.getDefaultSetLayout()) problem = "set 0 may only hold the uniform block, move other resources to set 1+";
+        else if (ubo->blockSize > UniformRing::MAX_BLOCK_SIZE) problem = "uniform block larger than the uniform ring allows";
+
+        if (problem) {
+            printf("[%s] %s: %s\n", getName().c_str(), pass.desc.fragPath.c_str(), problem);
+            pass.uniformSource = UniformSource::Unsupported;
+            pass.uniformMembers = nullptr;
+            pass.uniformBlock.clear();
+            return;
+        }
+
+        pass.uniformSource = UniformSource::Ring;
+        pass.uniformMembers = &ubo->members;
+        pass.uniformBlock.assign(ubo->blockSize, 0);
+    } else {
+        pass.uniformSource = UniformSource::None;
+        pass.uniformMembers = nullptr;
+        pass.uniformBlock.clear();
+    }
+
+    // the channels this pass samples have to exist, unwritten descriptors aren't something to find out on the gpu
+    for (const auto& binding : refl.bindings) {
+        if (binding.set != 1 || feedback.empty()) continue;
+        if (binding.type != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || binding.binding >= feedback.size()) {
+            printf("[%s] %s: set 1 binding %u is not a feedback buffer, the layer only has %zu\n",
+                   getName().c_str(), pass.desc.fragPath.c_str(), binding.binding, feedback.size());
+            pass.uniformSource = UniformSource::Unsupported;
+            return;
+        }
+    }
+}
+
+bool DefaultShaderLayer::setUniform(const std::string& member, const void* data, size_t size) {
+    syncProgram(mainPass);
+    bool found = writeUniform(mainPass, member, data, size);
+    for (auto& target : feedback) {
+        syncProgram(target.pass);
+        found |= writeUniform(target.pass, member, data, size);
+    }
+    return found;
+}
+
+bool DefaultShaderLayer::writeUniform(Pass& pass, const std::string& member, const void* data, size_t size) {
+    if (!pass.uniformMembers) return false;
+
+    for (const auto& m : *pass.uniformMembers) {
+        if (m.name != member) continue;
+        if (m.offset >= pass.uniformBlock.size()) return false;
+
+        // a shader declaring the member smaller than we send it (vec2 vs vec3) just gets the leading components
+        const size_t count = std::min({ size, static_cast<size_t>(m.size), pass.uniformBlock.size() - m.offset });
+        memcpy(pass.uniformBlock.data() + m.offset, data, count);
+        return true;
+    }
+    return false;
+}
+
+void DefaultShaderLayer::onSimulate(double step, double time) {
+    simulatedTime += step;
+    shaderClock.publish(simulatedTime, time);
 }
 
 void DefaultShaderLayer::updateUniforms() {
-    if (!mappedData) return;
     auto size = getEngine()->getViewport().getLogicalSize();
-    UniformBufferObject ubo{ {std::max(1.0f, size.x), std::max(1.0f, size.y)}, totalTime, 0.0f };
-    memcpy(mappedData, &ubo, sizeof(ubo));
-}
\ No newline at end of file
+
+    // shadertoy convention, z is the pixel aspect ratio
+    const float resolution[3] = { std::max(1.0f, size.x), std::max(1.0f, size.y), 1.0f };
+    setUniform("iResolution", resolution, sizeof(resolution));
+    setUniform("iTime", &totalTime, sizeof(totalTime));
+    setUniform("iFrame", &frameIndex, sizeof(frameIndex));
+
+    if (dynamicResolution) {
+        const float scaledResolution[3] = { static_cast<float>(scaledExtent.width), static_cast<float>(scaledExtent.height), 1.0f };
+        writeUniform(mainPass, "iResolution", scaledResolution, sizeof(scaledResolution));
+    }
+
+    // buffers draw at their own size
+    for (auto& target : feedback) {
+        const VkExtent2D extent = feedbackExtent(target.config);
+        const float bufferResolution[3] = { static_cast<float>(extent.width), static_cast<float>(extent.height), 1.0f };
+        writeUniform(target.pass, "iResolution", bufferResolution, sizeof(bufferResolution));
+    }
+}
+
+VkExtent2D DefaultShaderLayer::feedbackExtent(const FeedbackBuffer& config) const {
+    if (config.width && config.height) return { config.width, config.height };
+
+    const VkExtent2D render = getEngine()->getRenderExtent();
+    return { std::max(1u, static_cast<uint32_t>(std::lround(render.width * config.scale))),
+             std::max(1u, static_cast<uint32_t>(std::lround(render.height * config.scale))) };
+}
+
+void DefaultShaderLayer::resizeFeedbackTarget(FeedbackTarget& target, VkExtent2D extent, uint32_t last) {
+    GpuAllocator& allocator = getEngine()->getAllocator();
+    const VkFormat format = target.config.format;
+
+    if (!target.images[0].image) {
+        VkFormatProperties formatProps;
+        vkGetPhysicalDeviceFormatProperties(getEngine()->getPhysicalDevice(), format, &formatProps);
+        const VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+        if ((formatProps.optimalTilingFeatures & needed) != needed)
+            throw std::runtime_error(getName() + ": feedback buffer format can't be rendered to and sampled on this device");
+
+        const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+        target.blitSupported = (formatProps.optimalTilingFeatures & blit) == blit;
+    }
+
+    // last frame's contents get scaled into the new history image, the rest of the old pair can go
+    FeedbackImage old = target.images[last];
+    destroyFeedbackImage(target.images[last ^ 1]);
+    if (old.image && target.blitSupported) {
+        target.retiring = old;
+        target.retiringExtent = target.extent;
+    } else {
+        destroyFeedbackImage(old);
+    }
+
+    for (auto& image : target.images) {
+        image = {};
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = format;
+        imageInfo.extent = { extent.width, extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                          VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        allocator.createImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image.image, image.memory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device, &viewInfo, nullptr, &image.view) != VK_SUCCESS)
+            throw std::runtime_error(getName() + ": feedback buffer view creation failed");
+    }
+
+    target.extent = extent;
+    target.seedHistory = true;
+    printf("[%s] feedback buffer %ux%u\n", getName().c_str(), extent.width, extent.height);
+}
+
+void DefaultShaderLayer::seedHistory(RenderGraph& graph, FeedbackTarget& target, RenderGraph::Resource history) {
+    const VkImage dstImage = target.images[target.current ^ 1].image;
+
+    if (!target.retiring.image) {
+        // shadertoy buffers start out black
+        graph.addPass(getName() + " clear history",
+            [history](RenderGraph::PassBuilder& builder) { builder.write(history, RenderGraph::Access::TransferWrite); },
+            [dstImage](const RenderGraph::PassContext& ctx) {
+                VkClearColorValue black{};
+                VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+                vkCmdClearColorImage(ctx.cmd, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &black, 1, &range);
+            });
+        return;
+    }
+
+    const VkExtent2D srcExtent = target.retiringExtent;
+    const VkExtent2D dstExtent = target.extent;
+    const RenderGraph::Resource old = graph.importImage(getName() + " old history", target.retiring.image, target.retiring.view,
+                                                        target.config.format, srcExtent, &target.retiring.state);
+    graph.addPass(getName() + " resize history",
+        [old, history](RenderGraph::PassBuilder& builder) {
+            builder.read(old, RenderGraph::Access::TransferRead);
+            builder.write(history, RenderGraph::Access::TransferWrite);
+        },
+        [srcImage = target.retiring.image, dstImage, srcExtent, dstExtent](const RenderGraph::PassContext& ctx) {
+            VkImageBlit region{};
+            region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.srcOffsets[1] = { static_cast<int32_t>(srcExtent.width), static_cast<int32_t>(srcExtent.height), 1 };
+            region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.dstOffsets[1] = { static_cast<int32_t>(dstExtent.width), static_cast<int32_t>(dstExtent.height), 1 };
+            vkCmdBlitImage(ctx.cmd, srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+        });
+}
+
+void DefaultShaderLayer::destroyFeedbackImage(FeedbackImage& image) {
+    if (!image.image) return;
+
+    // an earlier frame may still be drawing into or sampling it
+    getEngine()->getRenderGraph().forgetImageView(image.view);
+    getEngine()->retire([device = device, &allocator = getEngine()->getAllocator(),
+                         img = image.image, view = image.view, memory = image.memory]() {
+        vkDestroyImageView(device, view, nullptr);
+        allocator.destroyImage(img, memory);
+    });
+    image = {};
+}
+
+VkDescriptorSet DefaultShaderLayer::writeChannelSet(RenderGraph& graph, const Pass& pass,
+                                                    const std::vector<RenderGraph::Resource>& channels) {
+    if (!pass.program || pass.program->setLayouts.size() < 2 || !pass.program->setLayouts[1]) return VK_NULL_HANDLE;
+
+    VkDescriptorSet set = graph.allocateSet(pass.program->setLayouts[1]);
+
+    std::vector<VkDescriptorImageInfo> infos;
+    infos.reserve(channels.size());
+    std::vector<VkWriteDescriptorSet> writes;
+    for (const auto& binding : pass.program->reflection.bindings) {
+        if (binding.set != 1 || binding.binding >= channels.size()) continue;
+
+        infos.push_back({ graph.getLinearSampler(), graph.getImageView(channels[binding.binding]),
+                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = binding.binding;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &infos.back();
+        writes.push_back(write);
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    return set;
+}
@@ -0,0 +1,63 @@
+// copyright 2025 swaroop.
+
+#include <core/shader_pack.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/*
+ * vk_shader_pack
+ * bundles spir-v files into the pack the engine maps at startup, run by the build
+ *
+ * usage: vk_shader_pack <output> <root> <file.spv>...
+ *
+ * entries are named by their path relative to <root>, which is what ShaderProgramDesc paths look like
+ * (shader_repo/<demo>/shaders/<file>.spv when <root> is the source directory)
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: vk_shader_pack <output> <root> <file.spv>...\n";
+        return 1;
+    }
+
+    const std::string output = argv[1];
+    const fs::path root = fs::absolute(argv[2]);
+
+    std::vector<std::pair<std::string, std::vector<char>>> files;
+    for (int i = 3; i < argc; i++) {
+        const fs::path path = fs::absolute(argv[i]);
+
+        std::ifstream f(path, std::ios::ate | std::ios::binary);
+        if (!f.is_open()) {
+            std::cerr << "could not read " << path.generic_string() << "\n";
+            return 1;
+        }
+        std::vector<char> data(static_cast<size_t>(f.tellg()));
+        f.seekg(0);
+        f.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+        files.emplace_back(path.lexically_relative(root).generic_string(), std::move(data));
+    }
+
+    // stable input order keeps the pack byte-identical between builds of the same shaders
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::string error;
+    if (!ShaderPack::write(output, files, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    size_t bytes = 0;
+    for (const auto& file : files) bytes += file.second.size();
+    printf("[shader pack] wrote %zu shaders (%zu bytes) to %s\n", files.size(), bytes, output.c_str());
+    return 0;
+}
@@ -0,0 +1,129 @@
+// copyright 2025 swaroop.
+
+#include <util/file_watcher.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+bool FileWatcher::start(std::vector<std::string> directories, Callback callback) {
+    stop();
+
+    dirs = std::move(directories);
+    onChange = std::move(callback);
+    if (dirs.empty()) return false;
+
+    running = true;
+    if (initInotify()) {
+        thread = std::thread(&FileWatcher::runInotify, this);
+    } else {
+        thread = std::thread(&FileWatcher::runPolling, this);
+    }
+    return true;
+}
+
+void FileWatcher::stop() {
+    if (!running.exchange(false)) return;
+    if (thread.joinable()) thread.join();
+
+#ifdef __linux__
+    if (inotifyFd >= 0) close(inotifyFd);
+#endif
+    inotifyFd = -1;
+    watchDirs.clear();
+}
+
+bool FileWatcher::initInotify() {
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) return false;
+
+    // close_write catches in-place saves, moved_to catches editors that write a temp file and rename it over
+    for (const auto& dir : dirs) {
+        const int wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd >= 0) watchDirs[wd] = dir;
+    }
+
+    if (watchDirs.empty()) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FileWatcher::runInotify() {
+#ifdef __linux__
+    std::vector<std::string> pending;
+    alignas(inotify_event) char buffer[4096];
+
+    while (running) {
+        pollfd pfd{ inotifyFd, POLLIN, 0 };
+        const int ready = poll(&pfd, 1, pending.empty() ? 250 : QUIET_MS);
+
+        if (ready <= 0) {
+            // quiet window passed, hand over what piled up
+            if (!pending.empty()) {
+                onChange(pending);
+                pending.clear();
+            }
+            continue;
+        }
+
+        const ssize_t len = read(inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < len;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            auto dir = watchDirs.find(event->wd);
+            if (dir == watchDirs.end() || event->len == 0 || (event->mask & IN_ISDIR)) continue;
+
+            std::string path = dir->second + "/" + event->name;
+            if (std::find(pending.begin(), pending.end(), path) == pending.end()) pending.push_back(std::move(path));
+        }
+    }
+#endif
+}
+
+void FileWatcher::runPolling() {
+    namespace fs = std::filesystem;
+    std::unordered_map<std::string, fs::file_time_type> stamps;
+
+    auto scan = [&](std::vector<std::string>* changed) {
+        std::error_code ec;
+        for (const auto& dir : dirs) {
+            for (const auto& entry : fs::directory_iterator(dir, ec)) {
+                if (!entry.is_regular_file(ec)) continue;
+
+                const std::string path = entry.path().generic_string();
+                const auto stamp = entry.last_write_time(ec);
+                auto it = stamps.find(path);
+                if (it == stamps.end() || it->second != stamp) {
+                    if (changed) changed->push_back(path);
+                    stamps[path] = stamp;
+                }
+            }
+        }
+    };
+
+    // the first scan only records what is already there
+    scan(nullptr);
+
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+
+        std::vector<std::string> changed;
+        scan(&changed);
+        if (!changed.empty()) onChange(changed);
+    }
+}
@@ -0,0 +1,469 @@
+// copyright 2025 swaroop.
+
+#include <util/spirv_reflect.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+    // the handful of opcodes, decorations and enums the reflection looks at, values from the spir-v spec
+    enum Op : uint32_t {
+        OpName = 5,
+        OpMemberName = 6,
+        OpEntryPoint = 15,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstantTrue = 48,
+        OpSpecConstantFalse = 49,
+        OpSpecConstant = 50,
+        OpSpecConstantOp = 52,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpTypeAccelerationStructureKHR = 5341,
+
+        // integer operations an OpSpecConstantOp array length is evaluated through
+        OpSConvert = 114,
+        OpUConvert = 113,
+        OpSNegate = 126,
+        OpIAdd = 128,
+        OpISub = 130,
+        OpIMul = 132,
+        OpUDiv = 134,
+        OpSDiv = 135,
+        OpUMod = 137,
+        OpSRem = 138,
+        OpSMod = 139,
+        OpShiftRightLogical = 194,
+        OpShiftRightArithmetic = 195,
+        OpShiftLeftLogical = 196,
+        OpBitwiseOr = 197,
+        OpBitwiseXor = 198,
+        OpBitwiseAnd = 199,
+        OpNot = 200,
+    };
+
+    enum Decoration : uint32_t {
+        DecorationSpecId = 1,
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35,
+    };
+
+    enum StorageClass : uint32_t {
+        StorageUniformConstant = 0,
+        StorageUniform = 2,
+        StoragePushConstant = 9,
+        StorageStorageBuffer = 12,
+    };
+
+    constexpr uint32_t DIM_BUFFER = 5;
+    constexpr uint32_t DIM_SUBPASS_DATA = 6;
+
+    struct Id {
+        uint32_t opcode = 0;
+        std::vector<uint32_t> operands; // everything after the result id
+
+        std::string name;
+        std::vector<std::string> memberNames;
+        std::vector<uint32_t> memberOffsets;
+        std::vector<uint32_t> memberMatrixStrides;
+
+        bool hasSet = false, hasBinding = false, hasSpecId = false;
+        uint32_t set = 0, binding = 0, specId = 0;
+        uint32_t arrayStride = 0;
+        bool block = false, bufferBlock = false;
+    };
+
+    std::string readString(const uint32_t* words, size_t count) {
+        std::string s;
+        for (size_t i = 0; i < count; i++) {
+            for (int b = 0; b < 4; b++) {
+                const char c = static_cast<char>((words[i] >> (b * 8)) & 0xff);
+                if (c == '\0') return s;
+                s.push_back(c);
+            }
+        }
+        return s;
+    }
+
+    VkShaderStageFlags stageFromModel(uint32_t model) {
+        switch (model) {
+            case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+            case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+            default: return 0;
+        }
+    }
+
+    class Parser {
+    public:
+        std::unordered_map<uint32_t, Id> ids;
+
+        Id& at(uint32_t id) { return ids[id]; }
+
+        uint32_t typeSize(uint32_t typeId, uint32_t matrixStride = 0) {
+            Id& t = at(typeId);
+            switch (t.opcode) {
+                case OpTypeBool: return 4;
+                case OpTypeInt:
+                case OpTypeFloat: return t.operands[0] / 8;
+                case OpTypeVector: return t.operands[1] * typeSize(t.operands[0]);
+                case OpTypeMatrix:
+                    return t.operands[1] * (matrixStride ? matrixStride : typeSize(t.operands[0]));
+                case OpTypeArray: {
+                    const uint32_t length = arrayLength(t.operands[1]);
+                    return length * (t.arrayStride ? t.arrayStride : typeSize(t.operands[0], matrixStride));
+                }
+                case OpTypeRuntimeArray: return 0;
+                case OpTypeStruct: {
+                    uint32_t size = 0;
+                    for (size_t m = 0; m < t.operands.size(); m++) {
+                        const uint32_t offset = m < t.memberOffsets.size() ? t.memberOffsets[m] : 0;
+                        const uint32_t stride = m < t.memberMatrixStrides.size() ? t.memberMatrixStrides[m] : 0;
+                        size = std::max(size, offset + typeSize(t.operands[m], stride));
+                    }
+                    return size;
+                }
+                default: return 0;
+            }
+        }
+
+        // spec constants count at their default value, a length that can't be worked out here is treated as
+        // runtime sized (0) rather than failing the whole program
+        uint32_t arrayLength(uint32_t id) {
+            int64_t value = 0;
+            return evaluate(id, value, 0) && value > 0 ? static_cast<uint32_t>(value) : 0;
+        }
+
+        // 32-bit integer constants and the integer OpSpecConstantOp expressions built from them
+        bool evaluate(uint32_t id, int64_t& value, uint32_t depth) {
+            if (depth > 32) return false; // malformed module, a constant can't refer to itself
+            Id& c = at(id);
+            if (c.opcode == OpConstant || c.opcode == OpSpecConstant) {
+                if (c.operands.size() < 2) return false;
+                value = static_cast<int32_t>(c.operands[1]); // operands[0] is the result type
+                return true;
+            }
+            if (c.opcode != OpSpecConstantOp || c.operands.size() < 3) return false;
+
+            // [type, opcode, operand ids...]
+            const uint32_t op = c.operands[1];
+            int64_t a = 0, b = 0;
+            if (!evaluate(c.operands[2], a, depth + 1)) return false;
+            const bool unary = op == OpSConvert || op == OpUConvert || op == OpSNegate || op == OpNot;
+            if (!unary && (c.operands.size() < 4 || !evaluate(c.operands[3], b, depth + 1))) return false;
+
+            const auto ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+            switch (op) {
+                case OpSConvert:
+                case OpUConvert: value = a; break;
+                case OpSNegate: value = -a; break;
+                case OpNot: value = static_cast<int32_t>(~ua); break;
+                case OpIAdd: value = static_cast<int32_t>(ua + ub); break;
+                case OpISub: value = static_cast<int32_t>(ua - ub); break;
+                case OpIMul: value = static_cast<int32_t>(ua * ub); break;
+                case OpUDiv: if (!ub) return false; value = ua / ub; break;
+                case OpSDiv: if (!b) return false; value = a / b; break;
+                case OpUMod: if (!ub) return false; value = ua % ub; break;
+                case OpSRem: if (!b) return false; value = a % b; break;
+                case OpSMod: if (!b) return false; value = ((a % b) + b) % b; break;
+                case OpShiftRightLogical: value = ua >> (ub & 31); break;
+                case OpShiftRightArithmetic: value = static_cast<int32_t>(a) >> (ub & 31); break;
+                case OpShiftLeftLogical: value = static_cast<int32_t>(ua << (ub & 31)); break;
+                case OpBitwiseOr: value = static_cast<int32_t>(ua | ub); break;
+                case OpBitwiseXor: value = static_cast<int32_t>(ua ^ ub); break;
+                case OpBitwiseAnd: value = static_cast<int32_t>(ua & ub); break;
+                default: return false;
+            }
+            return true;
+        }
+
+        std::vector<ShaderReflection::Member> members(uint32_t structId) {
+            Id& s = at(structId);
+            std::vector<ShaderReflection::Member> out;
+            for (size_t m = 0; m < s.operands.size(); m++) {
+                ShaderReflection::Member member;
+                member.name = m < s.memberNames.size() ? s.memberNames[m] : std::string();
+                member.offset = m < s.memberOffsets.size() ? s.memberOffsets[m] : 0;
+                member.size = typeSize(s.operands[m], m < s.memberMatrixStrides.size() ? s.memberMatrixStrides[m] : 0);
+                out.push_back(std::move(member));
+            }
+            return out;
+        }
+
+        // peels arrays off a variable's type, returns the element type and multiplies the descriptor count
+        uint32_t unwrapArrays(uint32_t typeId, uint32_t& count) {
+            while (true) {
+                Id& t = at(typeId);
+                if (t.opcode == OpTypeArray) {
+                    count *= arrayLength(t.operands[1]);
+                    typeId = t.operands[0];
+                } else if (t.opcode == OpTypeRuntimeArray) {
+                    count = 0; // bindless style, sized by whoever allocates the set
+                    typeId = t.operands[0];
+                } else {
+                    return typeId;
+                }
+            }
+        }
+    };
+
+    template <typename T>
+    void growTo(std::vector<T>& v, size_t index) {
+        if (v.size() <= index) v.resize(index + 1);
+    }
+}
+
+ShaderReflection ShaderReflection::fromSpirv(const uint32_t* code, size_t wordCount) {
+    if (wordCount < 5 || code[0] != SPIRV_MAGIC)
+        throw std::runtime_error("not a spir-v module");
+
+    Parser parser;
+    ShaderReflection out;
+    std::vector<uint32_t> variables;
+
+    for (size_t i = 5; i < wordCount;) {
+        const uint32_t opcode = code[i] & 0xffff;
+        const uint32_t length = code[i] >> 16;
+        if (length == 0 || i + length > wordCount)
+            throw std::runtime_error("truncated spir-v module");
+
+        const uint32_t* ops = code + i + 1;
+        const size_t opCount = length - 1;
+
+        switch (opcode) {
+            case OpName:
+                parser.at(ops[0]).name = readString(ops + 1, opCount - 1);
+                break;
+            case OpMemberName: {
+                Id& id = parser.at(ops[0]);
+                growTo(id.memberNames, ops[1]);
+                id.memberNames[ops[1]] = readString(ops + 2, opCount - 2);
+                break;
+            }
+            case OpEntryPoint:
+                out.stages |= stageFromModel(ops[0]);
+                break;
+            case OpDecorate: {
+                Id& id = parser.at(ops[0]);
+                const uint32_t value = opCount > 2 ? ops[2] : 0;
+                switch (ops[1]) {
+                    case DecorationSpecId: id.hasSpecId = true; id.specId = value; break;
+                    case DecorationBlock: id.block = true; break;
+                    case DecorationBufferBlock: id.bufferBlock = true; break;
+                    case DecorationArrayStride: id.arrayStride = value; break;
+                    case DecorationBinding: id.hasBinding = true; id.binding = value; break;
+                    case DecorationDescriptorSet: id.hasSet = true; id.set = value; break;
+                    default: break;
+                }
+                break;
+            }
+            case OpMemberDecorate: {
+                Id& id = parser.at(ops[0]);
+                const uint32_t member = ops[1];
+                const uint32_t value = opCount > 3 ? ops[3] : 0;
+                if (ops[2] == DecorationOffset) {
+                    growTo(id.memberOffsets, member);
+                    id.memberOffsets[member] = value;
+                } else if (ops[2] == DecorationMatrixStride) {
+                    growTo(id.memberMatrixStrides, member);
+                    id.memberMatrixStrides[member] = value;
+                }
+                break;
+            }
+            case OpTypeBool:
+            case OpTypeInt:
+            case OpTypeFloat:
+            case OpTypeVector:
+            case OpTypeMatrix:
+            case OpTypeImage:
+            case OpTypeSampler:
+            case OpTypeSampledImage:
+            case OpTypeArray:
+            case OpTypeRuntimeArray:
+            case OpTypeStruct:
+            case OpTypePointer:
+            case OpTypeAccelerationStructureKHR: {
+                // types: result id first
+                Id& id = parser.at(ops[0]);
+                id.opcode = opcode;
+                id.operands.assign(ops + 1, ops + opCount);
+                break;
+            }
+            case OpConstant:
+            case OpSpecConstant:
+            case OpSpecConstantTrue:
+            case OpSpecConstantFalse:
+            case OpSpecConstantOp:
+            case OpVariable: {
+                // values: result type first, then result id
+                if (opCount < 2) break;
+                Id& id = parser.at(ops[1]);
+                id.opcode = opcode;
+                id.operands.assign(ops, ops + opCount);
+                id.operands.erase(id.operands.begin() + 1); // keep [type, rest...]
+                if (opcode == OpVariable) variables.push_back(ops[1]);
+                break;
+            }
+            default:
+                break;
+        }
+
+        i += length;
+    }
+
+    for (uint32_t varId : variables) {
+        Id& var = parser.at(varId);
+        const uint32_t storage = var.operands[1];
+        if (storage != StorageUniformConstant && storage != StorageUniform &&
+            storage != StoragePushConstant && storage != StorageStorageBuffer) continue;
+
+        Id& pointer = parser.at(var.operands[0]);
+        if (pointer.opcode != OpTypePointer) continue;
+        const uint32_t pointeeId = pointer.operands[1];
+
+        if (storage == StoragePushConstant) {
+            out.pushConstants.stages = out.stages;
+            out.pushConstants.size = parser.typeSize(pointeeId);
+            out.pushConstants.members = parser.members(pointeeId);
+            continue;
+        }
+
+        Binding binding;
+        binding.set = var.set;
+        binding.binding = var.binding;
+        binding.stages = out.stages;
+        binding.name = var.name;
+
+        const uint32_t typeId = parser.unwrapArrays(pointeeId, binding.count);
+        Id& type = parser.at(typeId);
+        if (binding.name.empty()) binding.name = type.name;
+
+        switch (type.opcode) {
+            case OpTypeStruct:
+                if (storage == StorageStorageBuffer || type.bufferBlock) {
+                    binding.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                } else {
+                    binding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                }
+                binding.blockSize = parser.typeSize(typeId);
+                binding.members = parser.members(typeId);
+                break;
+            case OpTypeSampledImage:
+                binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                break;
+            case OpTypeSampler:
+                binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+                break;
+            case OpTypeImage: {
+                // operands: sampled type, dim, depth, arrayed, ms, sampled, format
+                const uint32_t dim = type.operands[1];
+                const bool storageImage = type.operands[5] == 2;
+                if (dim == DIM_SUBPASS_DATA) binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                else if (dim == DIM_BUFFER) binding.type = storageImage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                else binding.type = storageImage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                break;
+            }
+            default:
+                continue; // acceleration structures and anything newer, not used by any demo
+        }
+
+        out.bindings.push_back(std::move(binding));
+    }
+
+    for (auto& [idValue, id] : parser.ids) {
+        if (!id.hasSpecId) continue;
+        if (id.opcode != OpSpecConstant && id.opcode != OpSpecConstantTrue && id.opcode != OpSpecConstantFalse) continue;
+
+        SpecConstant spec;
+        spec.id = id.specId;
+        spec.name = id.name;
+        if (id.opcode == OpSpecConstant) {
+            spec.size = std::max(4u, parser.typeSize(id.operands[0]));
+            spec.defaultValue = id.operands.size() > 1 ? id.operands[1] : 0;
+        } else {
+            spec.defaultValue = id.opcode == OpSpecConstantTrue ? 1 : 0;
+        }
+        out.specConstants.push_back(std::move(spec));
+    }
+
+    std::sort(out.bindings.begin(), out.bindings.end(), [](const Binding& a, const Binding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    std::sort(out.specConstants.begin(), out.specConstants.end(), [](const SpecConstant& a, const SpecConstant& b) {
+        return a.id < b.id;
+    });
+    return out;
+}
+
+void ShaderReflection::merge(const ShaderReflection& other) {
+    stages |= other.stages;
+
+    for (const Binding& incoming : other.bindings) {
+        auto it = std::find_if(bindings.begin(), bindings.end(), [&](const Binding& b) {
+            return b.set == incoming.set && b.binding == incoming.binding;
+        });
+
+        if (it == bindings.end()) {
+            bindings.push_back(incoming);
+            continue;
+        }
+        if (it->type != incoming.type || it->count != incoming.count) {
+            throw std::runtime_error("shader stages disagree on set " + std::to_string(incoming.set) +
+                                     " binding " + std::to_string(incoming.binding));
+        }
+        it->stages |= incoming.stages;
+        it->blockSize = std::max(it->blockSize, incoming.blockSize);
+        if (it->members.size() < incoming.members.size()) it->members = incoming.members;
+    }
+
+    if (other.pushConstants.size > 0) {
+        pushConstants.stages |= other.pushConstants.stages;
+        if (other.pushConstants.size > pushConstants.size) {
+            pushConstants.size = other.pushConstants.size;
+            pushConstants.members = other.pushConstants.members;
+        }
+    }
+
+    for (const SpecConstant& spec : other.specConstants) {
+        const bool known = std::any_of(specConstants.begin(), specConstants.end(),
+                                       [&](const SpecConstant& s) { return s.id == spec.id; });
+        if (!known) specConstants.push_back(spec);
+    }
+
+    std::sort(bindings.begin(), bindings.end(), [](const Binding& a, const Binding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    std::sort(specConstants.begin(), specConstants.end(), [](const SpecConstant& a, const SpecConstant& b) {
+        return a.id < b.id;
+    });
+}
+
+const ShaderReflection::Binding* ShaderReflection::findBinding(uint32_t set, uint32_t binding) const {
+    for (const Binding& b : bindings) {
+        if (b.set == set && b.binding == binding) return &b;
+    }
+    return nullptr;
+}
@@ -9,6 +9,15 @@ void Viewport::init(SDL_Window* windowHandle) {
     updateFromWindow();
 }
 
+void Viewport::initHeadless(float width, float height) {
+    window = nullptr;
+    size = { width, height };
+    pixelSize = size;
+    logicalSize = size;
+    contentScale = { 1.0f, 1.0f };
+    state = Windowed;
+}
+
 void Viewport::onResize() {
     if (!window) return;
     